@@ -0,0 +1,151 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#include "Station.hpp"
+
+#include <kali-core/settingsTools.hpp>
+#include <kali-core/stateMachineEvents.hpp>
+
+#include <mvp-player-core/stateMachineEvents.hpp>
+#include <mvp-player-net/server/Server.hpp>
+
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <vector>
+
+namespace kaliscope
+{
+
+bool StationConfig::parse( const std::string & description )
+{
+    std::vector<std::string> fields;
+    boost::split( fields, description, boost::is_any_of( "," ) );
+    if ( fields.size() != 5 || fields[0].empty() || fields[3].empty() )
+    {
+        std::cerr << "OPERATION FAILED: bad station description: " << description << std::endl;
+        return true;
+    }
+    try
+    {
+        host = fields[0];
+        serverPort = fields[1].empty() ? mvpplayer::network::server::kDefaultServerPort : boost::lexical_cast<unsigned short>( fields[1] );
+        syncPort = fields[2].empty() ? kDefaultSyncPort : boost::lexical_cast<unsigned short>( fields[2] );
+        pipelineSettings = fields[3];
+        outputPrefix = fields[4];
+    }
+    catch( const boost::bad_lexical_cast & )
+    {
+        std::cerr << "OPERATION FAILED: bad station port: " << description << std::endl;
+        return true;
+    }
+    return false;
+}
+
+Station::Station( const StationConfig & config, FairThreadPool & pool )
+: _config( config )
+, _name( config.host + ":" + boost::lexical_cast<std::string>( config.serverPort ) )
+, _engine( &_videoPlayer )
+, _triggeredByLink( false )
+, _nbProcessedFrames( 0 )
+{
+    _engine.setProcessingPool( &pool, pool.addQueue() );
+    _engine.setFrameStepping( true );
+
+    _engine.signalFrameExposed.connect( [this]( const std::size_t nFrame, const DefaultImageT ) { frameExposed( nFrame ); } );
+    _engine.signalFrameReady.connect( [this]( const std::size_t nFrame, const DefaultImageT ) { frameReady( nFrame ); } );
+
+    // Frame triggers
+    _syncLink.signalMessage.connect(
+        [this]( const SyncMessage & message )
+        {
+            switch( message.action )
+            {
+                case eSyncActionNextFrame:
+                    _triggeredByLink = true;
+                    _engine.processNextFrame();
+                    break;
+                default:
+                    break;
+            }
+        }
+    );
+    // Kalisync versions without the sync link, there is no presenter here
+    _remote.signalEvent.connect(
+        [this]( mvpplayer::IEvent & event )
+        {
+            if ( dynamic_cast<mvpplayer::logic::EvNextTrack*>( &event ) )
+            {
+                _triggeredByLink = false;
+                _engine.processNextFrame();
+            }
+        }
+    );
+}
+
+Station::~Station()
+{
+    stop();
+    _engine.signalFrameExposed.disconnect_all_slots();
+    _engine.signalFrameReady.disconnect_all_slots();
+    _syncLink.signalMessage.disconnect_all_slots();
+    _remote.signalEvent.disconnect_all_slots();
+}
+
+void Station::start()
+{
+    mvpplayer::Settings settings;
+    settings.read( _config.pipelineSettings );
+
+    std::shared_ptr<tuttle::host::Graph> graph( new tuttle::host::Graph() );
+    setupGraphWithSettings( *graph, settings );
+    _engine.setProcessingGraph( graph );
+
+    _engine.setInputFilePath( settings.get<std::string>( "configPath", "inputFilePath" ) );
+    _engine.setIsInputSequence( settings.get<bool>( "configPath", "inputIsSequence", false ) );
+    _engine.setOutputFilePathPrefix( _config.outputPrefix );
+    _engine.setOutputFileExtension( settings.get<std::string>( "configPath", "outputExtension", ".dpx" ) );
+    _engine.setIsOutputSequence( true );
+
+    _remote.connect( _config.host, _config.serverPort );
+    if ( _syncLink.connect( _config.host, _config.syncPort ) )
+    {
+        std::cerr << "[" << _name << "] Sync link unavailable, frame events go thru the server." << std::endl;
+    }
+    _engine.start();
+    std::cout << "[" << _name << "] Capture started, output: " << _config.outputPrefix << std::endl;
+}
+
+void Station::stop()
+{
+    _engine.stop();
+    _syncLink.close();
+    _remote.disconnect();
+}
+
+void Station::frameExposed( const std::size_t )
+{
+    // The sensor is free, kalisync can advance the film (the reply to its trigger)
+    if ( !_triggeredByLink || _syncLink.reply( SyncMessage( eSyncActionFrameExposed ) ) )
+    {
+        mvpplayer::logic::EvCustomState event( kFrameExposedCustomStateAction );
+        _remote.sendEvent( event );
+    }
+}
+
+void Station::frameReady( const std::size_t nFrame )
+{
+    ++_nbProcessedFrames;
+    if ( !_triggeredByLink || _syncLink.send( SyncMessage( eSyncActionFrameCaptured ) ) )
+    {
+        mvpplayer::logic::EvCustomState event( kFrameCapturedCustomStateAction );
+        _remote.sendEvent( event );
+    }
+    // Nothing to display: the engine can capture the next frame
+    _engine.frameProcessed( nFrame );
+}
+
+}
@@ -0,0 +1,87 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#ifndef _KALI_STATION_HPP_
+#define	_KALI_STATION_HPP_
+
+#include <kali-core/FairThreadPool.hpp>
+#include <kali-core/KaliscopeEngine.hpp>
+#include <kali-core/SyncLink.hpp>
+#include <kali-core/VideoPlayer.hpp>
+
+#include <mvp-player-net/client/Client.hpp>
+
+#include <atomic>
+#include <string>
+
+namespace kaliscope
+{
+
+/**
+ * @brief configuration of a capture station
+ */
+struct StationConfig
+{
+    /**
+     * @brief parse "host,serverPort,syncPort,pipelineSettings,outputPrefix"
+     * @return false on success, true if error
+     */
+    bool parse( const std::string & description );
+
+    std::string host;                   ///< kalisync address
+    unsigned short serverPort = 0;      ///< kalisync server port (0: default port)
+    unsigned short syncPort = kDefaultSyncPort;     ///< kalisync sync link port
+    std::string pipelineSettings;       ///< Processing pipeline settings file (reader first)
+    std::string outputPrefix;           ///< Output path prefix of this station
+};
+
+/**
+ * @brief one kalisync station driven by the coordinator
+ * The station has its own engine, graph and connections. Frames are
+ * captured by the engine thread, then processed by the shared pool.
+ */
+class Station
+{
+public:
+    Station( const StationConfig & config, FairThreadPool & pool );
+    ~Station();
+
+    /**
+     * @brief build the graph, connect to kalisync and start capturing
+     */
+    void start();
+
+    /**
+     * @brief stop capturing and disconnect
+     */
+    void stop();
+
+    const std::string & name() const
+    { return _name; }
+
+    /**
+     * @brief number of processed frames
+     */
+    std::size_t nbProcessedFrames() const
+    { return _nbProcessedFrames; }
+
+private:
+    void frameExposed( const std::size_t nFrame );
+    void frameReady( const std::size_t nFrame );
+
+private:
+    StationConfig _config;
+    std::string _name;                                  ///< Station name (host:port)
+    VideoPlayer _videoPlayer;                           ///< Processing graph of the station
+    KaliscopeEngine _engine;                            ///< Capture thread of the station
+    mvpplayer::network::client::Client _remote;         ///< Control events
+    SyncLink _syncLink;                                 ///< Per frame events
+    std::atomic<bool> _triggeredByLink;                 ///< The last trigger came by the sync link, the replies go back by it
+    std::atomic<std::size_t> _nbProcessedFrames;        ///< Processed frames counter
+};
+
+}
+
+#endif
@@ -0,0 +1,154 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#include "Station.hpp"
+
+#include <kali-core/FairThreadPool.hpp>
+
+#include <tuttle/common/utils/global.hpp>
+#include <tuttle/host/Graph.hpp>
+
+#include <boost/log/core.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/log/expressions.hpp>
+#include <boost/program_options.hpp>
+#include <boost/format.hpp>
+#include <boost/exception/all.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace bpo = boost::program_options;
+
+static const char * kStationOptionString( "station" );
+static const char * kStationOptionMessage( "Capture station: host,serverPort,syncPort,pipelineSettings,outputPrefix (empty ports: default), repeat for each station" );
+static const char * kThreadsOptionString( "threads" );
+static const char * kThreadsOptionMessage( "Number of processing threads shared by the stations (0: one per core)" );
+static const char * kPluginsPathOptionString( "pluginsPath" );
+static const char * kPluginsPathOptionMessage( "OpenFX plugins directory" );
+static const char * kReportPeriodOptionString( "reportPeriod" );
+static const char * kReportPeriodOptionMessage( "Seconds between two throughput reports (0: none)" );
+
+static std::atomic<bool> stopRequested( false );
+
+void signal_interrupt_handler( const int )
+{
+    stopRequested = true;
+}
+
+void kalicoordinator_terminate( void )
+{
+    std::cerr << "[Kalicoordinator] Sorry, Kalicoordinator has encountered a fatal error." << std::endl;
+    std::cerr << "[Kalicoordinator] Please report this bug." << std::endl;
+    exit( -1 );
+}
+
+int main( int argc, char** argv )
+{
+    boost::log::core::get()->set_filter
+    (
+        boost::log::trivial::severity >= boost::log::trivial::info
+    );
+
+    std::set_terminate( &kalicoordinator_terminate );
+    // React to CTRL+C by stopping the stations
+    signal( SIGINT, signal_interrupt_handler );
+
+    try
+    {
+        // Declare the supported options.
+        bpo::options_description mainOptions( "Allowed options" );
+        mainOptions.add_options()
+            ( kStationOptionString, bpo::value< std::vector<std::string> >()->required(), kStationOptionMessage )
+            ( kThreadsOptionString, bpo::value<std::size_t>()->default_value( 0 ), kThreadsOptionMessage )
+            ( kPluginsPathOptionString, bpo::value<std::string>(), kPluginsPathOptionMessage )
+            ( kReportPeriodOptionString, bpo::value<int>()->default_value( 10 ), kReportPeriodOptionMessage );
+
+        //parse the command line, and put the result in vm
+        bpo::variables_map vm;
+        bpo::store( bpo::parse_command_line( argc, argv, mainOptions ), vm );
+
+        if ( argc == 1 )
+        {
+            std::cout << mainOptions << std::endl;
+            return 2;
+        }
+
+        bpo::notify( vm );
+
+        using namespace kaliscope;
+        std::vector<StationConfig> configs;
+        for( const std::string & description: vm[kStationOptionString].as< std::vector<std::string> >() )
+        {
+            StationConfig config;
+            if ( config.parse( description ) )
+            {
+                return 2;
+            }
+            configs.push_back( config );
+        }
+
+        using namespace tuttle::host;
+        tuttle::common::Formatter::get();
+        if ( vm.count( kPluginsPathOptionString ) )
+        {
+            core().getPluginCache().addDirectoryToPath( vm[kPluginsPathOptionString].as<std::string>() );
+        }
+        core().preload();
+
+        // Processing is shared, capture is per station
+        FairThreadPool pool( vm[kThreadsOptionString].as<std::size_t>() );
+        std::vector< std::unique_ptr<Station> > stations;
+        for( const StationConfig & config: configs )
+        {
+            stations.emplace_back( new Station( config, pool ) );
+            stations.back()->start();
+        }
+        std::cout << "[Kalicoordinator] " << stations.size() << " stations started." << std::endl;
+
+        const int reportPeriod = vm[kReportPeriodOptionString].as<int>();
+        std::size_t previousTotal = 0;
+        auto lastReport = std::chrono::steady_clock::now();
+        while( !stopRequested )
+        {
+            std::this_thread::sleep_for( std::chrono::milliseconds( 200 ) );
+            const auto now = std::chrono::steady_clock::now();
+            if ( reportPeriod > 0 && now - lastReport >= std::chrono::seconds( reportPeriod ) )
+            {
+                const double seconds = std::chrono::duration<double>( now - lastReport ).count();
+                std::size_t total = 0;
+                for( const std::unique_ptr<Station> & station: stations )
+                {
+                    std::cout << boost::format( "[%1%] %2% frames\n" ) % station->name() % station->nbProcessedFrames();
+                    total += station->nbProcessedFrames();
+                }
+                std::cout << boost::format( "[Kalicoordinator] %.1f frames per second, %d frames queued or processing\n" ) % ( ( total - previousTotal ) / seconds ) % pool.nbPending() << std::flush;
+                previousTotal = total;
+                lastReport = now;
+            }
+        }
+
+        std::cout << "[Kalicoordinator] Stopping..." << std::endl;
+        for( const std::unique_ptr<Station> & station: stations )
+        {
+            station->stop();
+        }
+        // The pool tasks use the stations
+        pool.stop();
+        stations.clear();
+    }
+    catch( ... )
+    {
+        std::cerr << "[Kalicoordinator] Exception ... : main of Kalicoordinator." << std::endl;
+        std::cerr << boost::current_exception_diagnostic_information() << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
@@ -9,6 +9,8 @@
 
 #include <QtWidgets/QApplication>
 #include <QtWidgets/QFileDialog>
+#include <QtWidgets/QMenu>
+#include <QtWidgets/QMenuBar>
 #include <QtWidgets/QMessageBox>
 #include <QtGui/QDropEvent>
 #include <QtGui/QDragLeaveEvent>
@@ -39,6 +41,11 @@ KaliscopeWin::KaliscopeWin()
     connect( widget.btnSettings, SIGNAL( released() ), this, SLOT( editSettings() ) );
     connect( widget.cbInvertColors, SIGNAL( toggled(bool) ), this, SLOT( invertDisplayColors( const bool ) ) );
     connect( widget.action_About, SIGNAL( triggered() ), this, SLOT( showAbout() ) );
+
+    QMenu *menuTools = new QMenu( tr( "&Tools" ), widget.menubar );
+    widget.menubar->insertMenu( widget.menu_About->menuAction(), menuTools );
+    QAction *actionFlatField = menuTools->addAction( tr( "&Flat field calibration" ) );
+    connect( actionFlatField, SIGNAL( triggered() ), this, SLOT( calibrateFlatField() ) );
 }
 
 KaliscopeWin::~KaliscopeWin()
@@ -187,6 +194,11 @@ void KaliscopeWin::editSettings()
     signalViewHitEditSettings();
 }
 
+void KaliscopeWin::calibrateFlatField()
+{
+    signalViewCalibrateFlatField();
+}
+
 void KaliscopeWin::dragEnterEvent( QDragEnterEvent *event )
 {
     event->acceptProposedAction();
@@ -100,6 +100,7 @@ protected Q_SLOTS:
     void changeVolume( const int volume );
     void invertDisplayColors( const bool );
     void editSettings();
+    void calibrateFlatField();
     void startStopServer( const bool start = true );
     void playPlaylistItemAtIndex( const int playlistIndex );
     void slotViewHitPlayStopBtn();
@@ -120,6 +121,7 @@ protected Q_SLOTS:
 public:
     boost::signals2::signal<void()> signalViewConnect;      ///< Signal connect
     boost::signals2::signal<void()> signalViewDisconnect;   ///< Signal disconnect
+    boost::signals2::signal<void()> signalViewCalibrateFlatField;   ///< Signal flat field calibration
 
 protected:
     std::size_t _currentTrackLength = 0;
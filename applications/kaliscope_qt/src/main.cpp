@@ -7,6 +7,9 @@
 
 #include "settings/RecordingSettingsDialog.hpp"
 #include <kali-core/stateMachineEvents.hpp>
+#include <kali-core/LatencyTracer.hpp>
+#include <kali-core/FlatFieldCalibration.hpp>
+#include <kali-core/SyncLink.hpp>
 
 #include <kali-core/VideoPlayer.hpp>
 #include <kali-core/KaliscopeEngine.hpp>
@@ -39,6 +42,8 @@
 #include <QtWidgets/QStyleFactory>
 #include <QtCore/QCoreApplication>
 
+#include <atomic>
+
 // Change your GUI here (qt)
 namespace gui = kaliscope::gui::qt;
 using Dialog = gui::KaliscopeWin;
@@ -120,6 +125,13 @@ int main( int argc, char **argv )
 
     // Network remote for synchronization (raspberry pi for example)
     mvpplayer::network::client::Client remote;
+    // Per frame synchronization events (binary, next to the remote)
+    kaliscope::SyncLink syncLink;
+    // The frame replies go back the way the trigger came
+    std::atomic<bool> triggeredByLink( false );
+
+    // Flat field calibration (frames captured while kalisync projects a uniform field)
+    kaliscope::FlatFieldCalibration flatField;
 
     // Presenter (presenter: logic-glu between model and view)
     mvpplayer::logic::MVPPlayerPresenter presenter;
@@ -144,12 +156,62 @@ int main( int argc, char **argv )
         // Settings editor binding
         dlg.signalViewHitEditSettings.connect( boost::bind( &editSettings, &dlg, boost::ref( playerEngine ), boost::ref( dlg ), boost::ref( presenter ) ) );
 
+        // Trace the frame triggers received from kalisync, before they get processed
+        const std::string latencyReport = mvpplayer::Settings::getInstance().get<std::string>( "latency", "reportPath", "" );
+        remote.signalEvent.connect(
+            [&triggeredByLink, &flatField]( mvpplayer::IEvent & event )
+            {
+                kaliscope::LatencyTracer & tracer = kaliscope::LatencyTracer::getInstance();
+                if ( dynamic_cast<mvpplayer::logic::EvNextTrack*>( &event ) )
+                {
+                    triggeredByLink = false;
+                    tracer.beginRemote();
+                    tracer.stamp( kaliscope::eSyncHopTriggerReceived );
+                }
+                else if ( dynamic_cast<kaliscope::logic::EvSyncTrace*>( &event ) )
+                {
+                    tracer.setFrameId( dynamic_cast<kaliscope::logic::EvSyncTrace&>( event ).trace().frameId );
+                }
+                else if ( dynamic_cast<mvpplayer::logic::EvStop*>( &event ) )
+                {
+                    // The reel stopped: the next frames won't be of the uniform field
+                    flatField.cancel();
+                }
+            }
+        );
+        // Frame triggers from the sync link go to the presenter, like the ones of the server
+        // (a trigger sent again by kalisync is only signaled once)
+        syncLink.signalMessage.connect(
+            [&presenter, &triggeredByLink, &flatField]( const kaliscope::SyncMessage & message )
+            {
+                switch( message.action )
+                {
+                    case kaliscope::eSyncActionBye:
+                        // Kalisync went away, it won't light the field anymore
+                        flatField.cancel();
+                        break;
+                    case kaliscope::eSyncActionNextFrame:
+                    {
+                        kaliscope::LatencyTracer & tracer = kaliscope::LatencyTracer::getInstance();
+                        triggeredByLink = true;
+                        tracer.beginRemote();
+                        tracer.stamp( kaliscope::eSyncHopTriggerReceived );
+                        tracer.setFrameId( message.frameId );
+                        mvpplayer::logic::EvNextTrack event;
+                        presenter.processEvent( event );
+                        break;
+                    }
+                    default:
+                        break;
+                }
+            }
+        );
         // Transfer events received from the network to the presenter's state machine
         remote.signalEvent.connect( boost::bind( &mvpplayer::logic::MVPPlayerPresenter::processEvent, &presenter, _1 ) );
 
         // Network setup
         dlg.signalViewConnect.connect(
-            [&remote, &dlg]()
+            [&remote, &syncLink, &dlg]()
             {
                 static QString serverIP = "192.168.1.72";
                 bool ok = false;
@@ -157,20 +219,96 @@ int main( int argc, char **argv )
                 if ( ok )
                 {
                     remote.connect( serverIP.toStdString() );
+                    syncLink.connect( serverIP.toStdString(), mvpplayer::Settings::getInstance().get<int>( "sync", "port", kaliscope::kDefaultSyncPort ) );
                 }
             }
         );
         dlg.signalViewDisconnect.connect( boost::bind( &mvpplayer::network::client::Client::disconnect, &remote ) );
+        dlg.signalViewDisconnect.connect( boost::bind( &kaliscope::SyncLink::close, &syncLink ) );
+        dlg.signalViewDisconnect.connect( boost::bind( &kaliscope::FlatFieldCalibration::cancel, &flatField ) );
+
+        // Flat field calibration: kalisync lights a uniform field, we average the captured frames
+        dlg.signalViewCalibrateFlatField.connect(
+            [&remote, &dlg, &flatField]()
+            {
+                mvpplayer::Settings & settings = mvpplayer::Settings::getInstance();
+                bool ok = false;
+                const int nbFrames = QInputDialog::getInt( &dlg, QObject::tr("Flat field calibration"), QObject::tr("Remove the film, start the capture, then choose the number of frames to average:"), settings.get<int>( "flatField", "nbFrames", 16 ), 1, 1000, 1, &ok );
+                if ( !ok )
+                {
+                    return;
+                }
+                const QString gainMapPath = QFileDialog::getSaveFileName( &dlg, QObject::tr("Flat field gain map"), QString::fromStdString( settings.get<std::string>( "flatField", "gainMapPath", QDir::homePath().toStdString() + "/flatField.gain" ) ) );
+                if ( gainMapPath.isEmpty() )
+                {
+                    return;
+                }
+                settings.set( "flatField", "nbFrames", nbFrames );
+                settings.set( "flatField", "gainMapPath", gainMapPath.toStdString() );
+                flatField.start( nbFrames, gainMapPath.toStdString() );
+                mvpplayer::logic::EvCustomState event( kaliscope::kFlatFieldStartCustomStateAction );
+                remote.sendEvent( event );
+            }
+        );
+
+        // A calibration doesn't survive the end of the capture (stop hit here, forwarded to kalisync)
+        presenter.signalEvent.connect(
+            [&flatField]( mvpplayer::IEvent & event )
+            {
+                if ( dynamic_cast<mvpplayer::logic::EvStop*>( &event ) )
+                {
+                    flatField.cancel();
+                }
+            }
+        );
 
         // Bind 'frame ready' signal to display function
         playerEngine.signalFrameReady.connect( boost::bind( &Dialog::displayFrame, &dlg, _1, _2 ) );
+        // Used to signalize that the sensor is free (the motor can advance while we process the frame)
+        playerEngine.signalFrameExposed.connect(
+            [&remote, &syncLink, &flatField, &triggeredByLink]( const std::size_t, const kaliscope::DefaultImageT captured )
+            {
+                kaliscope::LatencyTracer & tracer = kaliscope::LatencyTracer::getInstance();
+                using EventT = mvpplayer::logic::EvCustomState;
+                if ( flatField.isRunning() && flatField.addFrame( captured ) )
+                {
+                    // No exposure reply: kalisync would trigger another frame
+                    EventT stopEvent( kaliscope::kFlatFieldStopCustomStateAction );
+                    remote.sendEvent( stopEvent );
+                    return;
+                }
+                tracer.stamp( kaliscope::eSyncHopExposureSent );
+                // The reply to the trigger
+                if ( triggeredByLink && !syncLink.reply( kaliscope::SyncMessage( kaliscope::eSyncActionFrameExposed ) ) )
+                {
+                    return;
+                }
+                EventT event( kaliscope::kFrameExposedCustomStateAction );
+                remote.sendEvent( event );
+            }
+        );
         // Used to signalize that a frame has been processed
         playerEngine.signalFrameReady.connect(
-            [&remote]( const std::size_t, const kaliscope::DefaultImageT )
+            [&remote, &syncLink, &triggeredByLink, latencyReport]( const std::size_t, const kaliscope::DefaultImageT )
             {
+                kaliscope::LatencyTracer & tracer = kaliscope::LatencyTracer::getInstance();
                 using EventT = mvpplayer::logic::EvCustomState;
-                EventT event( kaliscope::kFrameCapturedCustomStateAction );
-                remote.sendEvent( event );
+                tracer.stamp( kaliscope::eSyncHopReplySent );
+                // Our timestamps go back to kalisync once they are all stamped
+                kaliscope::SyncMessage message( kaliscope::eSyncActionFrameCaptured );
+                tracer.oldest( message );
+                if ( !triggeredByLink || syncLink.send( message ) )
+                {
+                    EventT event( kaliscope::kFrameCapturedCustomStateAction );
+                    remote.sendEvent( event );
+                    kaliscope::logic::EvSyncTrace traceEvent( tracer.oldest() );
+                    remote.sendEvent( traceEvent );
+                }
+                tracer.complete();
+                if ( !latencyReport.empty() && tracer.nbCompleted() % kaliscope::kLatencyReportPeriod == 0 )
+                {
+                    tracer.writeReport( latencyReport );
+                }
             }
         );
         dlg.viewer()->signalFrameDone.connect( boost::bind( &kaliscope::KaliscopeEngine::frameProcessed, &playerEngine, _1 ) );
@@ -196,8 +334,12 @@ int main( int argc, char **argv )
     // the following needs to be reviewed, it seems that boost::trackable has no effect on Qt objects
     dlg.viewer()->signalFrameDone.disconnect_all_slots();
     playerEngine.signalFrameReady.disconnect_all_slots();
+    playerEngine.signalFrameExposed.disconnect_all_slots();
+    dlg.signalViewCalibrateFlatField.disconnect_all_slots();
     presenter.signalEvent.disconnect_all_slots();
     remote.signalEvent.disconnect_all_slots();
+    syncLink.signalMessage.disconnect_all_slots();
+    syncLink.close();
     app.processEvents();
     // Unload plugins
     mvpplayer::plugins::PluginLoader::getInstance().unloadPlugins();
@@ -0,0 +1,95 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#include "EdgeDispatcher.hpp"
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <iostream>
+
+namespace kaliscope
+{
+
+EdgeDispatcher::EdgeDispatcher( const Handler & handler )
+: _handler( handler )
+{
+    _wakeFd = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+    if ( _wakeFd < 0 )
+    {
+        std::cerr << "OPERATION FAILED: Unable to create the edge dispatcher event." << std::endl;
+        return;
+    }
+    _thread.reset( new std::thread( &EdgeDispatcher::worker, this ) );
+}
+
+EdgeDispatcher::~EdgeDispatcher()
+{
+    stop();
+}
+
+bool EdgeDispatcher::post( const TimePoint & edgeTime )
+{
+    if ( !_edges.push( edgeTime ) )
+    {
+        ++_nbDropped;
+        return false;
+    }
+    // One non blocking syscall, the dispatcher may be sleeping
+    const std::uint64_t one = 1;
+    return write( _wakeFd, &one, sizeof( one ) ) == sizeof( one );
+}
+
+void EdgeDispatcher::stop()
+{
+    _stop = true;
+    if ( _thread )
+    {
+        const std::uint64_t one = 1;
+        if ( write( _wakeFd, &one, sizeof( one ) ) < 0 )
+        {
+            std::cerr << "OPERATION FAILED: Unable to wake the edge dispatcher up." << std::endl;
+        }
+        _thread->join();
+        _thread.reset();
+    }
+    if ( _wakeFd >= 0 )
+    {
+        close( _wakeFd );
+        _wakeFd = -1;
+    }
+}
+
+void EdgeDispatcher::worker()
+{
+    pollfd fds;
+    fds.fd = _wakeFd;
+    fds.events = POLLIN;
+    while( !_stop )
+    {
+        fds.revents = 0;
+        if ( poll( &fds, 1, -1 ) < 0 )
+        {
+            if ( errno == EINTR )
+            { continue; }
+            break;
+        }
+        std::uint64_t count = 0;
+        if ( read( _wakeFd, &count, sizeof( count ) ) < 0 && errno != EAGAIN )
+        {
+            break;
+        }
+        TimePoint edgeTime;
+        while( !_stop && _edges.pop( edgeTime ) )
+        {
+            _handler( edgeTime );
+        }
+    }
+}
+
+}
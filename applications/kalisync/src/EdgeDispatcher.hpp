@@ -0,0 +1,77 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#ifndef _KALI_EDGEDISPATCHER_HPP_
+#define	_KALI_EDGEDISPATCHER_HPP_
+
+#include <kali-core/SpscQueue.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+
+namespace kaliscope
+{
+
+/// Maximum number of edges waiting for the network
+static const std::size_t kMaxPendingEdges( 16 );
+
+/**
+ * @brief hands the GPIO edges over to a normal thread
+ * The GPIO thread drives the motor and the flash then posts the edge: the
+ * trace and the network messages (serialization, allocations, locks) are
+ * done by the dispatcher thread, so they can't delay the next edge.
+ */
+class EdgeDispatcher
+{
+public:
+    typedef std::chrono::steady_clock::time_point TimePoint;
+    typedef std::function<void( const TimePoint & edgeTime )> Handler;
+
+    /**
+     * @brief constructor, starts the dispatcher thread
+     * @param handler called by the dispatcher thread for each edge
+     */
+    EdgeDispatcher( const Handler & handler );
+    ~EdgeDispatcher();
+
+    /**
+     * @brief post an edge, real-time safe (no lock, no allocation)
+     * @param edgeTime time of the edge
+     * @return false if the edge was dropped (too many pending), true otherwise
+     */
+    bool post( const TimePoint & edgeTime );
+
+    /**
+     * @brief stop the dispatcher thread, pending edges are dropped
+     */
+    void stop();
+
+    /**
+     * @brief number of edges dropped because the dispatcher was late
+     */
+    inline std::size_t nbDropped() const
+    { return _nbDropped; }
+
+private:
+    /**
+     * @brief dispatcher loop
+     */
+    void worker();
+
+private:
+    Handler _handler;                                       ///< Network work of an edge
+    SpscQueue<TimePoint, kMaxPendingEdges> _edges;          ///< Edges posted by the GPIO thread
+    int _wakeFd = -1;                                       ///< Event file descriptor waking the dispatcher up
+    std::atomic<bool> _stop{ false };                       ///< Stops the dispatcher thread
+    std::atomic<std::size_t> _nbDropped{ 0 };               ///< Edges dropped
+    std::unique_ptr<std::thread> _thread;                   ///< Dispatcher thread
+};
+
+}
+
+#endif
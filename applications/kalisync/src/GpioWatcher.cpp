@@ -10,6 +10,13 @@
 #include <boost/format.hpp>
 #include <chrono>
 
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
 #include <fstream>
 #include <string>
 #include <iostream>
@@ -18,13 +25,36 @@
 namespace kaliscope
 {
 
+namespace
+{
+
+/**
+ * @brief read a gpio value file from its beginning (needed by sysfs after each edge)
+ * @param val[out] output value, inverted (inputs are pulled up)
+ * @return false if failure, true otherwise
+ */
+bool readGpioValue( const int fd, bool & val )
+{
+    char c = '0';
+    if ( pread( fd, &c, 1, 0 ) != 1 )
+    {
+        return false;
+    }
+    val = ( c == '0' );
+    return true;
+}
+
+}
+
 /**
  * @brief constructor
  * @param numPin pin number
  * @param microsecDelay wait delay if -1, no watching thread will be started
+ * @param sysfsPath sysfs gpio directory
  */
-GpioWatcher::GpioWatcher( const std::size_t pinId, const int microsecDelay )
-: _gpioId( pinId )
+GpioWatcher::GpioWatcher( const std::size_t pinId, const int microsecDelay, const std::string & sysfsPath )
+: IGpio( pinId )
+, _sysfsPath( sysfsPath )
 {
     if ( microsecDelay >= 0 )
     {
@@ -45,7 +75,7 @@ void GpioWatcher::toggleValue()
 
 bool GpioWatcher::exportGpio()
 {
-    static const std::string exportStr( "/sys/class/gpio/export" );
+    const std::string exportStr( _sysfsPath + "/export" );
     // Open "export" file. Convert C++ string to C string. Required for all Linux pathnames
     std::ofstream exportgpio( exportStr.c_str() );
     if ( !exportgpio.good() )
@@ -58,12 +88,15 @@ bool GpioWatcher::exportGpio()
     exportgpio << _gpioId ;
     // close export file
     exportgpio.close();
+    // If the value file is not there yet, it will be opened on first use
+    openValue();
     return true;
 }
 
 bool GpioWatcher::unexportGpio()
 {
-    static const std::string unexportStr( "/sys/class/gpio/unexport" );
+    closeValue();
+    const std::string unexportStr( _sysfsPath + "/unexport" );
     std::ofstream unexportgpio( unexportStr.c_str() ); //Open unexport file
     if ( !unexportgpio.good() )
     {
@@ -80,7 +113,7 @@ bool GpioWatcher::unexportGpio()
 
 bool GpioWatcher::setDirGpio( const std::string & dir )
 {
-    const std::string setdirStr = ( boost::format( "/sys/class/gpio/gpio%1%/direction" ) % _gpioId ).str();
+    const std::string setdirStr = ( boost::format( "%1%/gpio%2%/direction" ) % _sysfsPath % _gpioId ).str();
     // open direction file for gpio
     std::ofstream setdirgpio( setdirStr.c_str() );
     if ( !setdirgpio.good() )
@@ -94,6 +127,21 @@ bool GpioWatcher::setDirGpio( const std::string & dir )
     return true;
 }
 
+bool GpioWatcher::setEdgeGpio( const std::string & edge )
+{
+    const std::string setEdgeStr = ( boost::format( "%1%/gpio%2%/edge" ) % _sysfsPath % _gpioId ).str();
+    std::ofstream setedgegpio( setEdgeStr.c_str() );
+    if ( !setedgegpio.good() )
+    {
+        return false;
+    }
+
+    setedgegpio << edge;
+    setedgegpio.close();
+    // The write error is only known once the file is flushed
+    return !setedgegpio.fail();
+}
+
 /**
  * @brief set gpio value
  * @param value true or false
@@ -101,20 +149,13 @@ bool GpioWatcher::setDirGpio( const std::string & dir )
  */
 bool GpioWatcher::setValGpio( const bool value )
 {
-    const std::string setValStr = ( boost::format( "/sys/class/gpio/gpio%1%/value" ) % _gpioId ).str();
-    std::ofstream setvalgpio( setValStr.c_str() ); // open value file for gpio
-
-    if ( !setvalgpio.good() )
+    // One syscall per toggle on the already open value file
+    if ( !openValue() || pwrite( _valueFd, value ? "1" : "0", 1, 0 ) != 1 )
     {
         std::cerr << "OPERATION FAILED: Unable to set the value of GPIO "<< _gpioId << "." << std::endl;
         return false;
     }
-
-    // write boolean value to value file
-    setvalgpio << value;
     _value = value;
-    // close value file
-    setvalgpio.close();
     return true;
 }
 
@@ -125,37 +166,102 @@ bool GpioWatcher::setValGpio( const bool value )
  */
 bool GpioWatcher::getValGpio( bool & val )
 {
-    const std::string getValStr = ( boost::format( "/sys/class/gpio/gpio%1%/value" ) % _gpioId ).str();
-    std::ifstream getvalgpio( getValStr.c_str() );// open value file for gpio
-    if ( !getvalgpio.good() )
+    if ( !openValue() || !readGpioValue( _valueFd, val ) )
     {
         std::cerr << "OPERATION FAILED: Unable to get value of GPIO " << _gpioId << "." << std::endl;
         return false;
     }
+    return true;
+}
 
-    // read gpio boolean value
-    getvalgpio >> val;
+bool GpioWatcher::openValue()
+{
+    if ( _valueFd >= 0 )
+    { return true; }
 
-    // Invert boolean value
-    val = !val;
+    const std::string valueStr = ( boost::format( "%1%/gpio%2%/value" ) % _sysfsPath % _gpioId ).str();
+    int fd = open( valueStr.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC );
+    if ( fd < 0 )
+    {
+        // Read only value files still allow watching
+        fd = open( valueStr.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC );
+    }
+    if ( fd < 0 )
+    { return false; }
 
-    // Close the value file
-    getvalgpio.close();
+    // Another thread may have opened it meanwhile
+    int closed = -1;
+    if ( !_valueFd.compare_exchange_strong( closed, fd ) )
+    {
+        close( fd );
+    }
     return true;
 }
 
+void GpioWatcher::closeValue()
+{
+    const int fd = _valueFd.exchange( -1 );
+    if ( fd >= 0 )
+    {
+        close( fd );
+    }
+}
+
 void GpioWatcher::worker()
 {
     if ( _stop )
     { return; }
+    if ( _realTime.enabled() )
+    {
+        setCurrentThreadRealTime( _realTime );
+    }
+    // Read once, the settings take a lock and allocate
+    const std::chrono::milliseconds nextEventDelay( mvpplayer::Settings::getInstance().get<int>( "gpio", "nextEventDelay" ) );
 
+    // The value file stays open, it is read again after each edge
     bool lastValue = false;
     _stop = !getValGpio( lastValue );
+    if ( _stop )
+    { return; }
+    _eventTime = std::chrono::steady_clock::now();
     signalGpioValueChanged( _gpioId, lastValue );
+    const int fd = _valueFd;
 
+    const bool edgeTriggered = setEdgeGpio( "both" );
+    if ( !edgeTriggered )
+    {
+        std::cerr << "GPIO " << _gpioId << " doesn't support edge detection, its value will be polled." << std::endl;
+    }
+
+    pollfd fds[2];
+    fds[0].fd = fd;
+    fds[0].events = POLLPRI | POLLERR;
+    fds[1].fd = _wakeFd;
+    fds[1].events = POLLIN;
     while( !_stop )
     {
-        std::this_thread::sleep_for( std::chrono::microseconds( _microsecDelay ) );
+        if ( edgeTriggered )
+        {
+            // Sleep until an edge arrives or stop() is called
+            fds[0].revents = 0;
+            fds[1].revents = 0;
+            if ( poll( fds, 2, -1 ) < 0 )
+            {
+                if ( errno == EINTR )
+                { continue; }
+                _stop = true;
+                break;
+            }
+            if ( fds[1].revents )
+            { break; }
+        }
+        else
+        {
+            std::this_thread::sleep_for( std::chrono::microseconds( _microsecDelay ) );
+        }
+        // Stamped before reading the value, as close to the edge as we can
+        _eventTime = std::chrono::steady_clock::now();
+
         bool gpioValue = false;
         if ( getValGpio( gpioValue ) )
         {
@@ -164,7 +270,7 @@ void GpioWatcher::worker()
                 signalGpioValueChanged( _gpioId, gpioValue );
                 lastValue = gpioValue;
                 // Avoid parasites
-                std::this_thread::sleep_for( std::chrono::milliseconds( mvpplayer::Settings::getInstance().get<int>( "gpio", "nextEventDelay" ) ) );
+                std::this_thread::sleep_for( nextEventDelay );
             }
         }
         else
@@ -180,9 +286,26 @@ void GpioWatcher::worker()
  */
 void GpioWatcher::startWatching( const std::size_t microsecDelay )
 {
+    if ( _watcherThread )
+    {
+        if ( !_stop )
+        {
+            // Already watching: a second thread would leak the wake fd and the first thread
+            return;
+        }
+        // The watcher gave up on a read error: start it again
+        _watcherThread->join();
+        _watcherThread.reset();
+    }
+    if ( _wakeFd >= 0 )
+    {
+        close( _wakeFd );
+        _wakeFd = -1;
+    }
     _microsecDelay = microsecDelay;
     exportGpio();
     setDirGpio( "in" );
+    _wakeFd = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
     _stop = false;
     _watcherThread.reset( new std::thread( &This::worker, this ) );
 }
@@ -193,7 +316,22 @@ void GpioWatcher::startWatching( const std::size_t microsecDelay )
 void GpioWatcher::stop()
 {
     _stop = true;
-    _watcherThread->join();
+    if ( _watcherThread )
+    {
+        // Wake the watcher up if it is waiting for an edge
+        const std::uint64_t one = 1;
+        if ( _wakeFd >= 0 && write( _wakeFd, &one, sizeof( one ) ) < 0 )
+        {
+            std::cerr << "OPERATION FAILED: Unable to wake the watcher of GPIO " << _gpioId << " up." << std::endl;
+        }
+        _watcherThread->join();
+        _watcherThread.reset();
+    }
+    if ( _wakeFd >= 0 )
+    {
+        close( _wakeFd );
+        _wakeFd = -1;
+    }
     unexportGpio();
 }
 
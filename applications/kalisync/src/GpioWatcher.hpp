@@ -6,8 +6,10 @@
 #ifndef _KALI_GPIOWATCHER_HPP_
 #define	_KALI_GPIOWATCHER_HPP_
 
-#include <boost/signals2.hpp>
+#include "IGpio.hpp"
 
+#include <atomic>
+#include <chrono>
 #include <string>
 #include <memory>
 #include <thread>
@@ -15,12 +17,19 @@
 namespace kaliscope
 {
 
+/// Sysfs directory of the gpio pins
+static const std::string kDefaultGpioSysfsPath( "/sys/class/gpio" );
+
 /**
  * @brief GPIO Watcher
  * Used to get IO from GPIO pins
  * tested on raspberry pi 2
+ *
+ * The watching thread sleeps until the kernel reports an edge on the pin
+ * (sysfs "edge" file + poll), it only falls back to reading the value
+ * periodically if the pin can't generate interrupts.
  */
-class GpioWatcher
+class GpioWatcher : public IGpio
 {
     typedef GpioWatcher This;
 public:
@@ -28,54 +37,57 @@ public:
      * @brief constructor
      * @param numPin pin number
      * @param microsecDelay wait delay if -1, no watching thread will be started
+     * @param sysfsPath sysfs gpio directory (export, unexport and the gpioN directories)
      */
-    GpioWatcher( const std::size_t numPin, const int microsecDelay = -1 );
+    GpioWatcher( const std::size_t numPin, const int microsecDelay = -1, const std::string & sysfsPath = kDefaultGpioSysfsPath );
 
     virtual ~GpioWatcher();
 
     /**
-     * @brief get the gpio pin id
-     * @return the pin id
+     * @brief start watching thread, does nothing if it is already watching
+     * @param microsecDelay microseconds delay between each reading, only used
+     *        if the pin doesn't support edge detection
      */
-    inline const std::size_t gpioId() const
-    { return _gpioId; }
-
-    /**
-     * @brief start watching thread
-     * @param microsecDelay microseconds delay between each reading
-     */
-    void startWatching( const std::size_t microsecDelay = 0 );
+    virtual void startWatching( const std::size_t microsecDelay = 0 );
 
     /**
      * @brief stop watching thread
      */
-    void stop();
+    virtual void stop();
 
     /**
-     * @brief export gpio for further use
+     * @brief export gpio for further use, the value file is opened once here
+     *        and kept open until unexportGpio
      * @return false if failure, true otherwise
      */
-    bool exportGpio();
+    virtual bool exportGpio();
 
     /**
      * @brief unexport (release) gpio
      * @return false if failure, true otherwise
      */
-    bool unexportGpio();
+    virtual bool unexportGpio();
 
     /**
      * @brief set gpio direction
      * @param dir[in] { out, in }
      * @return false if failure, true otherwise
      */
-    bool setDirGpio( const std::string & dir );
+    virtual bool setDirGpio( const std::string & dir );
+
+    /**
+     * @brief set the edges generating an interrupt (input pins)
+     * @param edge[in] { none, rising, falling, both }
+     * @return false if failure (the pin doesn't support interrupts), true otherwise
+     */
+    bool setEdgeGpio( const std::string & edge );
 
     /**
      * @brief set gpio value
      * @param value true or false
      * @return false if failure, true otherwise
      */
-    bool setValGpio( const bool value ); // Set GPIO Value (putput pins)
+    virtual bool setValGpio( const bool value ); // Set GPIO Value (putput pins)
 
     /**
      * @brief toggle gpio value
@@ -87,7 +99,7 @@ public:
      * @param val[out] output value
      * @return false if failure, true otherwise
      */
-    bool getValGpio( bool & val );
+    virtual bool getValGpio( bool & val );
 
 protected:
     /**
@@ -95,17 +107,25 @@ protected:
      */
     virtual void worker();
 
-/**
- * @brief signals
- */
-public:
-    boost::signals2::signal<void( const std::size_t pinNum, const bool value )> signalGpioValueChanged; ///< Signalize that the GPIO value has changed
+private:
+    /**
+     * @brief open the value file if it is not already open
+     * @return false if failure, true otherwise
+     */
+    bool openValue();
+
+    /**
+     * @brief close the value file
+     */
+    void closeValue();
 
 private:
+    const std::string _sysfsPath;   ///< Sysfs gpio directory
     bool _value = false;            ///< Value
-    const std::size_t _gpioId;      ///< GPIO number associated with the instance of an object
     std::unique_ptr<std::thread> _watcherThread;       ///< Watcher's thread
-    bool _stop = true;              ///< Stops watcher thread
+    std::atomic<bool> _stop{ true }; ///< Stops watcher thread
+    int _wakeFd = -1;               ///< Event file descriptor used to wake the watcher thread up on stop
+    std::atomic<int> _valueFd{ -1 }; ///< Value file descriptor, read and written at offset 0
     std::size_t _microsecDelay = 0; ///< microsec delay between each gpio operation
 };
 
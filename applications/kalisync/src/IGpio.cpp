@@ -0,0 +1,15 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#include "IGpio.hpp"
+
+namespace kaliscope
+{
+
+IGpio::~IGpio()
+{
+}
+
+}
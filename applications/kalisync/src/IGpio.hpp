@@ -0,0 +1,122 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#ifndef _KALI_IGPIO_HPP_
+#define	_KALI_IGPIO_HPP_
+
+#include "RealTime.hpp"
+
+#include <boost/signals2.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+namespace kaliscope
+{
+
+/**
+ * @brief a GPIO pin: real sysfs pin (GpioWatcher) or simulated one
+ */
+class IGpio
+{
+public:
+    /**
+     * @brief constructor
+     * @param gpioId[in] pin number
+     */
+    IGpio( const std::size_t gpioId )
+    : _gpioId( gpioId )
+    {}
+
+    virtual ~IGpio() = 0;
+
+    /**
+     * @brief get the gpio pin id
+     * @return the pin id
+     */
+    inline std::size_t gpioId() const
+    { return _gpioId; }
+
+    /**
+     * @brief start watching thread, signalGpioValueChanged is then emitted on changes
+     * @param microsecDelay microseconds delay between each reading, if the
+     *        value has to be polled
+     */
+    virtual void startWatching( const std::size_t microsecDelay = 0 ) = 0;
+
+    /**
+     * @brief stop watching thread
+     */
+    virtual void stop() = 0;
+
+    /**
+     * @brief export gpio for further use
+     * @return false if failure, true otherwise
+     */
+    virtual bool exportGpio() = 0;
+
+    /**
+     * @brief unexport (release) gpio
+     * @return false if failure, true otherwise
+     */
+    virtual bool unexportGpio() = 0;
+
+    /**
+     * @brief set gpio direction
+     * @param dir[in] { out, in }
+     * @return false if failure, true otherwise
+     */
+    virtual bool setDirGpio( const std::string & dir ) = 0;
+
+    /**
+     * @brief set gpio value (output pins)
+     * @param value true or false
+     * @return false if failure, true otherwise
+     */
+    virtual bool setValGpio( const bool value ) = 0;
+
+    /**
+     * @brief get gpio value
+     * @param val[out] output value
+     * @return false if failure, true otherwise
+     */
+    virtual bool getValGpio( bool & val ) = 0;
+
+    /**
+     * @brief set the scheduling of the watching thread, applied when it
+     *        starts: the value change slots then run in real time
+     */
+    inline void setRealTime( const RealTimeSettings & settings )
+    { _realTime = settings; }
+
+    /**
+     * @brief get the scheduling of the watching thread
+     */
+    inline const RealTimeSettings & realTime() const
+    { return _realTime; }
+
+    /**
+     * @brief time at which the watcher woke up for the last value change,
+     *        only meaningful in signalGpioValueChanged slots
+     */
+    inline std::chrono::steady_clock::time_point lastEventTime() const
+    { return _eventTime; }
+
+/**
+ * @brief signals
+ */
+public:
+    boost::signals2::signal<void( const std::size_t pinNum, const bool value )> signalGpioValueChanged; ///< Signalize that the GPIO value has changed
+
+protected:
+    const std::size_t _gpioId;      ///< GPIO number associated with the instance of an object
+    std::chrono::steady_clock::time_point _eventTime; ///< Wake up time of the last value change
+    RealTimeSettings _realTime;     ///< Scheduling of the watching thread
+};
+
+}
+
+#endif
@@ -0,0 +1,84 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#include "RealTime.hpp"
+
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+namespace kaliscope
+{
+
+namespace
+{
+
+/// Stack touched up front by the real-time threads
+static const std::size_t kPrefaultStackSize( 64 * 1024 );
+
+void prefaultStack()
+{
+    unsigned char stack[kPrefaultStackSize];
+    // Written through a volatile pointer, so that it isn't optimized out
+    volatile unsigned char * const pages = stack;
+    for( std::size_t i = 0; i < kPrefaultStackSize; i += 4096 )
+    {
+        pages[i] = 0;
+    }
+}
+
+}
+
+bool lockMemory()
+{
+    // Freed memory stays in the heap instead of going back to the system
+    mallopt( M_TRIM_THRESHOLD, -1 );
+    mallopt( M_MMAP_MAX, 0 );
+    if ( mlockall( MCL_CURRENT | MCL_FUTURE ) )
+    {
+        std::cerr << "OPERATION FAILED: Unable to lock the memory: " << std::strerror( errno ) << std::endl;
+        return false;
+    }
+    prefaultStack();
+    return true;
+}
+
+bool setCurrentThreadRealTime( const RealTimeSettings & settings )
+{
+    bool success = true;
+    if ( settings.cpu >= 0 )
+    {
+        cpu_set_t cpus;
+        CPU_ZERO( &cpus );
+        CPU_SET( settings.cpu, &cpus );
+        const int error = settings.cpu < CPU_SETSIZE ? pthread_setaffinity_np( pthread_self(), sizeof( cpus ), &cpus ) : EINVAL;
+        if ( error )
+        {
+            std::cerr << "OPERATION FAILED: Unable to pin the thread to cpu " << settings.cpu << ": " << std::strerror( error ) << std::endl;
+            success = false;
+        }
+    }
+    if ( settings.priority > 0 )
+    {
+        sched_param param;
+        std::memset( &param, 0, sizeof( param ) );
+        param.sched_priority = settings.priority;
+        const int error = pthread_setschedparam( pthread_self(), SCHED_FIFO, &param );
+        if ( error )
+        {
+            std::cerr << "OPERATION FAILED: Unable to set the real-time priority " << settings.priority << ": " << std::strerror( error ) << std::endl;
+            success = false;
+        }
+    }
+    prefaultStack();
+    return success;
+}
+
+}
@@ -0,0 +1,41 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#ifndef _KALI_REALTIME_HPP_
+#define	_KALI_REALTIME_HPP_
+
+namespace kaliscope
+{
+
+/**
+ * @brief scheduling of a real-time thread
+ */
+struct RealTimeSettings
+{
+    int priority = 0;               ///< SCHED_FIFO priority (1-99), 0 keeps the normal scheduling
+    int cpu = -1;                   ///< CPU the thread is pinned to (best isolated with isolcpus=), -1 for any
+
+    inline bool enabled() const
+    { return priority > 0 || cpu >= 0; }
+};
+
+/**
+ * @brief lock the current and future memory of the process in RAM and keep
+ *        the freed heap memory, so that real-time threads never page fault
+ * Needs root (or CAP_IPC_LOCK).
+ * @return false if failure, true otherwise
+ */
+bool lockMemory();
+
+/**
+ * @brief apply real-time settings to the calling thread, and touch its stack
+ * Needs root (or CAP_SYS_NICE).
+ * @return false if failure, true otherwise
+ */
+bool setCurrentThreadRealTime( const RealTimeSettings & settings );
+
+}
+
+#endif
@@ -3,11 +3,16 @@
  * https://github.com/edubois/kaliscope/blob/master/LICENSE
  */
 
+#include "EdgeDispatcher.hpp"
 #include "GpioWatcher.hpp"
+#include "RealTime.hpp"
 #include "projector/IProjector.hpp"
 #include "projector/TinyDisplayProjector.hpp"
+#include "simulation/SimulatedHardware.hpp"
 
 #include <kali-core/stateMachineEvents.hpp>
+#include <kali-core/LatencyTracer.hpp>
+#include <kali-core/SyncLink.hpp>
 
 #include <mvp-player-net/server/Server.hpp>
 #include <mvp-player-core/stateMachineEvents.hpp>
@@ -20,6 +25,7 @@
 #include <boost/program_options.hpp>
 #include <boost/format.hpp>
 #include <boost/exception/all.hpp>
+#include <atomic>
 #include <thread>
 #include <chrono>
 
@@ -38,6 +44,22 @@ static const char * kGpioDelayOptionString( "gpioDelay" );
 static const char * kGpioDelayOptionMessage( "Next gpio event delay (40 is a good value)" );
 static const char * kUseTinyDisplayOptionString( "useTinyDisplay" );
 static const char * kUseTinyDisplayOptionMessage( "Use tiny display as projector (need FBTFT driver)" );
+static const char * kSyncPortOptionString( "syncPort" );
+static const char * kSyncPortOptionMessage( "UDP port of the frame sync link" );
+static const char * kSimulateOptionString( "simulate" );
+static const char * kSimulateOptionMessage( "Simulate the hardware with this film speed (frames per second), no root needed" );
+static const char * kSimulateJitterOptionString( "simulateJitter" );
+static const char * kSimulateJitterOptionMessage( "Simulated frame period jitter (milliseconds)" );
+static const char * kSimulateDurationOptionString( "simulateDuration" );
+static const char * kSimulateDurationOptionMessage( "Stop the simulation after this number of seconds (0: on CTRL+C)" );
+static const char * kSimulateReportOptionString( "simulateReport" );
+static const char * kSimulateReportOptionMessage( "Write the simulated timings and violations to this file (default: standard output)" );
+static const char * kRealTimeOptionString( "realTime" );
+static const char * kRealTimeOptionMessage( "Handle the GPIO edges (motor and flash) on a SCHED_FIFO thread of this priority (1-99, 0: off, needs root)" );
+static const char * kRealTimeCpuOptionString( "realTimeCpu" );
+static const char * kRealTimeCpuOptionMessage( "Pin the GPIO edges thread to this cpu, isolated with the isolcpus= kernel option (-1: any)" );
+static const char * kLatencyReportOptionString( "latencyReport" );
+static const char * kLatencyReportOptionMessage( "Write frame trigger latencies (p50/p99 per hop) to this file" );
 
 mvpplayer::network::server::Server * pServer = NULL;
 
@@ -68,11 +90,30 @@ void kalisync_unexpected( void )
     BOOST_THROW_EXCEPTION( std::runtime_error( "Sorry, Kalisync has encountered an unexpected exception.\nPlease report this bug." ) );
 }
 
-inline void triggerCapture( mvpplayer::network::server::Server & server )
+inline void triggerCaptureOnServer( mvpplayer::network::server::Server & server )
 {
+    kaliscope::LatencyTracer & tracer = kaliscope::LatencyTracer::getInstance();
     // Send next track event (means next frame in kaliscope)
     mvpplayer::logic::EvNextTrack event;
     server.sendEventMulticast( event );
+    // Then the frame id, kaliscope sends it back with its own timestamps
+    kaliscope::logic::EvSyncTrace traceEvent( tracer.newest() );
+    server.sendEventMulticast( traceEvent );
+}
+
+inline void triggerCapture( mvpplayer::network::server::Server & server, kaliscope::SyncLink & syncLink )
+{
+    kaliscope::LatencyTracer & tracer = kaliscope::LatencyTracer::getInstance();
+    tracer.stamp( kaliscope::eSyncHopTriggerSent );
+    // Kaliscope said hello on the sync link: one datagram, the trace included,
+    // sent again until kaliscope replies (see signalRequestLost otherwise)
+    kaliscope::SyncMessage message( kaliscope::eSyncActionNextFrame );
+    tracer.newest( message );
+    if ( syncLink.hasPeer() && !syncLink.request( message ) )
+    {
+        return;
+    }
+    triggerCaptureOnServer( server );
 }
 
 int main( int argc, char** argv )
@@ -93,11 +134,19 @@ int main( int argc, char** argv )
         bpo::options_description mainOptions( "Allowed options" );
         mainOptions.add_options()
             ( kServerPortOptionString,  bpo::value<unsigned short>()->default_value( mvpplayer::network::server::kDefaultServerPort ), kServerPortOptionMessage )
-            ( kMotorPinOptionString, bpo::value<int>()->required(), kMotorPinOptionMessage )
-            ( kFlashPinOptionString, bpo::value<int>()->required(), kFlashPinOptionMessage )
-            ( kGpioDelayOptionString, bpo::value<int>()->required(), kGpioDelayOptionMessage )
+            ( kMotorPinOptionString, bpo::value<int>(), kMotorPinOptionMessage )
+            ( kFlashPinOptionString, bpo::value<int>(), kFlashPinOptionMessage )
+            ( kGpioDelayOptionString, bpo::value<int>()->default_value( 40 ), kGpioDelayOptionMessage )
             ( kUseTinyDisplayOptionString, bpo::value<bool>()->required()->default_value( true ), kUseTinyDisplayOptionMessage )
-            ( kWatchInputPinOptionString, bpo::value<int>()->required(), kWatchInputPinOptionMessage );
+            ( kSyncPortOptionString, bpo::value<unsigned short>()->default_value( kaliscope::kDefaultSyncPort ), kSyncPortOptionMessage )
+            ( kLatencyReportOptionString, bpo::value<std::string>()->default_value( "" ), kLatencyReportOptionMessage )
+            ( kRealTimeOptionString, bpo::value<int>()->default_value( 0 ), kRealTimeOptionMessage )
+            ( kRealTimeCpuOptionString, bpo::value<int>()->default_value( -1 ), kRealTimeCpuOptionMessage )
+            ( kSimulateOptionString, bpo::value<double>()->default_value( 0.0 ), kSimulateOptionMessage )
+            ( kSimulateJitterOptionString, bpo::value<double>()->default_value( 1.0 ), kSimulateJitterOptionMessage )
+            ( kSimulateDurationOptionString, bpo::value<int>()->default_value( 0 ), kSimulateDurationOptionMessage )
+            ( kSimulateReportOptionString, bpo::value<std::string>()->default_value( "" ), kSimulateReportOptionMessage )
+            ( kWatchInputPinOptionString, bpo::value<int>(), kWatchInputPinOptionMessage );
 
         //parse the command line, and put the result in vm
         bpo::variables_map vm;
@@ -112,32 +161,76 @@ int main( int argc, char** argv )
         
         bpo::notify(vm);
 
+        const double simulatedFps = vm[kSimulateOptionString].as<double>();
+        if ( simulatedFps <= 0.0 &&
+             ( !vm.count( kWatchInputPinOptionString ) || !vm.count( kMotorPinOptionString ) || !vm.count( kFlashPinOptionString ) ) )
+        {
+            std::cerr << "[Kalisync] The watch, motor and flash pins are required (unless simulating)." << std::endl;
+            return 2;
+        }
+
         using namespace kaliscope;
         using namespace mvpplayer;
         using namespace mvpplayer::network::server;
 
         mvpplayer::Settings::getInstance().set( "gpio", "nextEventDelay", vm[kGpioDelayOptionString].as<int>() );
+        const std::string latencyReport = vm[kLatencyReportOptionString].as<std::string>();
+        LatencyTracer & tracer = LatencyTracer::getInstance();
+
+        RealTimeSettings realTime;
+        realTime.priority = vm[kRealTimeOptionString].as<int>();
+        realTime.cpu = vm[kRealTimeCpuOptionString].as<int>();
+        if ( realTime.enabled() && lockMemory() )
+        {
+            std::cout << "[Kalisync] Memory locked, GPIO edges priority: " << realTime.priority << ", cpu: " << realTime.cpu << "." << std::endl;
+        }
 
         std::unique_ptr<IProjector> projector;
-        if ( vm[kUseTinyDisplayOptionString].as<bool>() )
+        std::unique_ptr<SimulatedFilmTransport> simulation;
+        std::unique_ptr<IGpio> sensorPin;
+        std::unique_ptr<IGpio> motorPin;
+        std::unique_ptr<IGpio> flashPin;
+        if ( simulatedFps > 0.0 )
         {
-            projector.reset( new TinyDisplayProjector() );
+            // The film starts moving when kaliscope says hello
+            simulation.reset( new SimulatedFilmTransport( simulatedFps, vm[kSimulateJitterOptionString].as<double>() ) );
+            sensorPin = simulation->createGpio( eSimulatedPinSensor, 0 );
+            motorPin = simulation->createGpio( eSimulatedPinMotor, 1 );
+            flashPin = simulation->createGpio( eSimulatedPinFlash, 2 );
+            projector = simulation->createProjector();
+            std::cout << "[Kalisync] Simulated hardware, film speed: " << simulatedFps << " fps." << std::endl;
         }
-        GpioWatcher gpioWatcher( vm[kWatchInputPinOptionString].as<int>(), 0 );
-        GpioWatcher gpioMotor( vm[kMotorPinOptionString].as<int>() );
+        else
+        {
+            if ( vm[kUseTinyDisplayOptionString].as<bool>() )
+            {
+                projector.reset( new TinyDisplayProjector() );
+            }
+            // Started once the edges are handled
+            sensorPin.reset( new GpioWatcher( vm[kWatchInputPinOptionString].as<int>() ) );
+            motorPin.reset( new GpioWatcher( vm[kMotorPinOptionString].as<int>() ) );
+            flashPin.reset( new GpioWatcher( vm[kFlashPinOptionString].as<int>() ) );
+        }
+        IGpio & gpioWatcher = *sensorPin;
+        gpioWatcher.setRealTime( realTime );
+        IGpio & gpioMotor = *motorPin;
         gpioMotor.exportGpio();
         gpioMotor.setDirGpio( "out" );
         gpioMotor.setValGpio( false );
-        GpioWatcher gpioFlash( vm[kFlashPinOptionString].as<int>() );
+        IGpio & gpioFlash = *flashPin;
         gpioFlash.exportGpio();
         gpioFlash.setDirGpio( "out" );
         gpioFlash.setValGpio( false );
 
-        std::cout << "[Kalisync] GPIO Watcher started..." << std::endl;
         Server server( vm[kServerPortOptionString].as<unsigned short>() );
         server.run();
         pServer = &server;
         std::cout << "[Kalisync] GPIO Server started..." << std::endl;
+        SyncLink syncLink;
+        if ( syncLink.listen( vm[kSyncPortOptionString].as<unsigned short>() ) )
+        {
+            std::cerr << "[Kalisync] Sync link unavailable, frame events go thru the server." << std::endl;
+        }
         if ( projector )
         {
             std::cout << "Testing projector..." << std::endl;
@@ -147,41 +240,100 @@ int main( int argc, char** argv )
             std::cout << "Projector tested." << std::endl;
         }
 
-        // Toggle led value
+        // Set when a frame is triggered, cleared once kaliscope has exposed it:
+        // kaliscope also replies when the frame is processed, and that reply
+        // mustn't restart the motor during the exposure of the next frame
+        std::atomic<bool> exposurePending( false );
+        // Flat field calibration: the film stays still, the uniform field is
+        // captured again as soon as the previous frame has been exposed
+        std::atomic<bool> flatField( false );
+
+        // Kaliscope replied for a frame: exposed (or processed, for the
+        // kaliscope versions that don't send the exposure event)
+        auto frameReplied = [&server, &syncLink, &gpioFlash, &projector, &gpioMotor, &tracer, &exposurePending, &flatField]( const bool exposed )
+        {
+            if ( flatField && exposed )
+            {
+                // Next frame of the uniform field
+                triggerCapture( server, syncLink );
+            }
+            else if ( exposurePending.exchange( false ) )
+            {
+                tracer.stamp( eSyncHopExposureReceived );
+                // Stop the flash light and restart the motor
+                gpioFlash.setValGpio( false );
+                if ( projector )
+                { projector->switchOff(); }
+                gpioMotor.setValGpio( true );
+                tracer.stamp( eSyncHopMotorRestarted );
+            }
+        };
+
+        // Trace and network work of the edges, out of the GPIO thread
+        EdgeDispatcher edgeDispatcher(
+            [&server, &syncLink, &tracer]( const EdgeDispatcher::TimePoint & edgeTime )
+            {
+                tracer.begin();
+                tracer.stamp( eSyncHopGpioEdge, edgeTime );
+                // Ask the client to capture a frame
+                triggerCapture( server, syncLink );
+            }
+        );
+
+        // GPIO thread (real-time if asked): no lock, no allocation, no network
         gpioWatcher.signalGpioValueChanged.connect(
-            [&server, &gpioMotor, &gpioFlash, &projector]( const std::size_t, const bool value )
+            [&gpioWatcher, &gpioMotor, &gpioFlash, &projector, &exposurePending, &edgeDispatcher]( const std::size_t, const bool value )
             {
                 if ( value == true )
                 {
+                    exposurePending = true;
                     // Stop the motor and light the flash
                     gpioMotor.setValGpio( false );
                     gpioFlash.setValGpio( true );
                     if ( projector )
                     { projector->switchOn(); }
-                    // Ask the client to capture a frame
-                    triggerCapture( server );
+                    edgeDispatcher.post( gpioWatcher.lastEventTime() );
                 }
             }
         );
 
         server.signalEventFrom.connect(
-            [&gpioFlash, &projector, &gpioMotor](const std::string&, IEvent& event)
+            [&server, &syncLink, &gpioFlash, &projector, &gpioMotor, &tracer, &latencyReport, &exposurePending, &flatField, &frameReplied](const std::string&, IEvent& event)
             {
                 using namespace mvpplayer::logic;
-                // When a frame has been captured, we want to step forward
+                // When a frame has been exposed, we want to step forward
+                // while kaliscope processes it. Kaliscope versions that don't
+                // send the exposure event only reply once the frame is processed.
                 if ( dynamic_cast<mvpplayer::logic::EvCustomState*>( &event ) )
                 {
                     const EvCustomState& customState = dynamic_cast<EvCustomState&>( event );
-                    if ( customState.action() == kaliscope::kFrameCapturedCustomStateAction )
+                    if ( customState.action() == kaliscope::kFrameExposedCustomStateAction )
                     {
-                        // Stop the flash light and restart the motor
-                        gpioFlash.setValGpio( false );
+                        frameReplied( true );
+                    }
+                    else if ( customState.action() == kaliscope::kFrameCapturedCustomStateAction )
+                    {
+                        frameReplied( false );
+                    }
+                    else if ( customState.action() == kaliscope::kFlatFieldStartCustomStateAction )
+                    {
+                        std::cout << "[Kalisync] Flat field calibration started." << std::endl;
+                        flatField = true;
+                        exposurePending = false;
+                        // Stop the motor and light a uniform field
+                        gpioMotor.setValGpio( false );
+                        gpioFlash.setValGpio( true );
                         if ( projector )
-                        { projector->switchOff(); }
-                        gpioMotor.setValGpio( true );
+                        { projector->projectColor( 255, 255, 255 ); }
+                        triggerCapture( server, syncLink );
                     }
-                    else if ( customState.action() == kaliscope::kCaptureStopCustomStateAction )
+                    else if ( customState.action() == kaliscope::kCaptureStopCustomStateAction ||
+                              customState.action() == kaliscope::kFlatFieldStopCustomStateAction )
                     {
+                        flatField = false;
+                        exposurePending = false;
+                        // Kaliscope won't reply to the last trigger
+                        syncLink.cancelRequest();
                         // Stop the flash light and the motor
                         gpioFlash.setValGpio( false );
                         if ( projector )
@@ -189,19 +341,126 @@ int main( int argc, char** argv )
                         gpioMotor.setValGpio( false );
                     }
                 }
+                // Kaliscope timestamps of the frame, sent after the frame captured event
+                else if ( dynamic_cast<kaliscope::logic::EvSyncTrace*>( &event ) )
+                {
+                    tracer.merge( dynamic_cast<kaliscope::logic::EvSyncTrace&>( event ).trace() );
+                    if ( !latencyReport.empty() && tracer.nbCompleted() % kaliscope::kLatencyReportPeriod == 0 )
+                    {
+                        tracer.writeReport( latencyReport );
+                    }
+                }
                 // When we hit stop, we want to stop flash and motor
                 else if ( dynamic_cast<EvStop*>( &event ) )
                 {
+                    syncLink.cancelRequest();
                     gpioFlash.setValGpio( false );
                     gpioMotor.setValGpio( false );
                 }
             }
         );
+
+        // Per frame events from the sync link: no RTTI, no allocation
+        syncLink.signalMessage.connect(
+            [&tracer, &latencyReport, &frameReplied, &simulation, &gpioWatcher]( const SyncMessage & message )
+            {
+                switch( message.action )
+                {
+                    case eSyncActionHello:
+                        if ( simulation )
+                        {
+                            gpioWatcher.startWatching();
+                        }
+                        break;
+                    case eSyncActionFrameExposed:
+                        // The reply to the pending trigger, signaled once
+                        frameReplied( true );
+                        break;
+                    case eSyncActionFrameCaptured:
+                        // Kaliscope always replies with the exposure on the sync link:
+                        // this may be the previous frame, it mustn't restart the motor
+                        // during this exposure. Its timestamps come with it.
+                        tracer.merge( message );
+                        if ( !latencyReport.empty() && tracer.nbCompleted() % kaliscope::kLatencyReportPeriod == 0 )
+                        {
+                            tracer.writeReport( latencyReport );
+                        }
+                        break;
+                    case eSyncActionBye:
+                        std::cout << "[Kalisync] Kaliscope left the sync link." << std::endl;
+                        break;
+                    default:
+                        break;
+                }
+            }
+        );
+        // Kaliscope didn't answer the trigger on the sync link (datagrams lost,
+        // or kaliscope gone): the link is forgotten, the trigger goes thru the server
+        syncLink.signalRequestLost.connect(
+            [&server]( const SyncMessage & )
+            {
+                std::cerr << "[Kalisync] No reply on the sync link, frame events go thru the server." << std::endl;
+                triggerCaptureOnServer( server );
+            }
+        );
+        if ( !simulation )
+        {
+            gpioWatcher.startWatching();
+            std::cout << "[Kalisync] GPIO Watcher started..." << std::endl;
+        }
+
+        // Soak tests: stop after a while
+        std::atomic<bool> running( true );
+        std::thread stopper;
+        const int simulatedDuration = vm[kSimulateDurationOptionString].as<int>();
+        if ( simulation && simulatedDuration > 0 )
+        {
+            stopper = std::thread(
+                [&server, &running, simulatedDuration]()
+                {
+                    const auto end = std::chrono::steady_clock::now() + std::chrono::seconds( simulatedDuration );
+                    while( running && std::chrono::steady_clock::now() < end )
+                    {
+                        std::this_thread::sleep_for( std::chrono::milliseconds( 100 ) );
+                    }
+                    if ( running )
+                    {
+                        server.stop();
+                    }
+                }
+            );
+        }
         server.wait();
+        running = false;
+        if ( stopper.joinable() )
+        {
+            stopper.join();
+        }
+        gpioWatcher.stop();
+        edgeDispatcher.stop();
+        if ( edgeDispatcher.nbDropped() )
+        {
+            std::cerr << "[Kalisync] " << edgeDispatcher.nbDropped() << " GPIO edges were not sent to kaliscope." << std::endl;
+        }
+        syncLink.signalRequestLost.disconnect_all_slots();
+        syncLink.close();
+        if ( !latencyReport.empty() )
+        {
+            tracer.writeReport( latencyReport );
+        }
         gpioFlash.setValGpio( false );
         if ( projector )
         { projector->switchOff(); }
         gpioMotor.setValGpio( false );
+        if ( simulation )
+        {
+            simulation->writeReport( vm[kSimulateReportOptionString].as<std::string>() );
+            if ( simulation->nbViolations() )
+            {
+                std::cerr << "[Kalisync] Simulation: " << simulation->nbViolations() << " timing violations." << std::endl;
+                return 1;
+            }
+        }
     }
     catch( ... )
     {
@@ -6,6 +6,8 @@
 #ifndef _KALI_IPROJECTOR_HPP_
 #define	_KALI_IPROJECTOR_HPP_
 
+#include <cstddef>
+
 namespace kaliscope
 {
 
@@ -52,6 +54,22 @@ public:
      */
     virtual void switchOff() = 0;
 
+    /**
+     * @brief project a uniform color (calibration fields)
+     * @param r[in] red
+     * @param g[in] green
+     * @param b[in] blue
+     */
+    virtual void projectColor( const unsigned char r, const unsigned char g, const unsigned char b ) = 0;
+
+    /**
+     * @brief project an image, scaled to the projector size
+     * @param rgb[in] interleaved 8 bits rgb pixels
+     * @param width[in] image width
+     * @param height[in] image height
+     */
+    virtual void projectImage( const unsigned char *rgb, const std::size_t width, const std::size_t height ) = 0;
+
 protected:
     bool _active = false;
     double _maxActiveTime = -1;
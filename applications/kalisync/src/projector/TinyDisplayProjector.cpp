@@ -8,8 +8,11 @@
 #include <iostream>
 #include <fcntl.h>
 #include <sys/ioctl.h> 
+#include <sys/stat.h>
 #include <unistd.h>
 #include <cstring>
+#include <thread>
+#include <vector>
 
 #define KNRM  "\x1B[0m"
 #define KRED  "\x1B[31m"
@@ -54,8 +57,11 @@ static unsigned short def_b[] =
 namespace kaliscope
 {
 
-TinyDisplayProjector::TinyDisplayProjector()
+TinyDisplayProjector::TinyDisplayProjector( const std::string & device, const std::size_t width, const std::size_t height )
 : IProjector( -1 )
+, _device( device )
+, _width( width )
+, _height( height )
 {
    init();
 }
@@ -64,8 +70,9 @@ TinyDisplayProjector::~TinyDisplayProjector()
 {
    try
    {
-      switchOff();
+      acquire();
       closeFramebuffer();
+      _busy = false;
    }
    catch( ... )
    {}
@@ -76,50 +83,98 @@ TinyDisplayProjector::~TinyDisplayProjector()
  */
 void TinyDisplayProjector::init()
 {
-    static const char *kFbDevice = "/dev/fb1";
+    acquire();
+    openFramebuffer();
+    release();
+}
 
-    if ( _fb )
+void TinyDisplayProjector::openFramebuffer()
+{
+    if ( _fb >= 0 )
     {
         closeFramebuffer();
     }
 
-    _fb = open( kFbDevice, O_RDWR );
+    _fb = open( _device.c_str(), O_RDWR );
     if ( _fb == -1 )
     {
         std::cerr << "Failed to open fbdevice, did you installed your tiny screen correctly?" << std::endl;
         return;
     }
 
-    if ( ioctl( _fb, FBIOGET_FSCREENINFO, &_fix ) < 0 )
+    _nbPages = 1;
+    _visiblePage = 0;
+    _pageContent[0] = _pageContent[1] = kPageImage;
+    _isFramebuffer = ioctl( _fb, FBIOGET_FSCREENINFO, &_fix ) == 0;
+    if ( _isFramebuffer )
     {
-        std::cerr << "Failed ioctl FBIOGET_FSCREENINFO" << std::endl;
-        close( _fb );
-        return;
-    }
+        if ( ioctl( _fb, FBIOGET_VSCREENINFO, &_var ) < 0 )
+        {
+            std::cerr << "Failed ioctl FBIOGET_VSCREENINFO" << std::endl;
+            close( _fb );
+            _fb = -1;
+            return;
+        }
+        if ( _var.bits_per_pixel != 16 )
+        {
+            std::cerr << "Only RGB565 framebuffers are supported (" << _var.bits_per_pixel << " bits per pixel)" << std::endl;
+            close( _fb );
+            _fb = -1;
+            return;
+        }
+
+        memcpy( &_origVar, &_var, sizeof( fb_var_screeninfo ) );
+        _width = _var.xres;
+        _height = _var.yres;
 
-    if ( ioctl( _fb, FBIOGET_VSCREENINFO, &_var ) < 0 )
+        // Use a second page if the driver can pan the display over it
+        if ( _fix.ypanstep && _fix.smem_len >= 2 * _fix.line_length * _var.yres )
+        {
+            fb_var_screeninfo var = _var;
+            var.yres_virtual = 2 * _var.yres;
+            var.yoffset = 0;
+            if ( ioctl( _fb, FBIOPUT_VSCREENINFO, &var ) == 0 &&
+                 ioctl( _fb, FBIOGET_VSCREENINFO, &var ) == 0 &&
+                 ioctl( _fb, FBIOGET_FSCREENINFO, &_fix ) == 0 &&
+                 var.yres_virtual >= 2 * var.yres )
+            {
+                _var = var;
+                _nbPages = 2;
+            }
+        }
+        _lineLength = _fix.line_length;
+        _screensize = _fix.smem_len;
+    }
+    else
     {
-        std::cerr << "Failed ioctl FBIOGET_VSCREENINFO" << std::endl;
-        close( _fb );
-        return;
+        // Fake framebuffer (plain file), used for testing
+        _lineLength = _width * sizeof( std::uint16_t );
+        _screensize = _lineLength * _height;
+        struct stat st;
+        if ( fstat( _fb, &st ) < 0 || ( st.st_size < _screensize && ftruncate( _fb, _screensize ) < 0 ) )
+        {
+            std::cerr << "Failed to size the fake framebuffer " << _device << std::endl;
+            close( _fb );
+            _fb = -1;
+            return;
+        }
     }
-
-    memcpy( &_origVar, &_var, sizeof( fb_var_screeninfo ) );
+    _pageSize = _lineLength * _height;
 
     // map framebuffer to user memory 
-    _screensize = _fix.smem_len;
     _fbp = (char*)mmap(0, 
                 _screensize, 
                 PROT_READ | PROT_WRITE, 
                 MAP_SHARED, 
                 _fb, 0);
-    if ( (int)_fbp == -1 )
+    if ( _fbp == MAP_FAILED )
     {
         std::cerr << "Failed to memory map!" << std::endl;
+        _fbp = NULL;
+        closeFramebuffer();
+        return;
     }
-
-    _width = _var.xres;
-    _height = _var.yres;
+    showPage( 0 );
 }
 
 /**
@@ -128,9 +183,7 @@ void TinyDisplayProjector::init()
 void TinyDisplayProjector::switchOn()
 {
     // set framebuffer to white
-    for( std::size_t x = 0; x < _width; ++x )
-        for( std::size_t y = 0; y < _height; ++y )
-            drawPixel( x, y, 255, 255, 255 );
+    requestColor( rgb565( 255, 255, 255 ) );
 }
 
 /**
@@ -139,28 +192,155 @@ void TinyDisplayProjector::switchOn()
 void TinyDisplayProjector::switchOff()
 {
     // set framebuffer to black
+    requestColor( rgb565( 0, 0, 0 ) );
+}
+
+void TinyDisplayProjector::projectColor( const unsigned char r, const unsigned char g, const unsigned char b )
+{
+    requestColor( rgb565( r, g, b ) );
+}
+
+void TinyDisplayProjector::projectImage( const unsigned char *rgb, const std::size_t width, const std::size_t height )
+{
+    if ( !_fbp || !width || !height )
+    {
+        return;
+    }
+    // Source column of each display column
+    std::vector<std::size_t> columns( _width );
     for( std::size_t x = 0; x < _width; ++x )
-        for( std::size_t y = 0; y < _height; ++y )
-            drawPixel( x, y, 0, 0, 0 );
+    {
+        columns[x] = 3 * ( x * width / _width );
+    }
+
+    acquire();
+    const std::size_t page = backPage();
+    std::vector<std::uint16_t> row( _width );
+    for( std::size_t y = 0; y < _height; ++y )
+    {
+        const unsigned char *src = rgb + 3 * width * ( y * height / _height );
+        for( std::size_t x = 0; x < _width; ++x )
+        {
+            const unsigned char *p = src + columns[x];
+            row[x] = rgb565( p[0], p[1], p[2] );
+        }
+        memcpy( pageData( page ) + y * _lineLength, &row[0], _width * sizeof( std::uint16_t ) );
+    }
+    _pageContent[page] = kPageImage;
+    showPage( page );
+    _active = true;
+    release();
+}
+
+void TinyDisplayProjector::requestColor( const std::uint16_t color )
+{
+    _pendingColor = color;
+    showPendingColor();
+}
+
+void TinyDisplayProjector::showPendingColor()
+{
+    // The owner checks again once it has left: no color is left pending
+    while ( _pendingColor != kNoPendingColor && tryAcquire() )
+    {
+        const std::uint32_t color = _pendingColor.exchange( kNoPendingColor );
+        if ( color != kNoPendingColor )
+        {
+            showColor( color );
+            _active = color != rgb565( 0, 0, 0 );
+        }
+        _busy = false;
+    }
+}
+
+void TinyDisplayProjector::acquire()
+{
+    // Only the non real-time callers wait (images, init)
+    while ( !tryAcquire() )
+    {
+        std::this_thread::yield();
+    }
 }
 
+void TinyDisplayProjector::release()
+{
+    _busy = false;
+    showPendingColor();
+}
 
+void TinyDisplayProjector::showColor( const std::uint16_t color )
+{
+    if ( !_fbp )
+    {
+        return;
+    }
+    if ( _pageContent[_visiblePage] == color )
+    {
+        return;
+    }
+    if ( _nbPages == 2 && _pageContent[1 - _visiblePage] == color )
+    {
+        // Already drawn: flipping is all it takes
+        showPage( 1 - _visiblePage );
+        return;
+    }
+    const std::size_t page = backPage();
+    fillPage( page, color );
+    _pageContent[page] = color;
+    showPage( page );
+}
+
+void TinyDisplayProjector::fillPage( const std::size_t page, const std::uint16_t color )
+{
+    char *data = pageData( page );
+    // First row: four pixels per store
+    const std::uint64_t word = color * 0x0001000100010001ULL;
+    std::uint16_t *row = reinterpret_cast<std::uint16_t*>( data );
+    std::size_t x = 0;
+    for( ; x + 4 <= _width; x += 4 )
+    {
+        memcpy( row + x, &word, sizeof( word ) );
+    }
+    for( ; x < _width; ++x )
+    {
+        row[x] = color;
+    }
+    // The other rows are copies of the first one
+    const std::size_t rowSize = _width * sizeof( std::uint16_t );
+    for( std::size_t y = 1; y < _height; ++y )
+    {
+        memcpy( data + y * _lineLength, data, rowSize );
+    }
+}
+
+void TinyDisplayProjector::showPage( const std::size_t page )
+{
+    if ( _nbPages == 2 && _isFramebuffer )
+    {
+        _var.xoffset = 0;
+        _var.yoffset = page * _height;
+        if ( ioctl( _fb, FBIOPAN_DISPLAY, &_var ) < 0 )
+        {
+            std::cerr << "Failed ioctl FBIOPAN_DISPLAY, using a single page" << std::endl;
+            // Keep drawing in the page that is shown
+            _var.yoffset = _visiblePage * _height;
+            _nbPages = 1;
+            return;
+        }
+    }
+    _visiblePage = page;
+}
 
 void TinyDisplayProjector::drawPixel( const std::size_t x, const std::size_t y, int r, int g, int b)
 {
     assert( _fbp != nullptr );
 
-    unsigned int pix_offset;
-    unsigned short c;
-
     // calculate the pixel's byte offset inside the buffer
-    pix_offset = x*2 + y * _fix.line_length;
-
-    //some magic to work out the color
-    c = ((r / 8) << 11) + ((g / 4) << 5) + (b / 8);
+    const std::size_t pix_offset = x * 2 + y * _lineLength;
 
     // write 'two bytes at once'
-    *((unsigned short*)(_fbp + pix_offset)) = c;
+    *((std::uint16_t*)(pageData( _visiblePage ) + pix_offset)) = rgb565( r, g, b );
+    _pageContent[_visiblePage] = kPageImage;
 }
 
 
@@ -173,14 +353,24 @@ void TinyDisplayProjector::drawSquare( const std::size_t x, const std::size_t y,
 
 void TinyDisplayProjector::closeFramebuffer()
 {
-    switchOff();
-
-    munmap( _fbp, _screensize );
-    if (ioctl( _fb, FBIOPUT_VSCREENINFO, &_origVar ) )
+    if ( _fbp )
+    {
+        showColor( rgb565( 0, 0, 0 ) );
+        _active = false;
+        munmap( _fbp, _screensize );
+        _fbp = NULL;
+    }
+    if ( _fb < 0 )
+    {
+        return;
+    }
+    // Also brings the first page back
+    if ( _isFramebuffer && ioctl( _fb, FBIOPUT_VSCREENINFO, &_origVar ) )
     {
         std::cerr << "Error re-setting variable information" << std::endl;
     }
     close( _fb );
+    _fb = -1;
 }
 
 }
@@ -11,15 +11,37 @@
 #include <stdlib.h>
 #include <linux/fb.h>
 #include <sys/mman.h>
+#include <atomic>
+#include <cstdint>
 #include <string>
 
 namespace kaliscope
 {
 
+/**
+ * @brief projector using a small RGB565 TFT display (FBTFT driver) as light source
+ *
+ * The display is filled row by row with precomputed 565 words. When the
+ * driver supports panning, two pages are used: the next image is drawn in
+ * the hidden page and shown with FBIOPAN_DISPLAY, so that switching the
+ * flash on or off only pans between the white and the black pages.
+ *
+ * The projector is driven from several threads (GPIO, server, sync link).
+ * The display is owned by one thread at a time, and colors never wait for
+ * it: a color asked while another thread draws is left pending, and the
+ * thread that owns the display shows it before leaving. The last color
+ * asked is always the one shown, and switchOn never blocks the GPIO thread.
+ */
 class TinyDisplayProjector : public IProjector
 {
 public:
-    TinyDisplayProjector();
+    /**
+     * @brief constructor
+     * @param device[in] framebuffer device
+     * @param width[in] width used if device is a plain file (fake framebuffer)
+     * @param height[in] height used if device is a plain file (fake framebuffer)
+     */
+    TinyDisplayProjector( const std::string & device = "/dev/fb1", const std::size_t width = 320, const std::size_t height = 240 );
     virtual ~TinyDisplayProjector();
     
     /**
@@ -37,17 +59,127 @@ public:
      */
     void switchOff();
 
+    /**
+     * @brief project a uniform color (calibration fields)
+     */
+    void projectColor( const unsigned char r, const unsigned char g, const unsigned char b );
+
+    /**
+     * @brief project an image, scaled to the display size (nearest pixel)
+     */
+    void projectImage( const unsigned char *rgb, const std::size_t width, const std::size_t height );
+
+    /**
+     * @brief is the display usable
+     */
+    inline bool isOpen() const
+    { return _fbp != NULL; }
+
+    /**
+     * @brief are two pages used
+     */
+    inline bool isDoubleBuffered() const
+    { return _nbPages == 2; }
+
+    inline std::size_t width() const
+    { return _width; }
+
+    inline std::size_t height() const
+    { return _height; }
+
+    /**
+     * @brief convert a color to a RGB565 word
+     */
+    static inline std::uint16_t rgb565( const unsigned char r, const unsigned char g, const unsigned char b )
+    { return ( ( r >> 3 ) << 11 ) | ( ( g >> 2 ) << 5 ) | ( b >> 3 ); }
+
 private:
+    /**
+     * @brief page to draw in: the hidden one, or the only one
+     */
+    inline std::size_t backPage() const
+    { return _nbPages == 2 ? 1 - _visiblePage : _visiblePage; }
+
+    inline char *pageData( const std::size_t page ) const
+    { return _fbp + page * _pageSize; }
+
+    /**
+     * @brief fill a page with a color
+     */
+    void fillPage( const std::size_t page, const std::uint16_t color );
+
+    /**
+     * @brief show a page (pan the display)
+     */
+    void showPage( const std::size_t page );
+
+    /**
+     * @brief show a uniform color, drawn only if no page already holds it
+     * @warning own the display
+     */
+    void showColor( const std::uint16_t color );
+
+    /**
+     * @brief ask for a uniform color, shown by this thread or by the one owning the display
+     */
+    void requestColor( const std::uint16_t color );
+
+    /**
+     * @brief show the pending color, unless another thread owns the display
+     */
+    void showPendingColor();
+
+    /**
+     * @brief own the display, without blocking
+     * @return false if another thread owns it
+     */
+    inline bool tryAcquire()
+    { return !_busy.exchange( true ); }
+
+    /**
+     * @brief own the display, waits for the thread owning it
+     */
+    void acquire();
+
+    /**
+     * @brief leave the display, then show a color asked meanwhile
+     */
+    void release();
+
     void drawPixel( const std::size_t x, const std::size_t y, int r, int g, int b );
 
     void drawSquare( const std::size_t x, const std::size_t y, const std::size_t height, const std::size_t width, int c );
 
+    /**
+     * @brief open and map the framebuffer
+     * @warning own the display
+     */
+    void openFramebuffer();
+
+    /**
+     * @brief black out and unmap the framebuffer
+     * @warning own the display
+     */
     void closeFramebuffer();
 
+    /// Content of a page that isn't a uniform color
+    static const std::uint32_t kPageImage = 0xffffffff;
+    /// No color asked
+    static const std::uint32_t kNoPendingColor = 0xffffffff;
+
+    const std::string _device;          ///< Framebuffer device
     char *_fbp = NULL;
-    int _fb = 0;
+    int _fb = -1;
+    bool _isFramebuffer = false;        ///< False for a fake (file) framebuffer
     std::size_t _width = 0;
     std::size_t _height = 0;
+    std::size_t _lineLength = 0;        ///< Bytes per row
+    std::size_t _pageSize = 0;          ///< Bytes per page
+    std::size_t _nbPages = 1;           ///< Pages used (2 when the driver can pan)
+    std::size_t _visiblePage = 0;       ///< Page currently shown
+    std::uint32_t _pageContent[2] = { kPageImage, kPageImage }; ///< Uniform color of each page, kPageImage otherwise
+    std::atomic<bool> _busy{ false };   ///< A thread owns the display (pages, page cache and panning)
+    std::atomic<std::uint32_t> _pendingColor{ kNoPendingColor };   ///< Last color asked, not shown yet
     long int _screensize = 0;
     fb_fix_screeninfo _fix;
     fb_var_screeninfo _origVar;
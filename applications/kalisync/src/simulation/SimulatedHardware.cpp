@@ -0,0 +1,421 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#include "SimulatedHardware.hpp"
+
+#include <boost/format.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+namespace kaliscope
+{
+
+namespace
+{
+
+/// Number of samples kept for each segment
+static const std::size_t kMaxSamples( 100000 );
+/// The sensor goes back to 0 once this part of the frame has passed
+static const double kSensorPulse( 0.1 );
+
+static const char * kSegmentNames[] =
+{
+    "edge -> motor stopped",
+    "edge -> light on",
+    "edge -> motor restarted",
+    "frame period (edge -> edge)",
+};
+
+static const char * kViolationNames[] =
+{
+    "light while the film moves",
+    "missed frames (motor not stopped)",
+};
+
+boost::int64_t percentile( std::vector<boost::int64_t> & values, const double p )
+{
+    std::vector<boost::int64_t>::iterator nth = values.begin() + static_cast<std::ptrdiff_t>( p * ( values.size() - 1 ) );
+    std::nth_element( values.begin(), nth, values.end() );
+    return *nth;
+}
+
+}
+
+SimulatedGpio::SimulatedGpio( SimulatedFilmTransport & transport, const ESimulatedPin pin, const std::size_t gpioId )
+: IGpio( gpioId )
+, _transport( transport )
+, _pin( pin )
+{
+}
+
+SimulatedGpio::~SimulatedGpio()
+{
+    stop();
+}
+
+void SimulatedGpio::startWatching( const std::size_t )
+{
+    if ( _pin == eSimulatedPinSensor )
+    {
+        _transport.start();
+    }
+}
+
+void SimulatedGpio::stop()
+{
+    if ( _pin == eSimulatedPinSensor )
+    {
+        _transport.stop();
+    }
+}
+
+bool SimulatedGpio::exportGpio()
+{
+    return true;
+}
+
+bool SimulatedGpio::unexportGpio()
+{
+    return true;
+}
+
+bool SimulatedGpio::setDirGpio( const std::string & )
+{
+    return true;
+}
+
+bool SimulatedGpio::setValGpio( const bool value )
+{
+    if ( _pin == eSimulatedPinSensor )
+    {
+        std::cerr << "OPERATION FAILED: the simulated sensor is an input." << std::endl;
+        return false;
+    }
+    _transport.setOutput( _pin, value );
+    return true;
+}
+
+bool SimulatedGpio::getValGpio( bool & val )
+{
+    val = _transport.value( _pin );
+    return true;
+}
+
+void SimulatedGpio::emitValue( const bool value, const std::chrono::steady_clock::time_point & time )
+{
+    _eventTime = time;
+    signalGpioValueChanged( _gpioId, value );
+}
+
+SimulatedProjector::SimulatedProjector( SimulatedFilmTransport & transport )
+: _transport( transport )
+{
+}
+
+SimulatedProjector::~SimulatedProjector()
+{
+}
+
+void SimulatedProjector::init()
+{
+}
+
+void SimulatedProjector::switchOn()
+{
+    _transport.setProjectorLight( true );
+    _active = true;
+}
+
+void SimulatedProjector::switchOff()
+{
+    _transport.setProjectorLight( false );
+    _active = false;
+}
+
+void SimulatedProjector::projectColor( const unsigned char r, const unsigned char g, const unsigned char b )
+{
+    _transport.setProjectorLight( r || g || b );
+}
+
+void SimulatedProjector::projectImage( const unsigned char *, const std::size_t, const std::size_t )
+{
+    _transport.setProjectorLight( true );
+}
+
+SimulatedFilmTransport::SimulatedFilmTransport( const double fps, const double jitterMs )
+: _framePeriod( 1.0 / fps )
+, _jitter( jitterMs / 1000.0 )
+, _random( 42 )
+, _samples( eNbSegments )
+{
+    std::fill( _values, _values + eNbSimulatedPins, false );
+    std::fill( _violations, _violations + eNbViolations, 0 );
+}
+
+SimulatedFilmTransport::~SimulatedFilmTransport()
+{
+    stop();
+}
+
+std::unique_ptr<IGpio> SimulatedFilmTransport::createGpio( const ESimulatedPin pin, const std::size_t gpioId )
+{
+    SimulatedGpio * gpio = new SimulatedGpio( *this, pin, gpioId );
+    if ( pin == eSimulatedPinSensor )
+    {
+        std::unique_lock<std::mutex> lock( _mutex );
+        _sensor = gpio;
+    }
+    return std::unique_ptr<IGpio>( gpio );
+}
+
+std::unique_ptr<IProjector> SimulatedFilmTransport::createProjector()
+{
+    return std::unique_ptr<IProjector>( new SimulatedProjector( *this ) );
+}
+
+void SimulatedFilmTransport::start()
+{
+    stop();
+    std::unique_lock<std::mutex> lock( _mutex );
+    _stopped = false;
+    _firstFrame = true;
+    _travel = 0.0;
+    _period = nextPeriod();
+    _start = _lastUpdate = Clock::now();
+    _thread.reset( new std::thread( &SimulatedFilmTransport::worker, this ) );
+}
+
+void SimulatedFilmTransport::stop()
+{
+    {
+        std::unique_lock<std::mutex> lock( _mutex );
+        _stopped = true;
+    }
+    _condition.notify_all();
+    if ( _thread )
+    {
+        _thread->join();
+        _thread.reset();
+    }
+}
+
+double SimulatedFilmTransport::nextPeriod()
+{
+    std::uniform_real_distribution<double> jitter( -_jitter, _jitter );
+    return std::max( 0.0, _framePeriod + jitter( _random ) );
+}
+
+bool SimulatedFilmTransport::isMoving() const
+{
+    return _values[eSimulatedPinMotor] || _firstFrame;
+}
+
+void SimulatedFilmTransport::advance( const Clock::time_point & now )
+{
+    if ( isMoving() )
+    {
+        _travel += std::chrono::duration<double>( now - _lastUpdate ).count();
+    }
+    _lastUpdate = now;
+}
+
+void SimulatedFilmTransport::worker()
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    // Stands for the watcher thread of the sensor
+    if ( _sensor && _sensor->realTime().enabled() )
+    {
+        setCurrentThreadRealTime( _sensor->realTime() );
+    }
+    while( !_stopped )
+    {
+        if ( isMoving() )
+        {
+            // Next event: end of the sensor pulse or next frame
+            const double target = _values[eSimulatedPinSensor] ? std::min( _period, kSensorPulse * _period ) : _period;
+            const double remaining = target - _travel;
+            if ( remaining > 0.0 )
+            {
+                _condition.wait_for( lock, std::chrono::duration<double>( remaining ) );
+            }
+        }
+        else
+        {
+            _condition.wait( lock );
+        }
+        if ( _stopped )
+        {
+            break;
+        }
+
+        const Clock::time_point now = Clock::now();
+        advance( now );
+        bool edge = false;
+        if ( _values[eSimulatedPinSensor] && _travel >= kSensorPulse * _period )
+        {
+            _values[eSimulatedPinSensor] = false;
+        }
+        else if ( _travel >= _period )
+        {
+            _travel -= _period;
+            _period = nextPeriod();
+            _firstFrame = false;
+            _values[eSimulatedPinSensor] = true;
+            edge = true;
+            if ( _nbFrames && !_edgeStopped )
+            {
+                ++_violations[eViolationMissedFrame];
+            }
+            if ( _nbFrames )
+            {
+                addSample( eSegmentFramePeriod, now );
+            }
+            ++_nbFrames;
+            _lastEdge = now;
+            _edgeLit = false;
+            _edgeStopped = false;
+        }
+        else
+        {
+            continue;
+        }
+
+        // The slots drive the motor, which takes the lock
+        SimulatedGpio * sensor = _sensor;
+        lock.unlock();
+        if ( sensor )
+        {
+            sensor->emitValue( edge, now );
+        }
+        lock.lock();
+    }
+}
+
+void SimulatedFilmTransport::setOutput( const ESimulatedPin pin, const bool value )
+{
+    {
+        std::unique_lock<std::mutex> lock( _mutex );
+        const Clock::time_point now = Clock::now();
+        advance( now );
+        const bool wasLit = _values[eSimulatedPinFlash] || _projectorLit;
+        const bool previous = _values[pin];
+        _values[pin] = value;
+        if ( pin == eSimulatedPinMotor && _nbFrames )
+        {
+            // The first frame comes with the motor already stopped
+            if ( !value && !_edgeStopped )
+            {
+                _edgeStopped = true;
+                addSample( eSegmentEdgeToMotorStop, now );
+            }
+            else if ( value && !previous && _edgeStopped )
+            {
+                addSample( eSegmentEdgeToMotorRestart, now );
+            }
+        }
+        lightChanged( wasLit, now );
+    }
+    _condition.notify_all();
+}
+
+void SimulatedFilmTransport::setProjectorLight( const bool on )
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    const Clock::time_point now = Clock::now();
+    advance( now );
+    const bool wasLit = _values[eSimulatedPinFlash] || _projectorLit;
+    _projectorLit = on;
+    lightChanged( wasLit, now );
+}
+
+void SimulatedFilmTransport::lightChanged( const bool wasLit, const Clock::time_point & now )
+{
+    const bool lit = _values[eSimulatedPinFlash] || _projectorLit;
+    // The first frame moves on its own, before any motor command
+    if ( lit && _values[eSimulatedPinMotor] )
+    {
+        ++_violations[eViolationLightWhileMoving];
+    }
+    if ( lit && !wasLit && _nbFrames && !_edgeLit )
+    {
+        _edgeLit = true;
+        addSample( eSegmentEdgeToLight, now );
+    }
+}
+
+void SimulatedFilmTransport::addSample( const ESegment segment, const Clock::time_point & now )
+{
+    std::deque<boost::int64_t> & samples = _samples[segment];
+    samples.push_back( std::chrono::duration_cast<std::chrono::microseconds>( now - _lastEdge ).count() );
+    if ( samples.size() > kMaxSamples )
+    {
+        samples.pop_front();
+    }
+}
+
+bool SimulatedFilmTransport::value( const ESimulatedPin pin ) const
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    return _values[pin];
+}
+
+std::size_t SimulatedFilmTransport::nbFrames() const
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    return _nbFrames;
+}
+
+std::size_t SimulatedFilmTransport::nbViolations() const
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    std::size_t n = 0;
+    for( std::size_t v = 0; v < eNbViolations; ++v )
+    {
+        n += _violations[v];
+    }
+    return n;
+}
+
+bool SimulatedFilmTransport::writeReport( const std::string & filename ) const
+{
+    std::ofstream file;
+    if ( !filename.empty() )
+    {
+        file.open( filename.c_str() );
+        if ( !file.is_open() )
+        {
+            std::cerr << "OPERATION FAILED: Unable to write simulation report: " << filename << std::endl;
+            return true;
+        }
+    }
+    std::ostream & out = filename.empty() ? std::cout : file;
+
+    std::unique_lock<std::mutex> lock( _mutex );
+    const double seconds = std::chrono::duration<double>( Clock::now() - _start ).count();
+    out << boost::format( "# %1% frames in %2$.1f s: %3$.2f frames per second (film speed %4$.2f)\n" )
+        % _nbFrames % seconds % ( seconds > 0.0 ? _nbFrames / seconds : 0.0 ) % ( 1.0 / _framePeriod );
+    out << boost::format( "%-45s %8s %10s %10s\n" ) % "segment (ms)" % "samples" % "p50" % "p99";
+    for( std::size_t segment = 0; segment < eNbSegments; ++segment )
+    {
+        std::vector<boost::int64_t> values( _samples[segment].begin(), _samples[segment].end() );
+        if ( values.empty() )
+        {
+            continue;
+        }
+        const double p50 = percentile( values, 0.5 ) / 1000.0;
+        const double p99 = percentile( values, 0.99 ) / 1000.0;
+        out << boost::format( "%-45s %8d %10.3f %10.3f\n" ) % kSegmentNames[segment] % values.size() % p50 % p99;
+    }
+    for( std::size_t v = 0; v < eNbViolations; ++v )
+    {
+        out << boost::format( "violation: %-34s %8d\n" ) % kViolationNames[v] % _violations[v];
+    }
+    out.flush();
+    return false;
+}
+
+}
@@ -0,0 +1,237 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#ifndef _KALI_SIMULATEDHARDWARE_HPP_
+#define	_KALI_SIMULATEDHARDWARE_HPP_
+
+#include "../IGpio.hpp"
+#include "../projector/IProjector.hpp"
+
+#include <boost/cstdint.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace kaliscope
+{
+
+class SimulatedFilmTransport;
+
+/**
+ * @brief pins of the simulated film transport
+ */
+enum ESimulatedPin
+{
+    eSimulatedPinSensor = 0,        ///< Frame sensor (input)
+    eSimulatedPinMotor,             ///< Motor (output)
+    eSimulatedPinFlash,             ///< Flash (output)
+    eNbSimulatedPins
+};
+
+/**
+ * @brief a pin of the simulated film transport
+ */
+class SimulatedGpio : public IGpio
+{
+public:
+    SimulatedGpio( SimulatedFilmTransport & transport, const ESimulatedPin pin, const std::size_t gpioId );
+    virtual ~SimulatedGpio();
+
+    virtual void startWatching( const std::size_t microsecDelay = 0 );
+    virtual void stop();
+    virtual bool exportGpio();
+    virtual bool unexportGpio();
+    virtual bool setDirGpio( const std::string & dir );
+    virtual bool setValGpio( const bool value );
+    virtual bool getValGpio( bool & val );
+
+    /**
+     * @brief value change from the transport (sensor pin)
+     */
+    void emitValue( const bool value, const std::chrono::steady_clock::time_point & time );
+
+private:
+    SimulatedFilmTransport & _transport;
+    const ESimulatedPin _pin;
+};
+
+/**
+ * @brief projector of the simulated film transport, only its light matters
+ */
+class SimulatedProjector : public IProjector
+{
+public:
+    SimulatedProjector( SimulatedFilmTransport & transport );
+    virtual ~SimulatedProjector();
+
+    virtual void init();
+    void switchOn();
+    void switchOff();
+    void projectColor( const unsigned char r, const unsigned char g, const unsigned char b );
+    void projectImage( const unsigned char *rgb, const std::size_t width, const std::size_t height );
+
+private:
+    SimulatedFilmTransport & _transport;
+};
+
+/**
+ * @brief simulated film transport, to run kalisync without the hardware
+ * The film moves while the motor runs, the sensor gives an edge each time
+ * a frame has passed (1 / fps of motor time, plus a uniform jitter). The
+ * first frame passes right after start, the motor is then driven by
+ * kalisync.
+ *
+ * The motor, flash and projector timings are recorded and the invariants
+ * of the capture loop are checked:
+ *  - no light while the film moves (blurred frame),
+ *  - the motor is stopped before the next frame passes (missed frame).
+ */
+class SimulatedFilmTransport
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+     * @param fps[in] film speed in frames per second of motor time
+     * @param jitterMs[in] maximum jitter of a frame period (milliseconds)
+     */
+    SimulatedFilmTransport( const double fps = 24.0, const double jitterMs = 1.0 );
+    ~SimulatedFilmTransport();
+
+    /**
+     * @brief create a pin, the transport must outlive it
+     */
+    std::unique_ptr<IGpio> createGpio( const ESimulatedPin pin, const std::size_t gpioId );
+
+    /**
+     * @brief create the projector, the transport must outlive it
+     */
+    std::unique_ptr<IProjector> createProjector();
+
+    /**
+     * @brief start moving the film (sensor pin watching)
+     */
+    void start();
+
+    /**
+     * @brief stop the film
+     */
+    void stop();
+
+    /**
+     * @brief output pin changed
+     */
+    void setOutput( const ESimulatedPin pin, const bool value );
+
+    /**
+     * @brief projector light changed
+     */
+    void setProjectorLight( const bool on );
+
+    /**
+     * @brief current value of a pin
+     */
+    bool value( const ESimulatedPin pin ) const;
+
+    /**
+     * @brief number of frames passed
+     */
+    std::size_t nbFrames() const;
+
+    /**
+     * @brief number of invariant violations
+     */
+    std::size_t nbViolations() const;
+
+    /**
+     * @brief write timings (p50/p99) and violations
+     * @param filename output file, empty for the standard output
+     * @return false on success, true if error
+     */
+    bool writeReport( const std::string & filename ) const;
+
+private:
+    enum ESegment
+    {
+        eSegmentEdgeToMotorStop = 0,
+        eSegmentEdgeToLight,
+        eSegmentEdgeToMotorRestart,
+        eSegmentFramePeriod,
+        eNbSegments
+    };
+
+    enum EViolation
+    {
+        eViolationLightWhileMoving = 0,
+        eViolationMissedFrame,
+        eNbViolations
+    };
+
+    /**
+     * @brief film moving thread
+     */
+    void worker();
+
+    /**
+     * @brief move the film for the motor time elapsed since the last update
+     */
+    void advance( const Clock::time_point & now );
+
+    /**
+     * @brief is the film moving
+     */
+    bool isMoving() const;
+
+    /**
+     * @brief light changed (flash or projector)
+     */
+    void lightChanged( const bool wasLit, const Clock::time_point & now );
+
+    /**
+     * @brief record a duration since the last edge
+     */
+    void addSample( const ESegment segment, const Clock::time_point & now );
+
+    /**
+     * @brief draw the next frame period
+     */
+    double nextPeriod();
+
+private:
+    mutable std::mutex _mutex;
+    std::condition_variable _condition;         ///< Wakes the film thread up on motor changes
+    std::unique_ptr<std::thread> _thread;       ///< Film moving thread
+    bool _stopped = true;
+    SimulatedGpio * _sensor = nullptr;          ///< Sensor pin, receives the edges
+
+    const double _framePeriod;                  ///< Seconds of motor time per frame
+    const double _jitter;                       ///< Maximum jitter (seconds)
+    std::mt19937 _random;                       ///< Jitter generator (fixed seed, runs are reproducible)
+    double _travel = 0.0;                       ///< Motor time since the last edge (seconds)
+    double _period = 0.0;                       ///< Motor time of the current frame (seconds)
+    bool _firstFrame = true;                    ///< The first frame passes without the motor
+    Clock::time_point _lastUpdate;              ///< Last travel update
+    bool _values[eNbSimulatedPins];             ///< Pin values
+    bool _projectorLit = false;                 ///< Projector light
+
+    Clock::time_point _start;                   ///< Start time
+    Clock::time_point _lastEdge;                ///< Last sensor edge
+    bool _edgeLit = false;                      ///< The frame of the last edge has been lit
+    bool _edgeStopped = false;                  ///< The motor has been stopped since the last edge
+    std::size_t _nbFrames = 0;                  ///< Number of frames passed
+    std::size_t _violations[eNbViolations];     ///< Invariant violations
+    std::vector< std::deque<boost::int64_t> > _samples; ///< Latest samples of each segment (microseconds)
+};
+
+}
+
+#endif
@@ -0,0 +1,133 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#include "FairThreadPool.hpp"
+
+#include <iostream>
+
+namespace kaliscope
+{
+
+FairThreadPool::FairThreadPool( const std::size_t nbThreads )
+{
+    std::size_t n = nbThreads ? nbThreads : std::thread::hardware_concurrency();
+    if ( n == 0 )
+    {
+        n = 1;
+    }
+    for( std::size_t i = 0; i < n; ++i )
+    {
+        _workers.emplace_back( new std::thread( &FairThreadPool::work, this ) );
+    }
+}
+
+FairThreadPool::~FairThreadPool()
+{
+    stop();
+}
+
+std::size_t FairThreadPool::addQueue()
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    _queues.push_back( Queue() );
+    return _queues.size() - 1;
+}
+
+void FairThreadPool::post( const std::size_t queue, const Task & task )
+{
+    {
+        std::unique_lock<std::mutex> lock( _mutex );
+        if ( _stopped )
+        {
+            return;
+        }
+        _queues[queue].tasks.push_back( task );
+    }
+    _condition.notify_one();
+}
+
+std::size_t FairThreadPool::nbPending() const
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    std::size_t n = _nbRunning;
+    for( const Queue & q: _queues )
+    {
+        n += q.tasks.size();
+    }
+    return n;
+}
+
+void FairThreadPool::stop()
+{
+    {
+        std::unique_lock<std::mutex> lock( _mutex );
+        _stopped = true;
+        for( Queue & q: _queues )
+        {
+            q.tasks.clear();
+        }
+    }
+    _condition.notify_all();
+    for( std::unique_ptr<std::thread> & worker: _workers )
+    {
+        if ( worker->joinable() )
+        {
+            worker->join();
+        }
+    }
+    _workers.clear();
+}
+
+std::size_t FairThreadPool::nextQueue() const
+{
+    for( std::size_t i = 0; i < _queues.size(); ++i )
+    {
+        const std::size_t index = ( _next + i ) % _queues.size();
+        const Queue & q = _queues[index];
+        if ( !q.busy && !q.tasks.empty() )
+        {
+            return index;
+        }
+    }
+    return _queues.size();
+}
+
+void FairThreadPool::work()
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    while( !_stopped )
+    {
+        const std::size_t index = nextQueue();
+        if ( index == _queues.size() )
+        {
+            _condition.wait( lock );
+            continue;
+        }
+        Queue & q = _queues[index];
+        const Task task = q.tasks.front();
+        q.tasks.pop_front();
+        q.busy = true;
+        ++_nbRunning;
+        _next = index + 1;
+
+        lock.unlock();
+        try
+        {
+            task();
+        }
+        catch( ... )
+        {
+            std::cerr << "OPERATION FAILED: processing task failed." << std::endl;
+        }
+        lock.lock();
+
+        _queues[index].busy = false;
+        --_nbRunning;
+        // The queue may have other tasks for an idle worker
+        _condition.notify_all();
+    }
+}
+
+}
@@ -0,0 +1,90 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#ifndef _KALICORE_FAIRTHREADPOOL_HPP_
+#define	_KALICORE_FAIRTHREADPOOL_HPP_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace kaliscope
+{
+
+/**
+ * @brief thread pool shared by several producers (capture stations)
+ * Each producer has its own queue. Workers serve the queues round robin,
+ * and run at most one task of a queue at a time: the tasks of a queue use
+ * the same processing graph, and a busy station can't starve the others.
+ */
+class FairThreadPool
+{
+public:
+    typedef std::function<void()> Task;
+
+    /**
+     * @param nbThreads number of workers, 0 means one per hardware thread
+     */
+    FairThreadPool( const std::size_t nbThreads = 0 );
+    ~FairThreadPool();
+
+    /**
+     * @brief add a queue
+     * @return the queue index
+     */
+    std::size_t addQueue();
+
+    /**
+     * @brief queue a task
+     * @param queue queue index
+     * @param task the task
+     */
+    void post( const std::size_t queue, const Task & task );
+
+    /**
+     * @brief number of tasks queued or running
+     */
+    std::size_t nbPending() const;
+
+    /**
+     * @brief wait for the running tasks, drop the queued ones and stop the workers
+     */
+    void stop();
+
+private:
+    /**
+     * @brief worker loop
+     */
+    void work();
+
+    /**
+     * @brief next queue to serve, round robin from _next
+     * @return the queue index, _queues.size() if none is ready
+     */
+    std::size_t nextQueue() const;
+
+private:
+    struct Queue
+    {
+        std::deque<Task> tasks;
+        bool busy = false;                          ///< A task of the queue is running
+    };
+
+    mutable std::mutex _mutex;
+    std::condition_variable _condition;             ///< Signals new tasks and freed queues
+    std::vector<Queue> _queues;                     ///< One queue per producer
+    std::size_t _next = 0;                          ///< Queue served first by the next worker
+    std::size_t _nbRunning = 0;                     ///< Number of running tasks
+    bool _stopped = false;
+    std::vector< std::unique_ptr<std::thread> > _workers;
+};
+
+}
+
+#endif
@@ -0,0 +1,100 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#include "FlatFieldCalibration.hpp"
+
+#include <tuttle/host/attribute/Image.hpp>
+
+#include <iostream>
+
+namespace kaliscope
+{
+
+FlatFieldCalibration::FlatFieldCalibration()
+{
+}
+
+void FlatFieldCalibration::start( const std::size_t nbFrames, const std::string & gainMapPath )
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    _nbFrames = nbFrames;
+    _gainMapPath = gainMapPath;
+    // Sized on the first frame
+    _accumulator.reset( 0, 0, 0 );
+}
+
+void FlatFieldCalibration::cancel()
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    _nbFrames = 0;
+}
+
+bool FlatFieldCalibration::isRunning() const
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    return _nbFrames != 0;
+}
+
+bool FlatFieldCalibration::addFrame( const DefaultImageT & frame )
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    if ( !_nbFrames || !frame )
+    {
+        return false;
+    }
+    const std::size_t width = frame->getBounds().x2 - frame->getBounds().x1;
+    const std::size_t height = frame->getBounds().y2 - frame->getBounds().y1;
+    const std::size_t nbComponents = frame->getNbComponents();
+    if ( nbComponents < 3 )
+    {
+        std::cerr << "OPERATION FAILED: flat field calibration needs rgb frames." << std::endl;
+        _nbFrames = 0;
+        return false;
+    }
+    if ( _accumulator.nbFrames() == 0 )
+    {
+        _accumulator.reset( width, height, 3 );
+    }
+
+    // Gains are relative: the samples are only brought to [0, 1] for precision
+    // Rows may be padded: they are read in memory order, like the plugins see them
+    const void* data = frame->getPixelData();
+    const std::size_t rowBytes = frame->getRowAbsDistanceBytes();
+    switch( frame->getBitDepth() )
+    {
+        case 1:
+            _accumulator.add( static_cast<const unsigned char*>( data ), rowBytes, nbComponents, 1.0f / 255.0f );
+            break;
+        case 2:
+            _accumulator.add( static_cast<const unsigned short*>( data ), rowBytes, nbComponents, 1.0f / 65535.0f );
+            break;
+        case 4:
+            _accumulator.add( static_cast<const float*>( data ), rowBytes, nbComponents, 1.0f );
+            break;
+        default:
+            std::cerr << "OPERATION FAILED: unhandled bit depth for flat field calibration: " << frame->getBitDepth() << std::endl;
+            _nbFrames = 0;
+            return false;
+    }
+
+    if ( _accumulator.nbFrames() < _nbFrames )
+    {
+        return false;
+    }
+    _nbFrames = 0;
+    terry::color::GainMap gainMap;
+    _accumulator.gainMap( gainMap );
+    if ( !terry::color::writeGainMap( _gainMapPath, gainMap ) )
+    {
+        std::cerr << "OPERATION FAILED: Unable to write flat field gain map: " << _gainMapPath << std::endl;
+    }
+    else
+    {
+        std::cout << "Flat field gain map written: " << _gainMapPath << std::endl;
+    }
+    return true;
+}
+
+}
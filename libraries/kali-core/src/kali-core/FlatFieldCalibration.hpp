@@ -0,0 +1,64 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#ifndef _KALICORE_FLATFIELDCALIBRATION_HPP_
+#define	_KALICORE_FLATFIELDCALIBRATION_HPP_
+
+#include "typedefs.hpp"
+
+#include <terry/color/flatField.hpp>
+
+#include <mutex>
+#include <string>
+
+namespace kaliscope
+{
+
+/**
+ * @brief flat field calibration
+ * Averages frames of a uniform field (kalisync projects it with the
+ * projector) into a gain map, written once and applied by the
+ * ColorNegInvert plugin. Frames are the reader output, before any
+ * processing.
+ */
+class FlatFieldCalibration
+{
+public:
+    FlatFieldCalibration();
+
+    /**
+     * @brief start a calibration
+     * @param nbFrames number of frames to average
+     * @param gainMapPath output gain map file
+     */
+    void start( const std::size_t nbFrames, const std::string & gainMapPath );
+
+    /**
+     * @brief stop the calibration without writing the gain map
+     */
+    void cancel();
+
+    /**
+     * @brief is a calibration running
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief add a frame of the uniform field
+     * @param frame the reader output
+     * @return true when the last frame has been added and the gain map written
+     */
+    bool addFrame( const DefaultImageT & frame );
+
+private:
+    mutable std::mutex _mutex;                  ///< Frames are added from the player thread
+    std::size_t _nbFrames = 0;                  ///< Number of frames to average, 0 if not running
+    std::string _gainMapPath;                   ///< Output gain map file
+    terry::color::FlatFieldAccumulator _accumulator;    ///< Average of the frames
+};
+
+}
+
+#endif
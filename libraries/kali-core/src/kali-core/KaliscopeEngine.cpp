@@ -4,6 +4,7 @@
  */
 
 #include "KaliscopeEngine.hpp"
+#include "LatencyTracer.hpp"
 
 #include <boost/algorithm/string/predicate.hpp>
 
@@ -80,7 +81,24 @@ void KaliscopeEngine::playWork()
                     {
                         _videoPlayer->setOutputFilename( nFrame, std::ceil( timeDomain.max ), _outputFilePathPrefix, _outputFileExtension );
                     }
-                    image = _videoPlayer->getFrame();
+                    // The sensor is free as soon as the reader has run,
+                    // the rest of the graph is processed meanwhile
+                    LatencyTracer::getInstance().stamp( eSyncHopCaptureStarted );
+                    const DefaultImageT captured = _videoPlayer->captureFrame();
+                    if ( captured )
+                    {
+                        signalFrameExposed( nFrame, captured );
+                    }
+                    if ( _processingPool )
+                    {
+                        // Reported by the pool, frameProcessed() lets us capture the next one
+                        _processingPool->post( _processingQueue, [this, nFrame]() { processFrame( nFrame ); } );
+                    }
+                    else
+                    {
+                        image = _videoPlayer->getFrame();
+                        LatencyTracer::getInstance().stamp( eSyncHopFrameProcessed );
+                    }
                 }
                 else
                 {
@@ -94,17 +112,21 @@ void KaliscopeEngine::playWork()
             }
             if ( !_stopped )
             {
-                if ( image )
+                // With a processing pool, the frame is reported by processFrame
+                if ( !_processingPool )
                 {
-                    signalFrameReady( nFrame, image );
-                }
-                else
-                {
-                    std::cerr << "Unable to read frame!" << std::endl;
-                    break;
+                    if ( image )
+                    {
+                        signalFrameReady( nFrame, image );
+                    }
+                    else
+                    {
+                        std::cerr << "Unable to read frame!" << std::endl;
+                        break;
+                    }
                 }
                 _semaphoreSynchro.wait();
-                if ( _frameStepping )
+                if ( _frameStepping && !_stopped )
                 {
                     _semaphoreFrameStepping.wait();
                 }
@@ -120,6 +142,26 @@ void KaliscopeEngine::playWork()
     _stopped = true;
 }
 
+/**
+ * @brief process a captured frame (pool task)
+ * @param nFrame frame number
+ */
+void KaliscopeEngine::processFrame( const double nFrame )
+{
+    const DefaultImageT image = _videoPlayer->getFrame( nFrame );
+    LatencyTracer::getInstance().stamp( eSyncHopFrameProcessed );
+    if ( image && !_stopped )
+    {
+        signalFrameReady( nFrame, image );
+    }
+    else if ( !image )
+    {
+        std::cerr << "Unable to read frame!" << std::endl;
+        _stopped = true;
+        _semaphoreSynchro.post();
+    }
+}
+
 /**
  * @brief stop playing
  */
@@ -8,6 +8,7 @@
 
 #include "typedefs.hpp"
 #include "VideoPlayer.hpp"
+#include "FairThreadPool.hpp"
 
 #include <mvp-player-core/MVPPlayerEngine.hpp>
 
@@ -76,6 +77,15 @@ public:
     void setFrameStepping( const bool active = true )
     { _frameStepping = active; }
 
+    /**
+     * @brief process the captured frames in a shared pool instead of the
+     *        player thread (several engines, one per capture station)
+     * @param pool the pool, nullptr to process in the player thread
+     * @param queue queue of this engine in the pool
+     */
+    void setProcessingPool( FairThreadPool * pool, const std::size_t queue = 0 )
+    { _processingPool = pool; _processingQueue = queue; }
+
     /**
      * @brief process next frame
      */
@@ -118,8 +128,15 @@ private:
      */
     void playWork();
 
+    /**
+     * @brief process a captured frame (pool task)
+     * @param nFrame frame number
+     */
+    void processFrame( const double nFrame );
+
 // Signals
 public:
+    boost::signals2::signal<void( const std::size_t nFrame, const DefaultImageT captured )> signalFrameExposed; ///< Signals that a frame has been read from the sensor (reader output), before being processed
     boost::signals2::signal<void( const std::size_t nFrame, const DefaultImageT image )> signalFrameReady;   ///< Signals that a new frame is ready
 
 // Various
@@ -132,6 +149,8 @@ private:
     std::string _outputFileExtension;                   ///< Output file extension
     bool _isInputSequence = false;                      ///< Is input a sequence ?
     bool _isOutputSequence = false;                     ///< Is output a sequence ?
+    FairThreadPool *_processingPool = nullptr;          ///< Shared processing pool, null to process in the player thread
+    std::size_t _processingQueue = 0;                   ///< Queue of this engine in the processing pool
 
 // Thread related
 private:
@@ -0,0 +1,271 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#include "LatencyTracer.hpp"
+#include "SyncMessage.hpp"
+
+#include <boost/format.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+namespace kaliscope
+{
+
+namespace
+{
+
+/// Number of samples kept for each segment
+static const std::size_t kMaxSamples( 1000 );
+
+/**
+ * @brief a segment of the chain between two hops stamped by the same process
+ */
+struct Segment
+{
+    const char * name;
+    ESyncHop from;
+    ESyncHop to;
+};
+
+static const Segment kSegments[] =
+{
+    { "gpio edge -> trigger sent",              eSyncHopGpioEdge,           eSyncHopTriggerSent },
+    { "trigger received -> capture started",    eSyncHopTriggerReceived,    eSyncHopCaptureStarted },
+    { "capture",                                eSyncHopCaptureStarted,     eSyncHopExposureSent },
+    { "processing",                             eSyncHopExposureSent,       eSyncHopFrameProcessed },
+    { "frame processed -> reply sent",          eSyncHopFrameProcessed,     eSyncHopReplySent },
+    { "exposure received -> motor restarted",   eSyncHopExposureReceived,   eSyncHopMotorRestarted },
+    { "gpio edge -> motor restarted",           eSyncHopGpioEdge,           eSyncHopMotorRestarted },
+};
+static const std::size_t kNbSegments( sizeof( kSegments ) / sizeof( Segment ) );
+/// Network one way latency: half of the round trip without the kaliscope time
+static const std::size_t kNetworkSegment( kNbSegments );
+/// Time between two GPIO edges, what bounds the frames per minute
+static const std::size_t kFramePeriodSegment( kNbSegments + 1 );
+static const std::size_t kNbAllSegments( kNbSegments + 2 );
+
+std::string segmentName( const std::size_t segment )
+{
+    if ( segment == kNetworkSegment )
+    { return "network one way (estimated)"; }
+    else if ( segment == kFramePeriodSegment )
+    { return "frame period (gpio edge -> gpio edge)"; }
+    return kSegments[segment].name;
+}
+
+boost::int64_t percentile( std::vector<boost::int64_t> & values, const double p )
+{
+    std::vector<boost::int64_t>::iterator nth = values.begin() + static_cast<std::ptrdiff_t>( p * ( values.size() - 1 ) );
+    std::nth_element( values.begin(), nth, values.end() );
+    return *nth;
+}
+
+}
+
+LatencyTracer::LatencyTracer()
+: _nextFrameId( 1 )
+, _nbCompleted( 0 )
+, _lastGpioEdge( 0 )
+, _samples( kNbAllSegments )
+{}
+
+boost::uint64_t LatencyTracer::begin()
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    push( SyncTrace( _nextFrameId ) );
+    return _nextFrameId++;
+}
+
+void LatencyTracer::beginRemote()
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    push( SyncTrace() );
+}
+
+void LatencyTracer::push( const SyncTrace & trace )
+{
+    _traces.push_back( trace );
+    if ( _traces.size() > kMaxTracesInFlight )
+    {
+        // Never completed (no reply, or the other process doesn't trace)
+        _traces.pop_front();
+    }
+}
+
+void LatencyTracer::setFrameId( const boost::uint64_t frameId )
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    if ( !_traces.empty() )
+    {
+        _traces.back().frameId = frameId;
+    }
+}
+
+void LatencyTracer::stamp( const ESyncHop hop, const Clock::time_point & time )
+{
+    const boost::int64_t us = std::chrono::duration_cast<std::chrono::microseconds>( time.time_since_epoch() ).count();
+    std::unique_lock<std::mutex> lock( _mutex );
+    if ( hop == eSyncHopGpioEdge )
+    {
+        if ( _lastGpioEdge )
+        {
+            addSample( kFramePeriodSegment, us - _lastGpioEdge );
+        }
+        _lastGpioEdge = us;
+    }
+    if ( _traces.empty() )
+    {
+        // Not triggered (playing a file)
+        _traces.push_back( SyncTrace() );
+    }
+    const bool trigger = hop <= eSyncHopTriggerReceived;
+    SyncTrace & trace = trigger ? _traces.back() : _traces.front();
+    trace.stamps[hop] = us;
+}
+
+SyncTrace LatencyTracer::newest() const
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    return _traces.empty() ? SyncTrace() : _traces.back();
+}
+
+SyncTrace LatencyTracer::oldest() const
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    return _traces.empty() ? SyncTrace() : _traces.front();
+}
+
+void LatencyTracer::newest( SyncMessage & message ) const
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    copy( _traces.empty() ? SyncTrace() : _traces.back(), message );
+}
+
+void LatencyTracer::oldest( SyncMessage & message ) const
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    copy( _traces.empty() ? SyncTrace() : _traces.front(), message );
+}
+
+void LatencyTracer::copy( const SyncTrace & trace, SyncMessage & message )
+{
+    message.frameId = trace.frameId;
+    std::copy( trace.stamps.begin(), trace.stamps.end(), message.stamps );
+}
+
+void LatencyTracer::merge( const SyncTrace & remote )
+{
+    if ( remote.stamps.size() == eNbSyncHops )
+    {
+        std::unique_lock<std::mutex> lock( _mutex );
+        merge( remote.frameId, &remote.stamps[0] );
+    }
+}
+
+void LatencyTracer::merge( const SyncMessage & remote )
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    merge( remote.frameId, remote.stamps );
+}
+
+void LatencyTracer::merge( const boost::uint64_t frameId, const boost::int64_t * stamps )
+{
+    for( std::deque<SyncTrace>::iterator it = _traces.begin(); it != _traces.end(); ++it )
+    {
+        if ( it->frameId == frameId )
+        {
+            for( std::size_t hop = 0; hop < eNbSyncHops; ++hop )
+            {
+                if ( !it->stamps[hop] )
+                {
+                    it->stamps[hop] = stamps[hop];
+                }
+            }
+            record( *it );
+            _traces.erase( it );
+            return;
+        }
+    }
+}
+
+void LatencyTracer::complete()
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    if ( !_traces.empty() )
+    {
+        record( _traces.front() );
+        _traces.pop_front();
+    }
+}
+
+void LatencyTracer::record( const SyncTrace & t )
+{
+    for( std::size_t segment = 0; segment < kNbSegments; ++segment )
+    {
+        const Segment & s = kSegments[segment];
+        if ( t.has( s.from ) && t.has( s.to ) )
+        {
+            addSample( segment, t.stamps[s.to] - t.stamps[s.from] );
+        }
+    }
+    if ( t.has( eSyncHopTriggerSent ) && t.has( eSyncHopTriggerReceived ) &&
+         t.has( eSyncHopExposureSent ) && t.has( eSyncHopExposureReceived ) )
+    {
+        const boost::int64_t roundTrip = t.stamps[eSyncHopExposureReceived] - t.stamps[eSyncHopTriggerSent];
+        const boost::int64_t remote = t.stamps[eSyncHopExposureSent] - t.stamps[eSyncHopTriggerReceived];
+        addSample( kNetworkSegment, ( roundTrip - remote ) / 2 );
+    }
+    ++_nbCompleted;
+}
+
+std::size_t LatencyTracer::nbCompleted() const
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    return _nbCompleted;
+}
+
+void LatencyTracer::addSample( const std::size_t segment, const boost::int64_t microseconds )
+{
+    std::deque<boost::int64_t> & samples = _samples[segment];
+    samples.push_back( microseconds );
+    if ( samples.size() > kMaxSamples )
+    {
+        samples.pop_front();
+    }
+}
+
+bool LatencyTracer::writeReport( const std::string & filename ) const
+{
+    std::ofstream file( filename.c_str() );
+    if ( !file.is_open() )
+    {
+        std::cerr << "OPERATION FAILED: Unable to write latency report: " << filename << std::endl;
+        return true;
+    }
+
+    std::unique_lock<std::mutex> lock( _mutex );
+    file << boost::format( "# %1% frames traced, last %2% samples per segment, in milliseconds\n" ) % _nbCompleted % kMaxSamples;
+    file << boost::format( "%-45s %8s %10s %10s\n" ) % "segment" % "samples" % "p50" % "p99";
+    for( std::size_t segment = 0; segment < kNbAllSegments; ++segment )
+    {
+        std::vector<boost::int64_t> values( _samples[segment].begin(), _samples[segment].end() );
+        if ( values.empty() )
+        {
+            continue;
+        }
+        const double p50 = percentile( values, 0.5 ) / 1000.0;
+        const double p99 = percentile( values, 0.99 ) / 1000.0;
+        file << boost::format( "%-45s %8d %10.3f %10.3f\n" ) % segmentName( segment ) % values.size() % p50 % p99;
+        if ( segment == kFramePeriodSegment && p50 > 0.0 )
+        {
+            file << boost::format( "# %.1f frames per minute (median period)\n" ) % ( 60000.0 / p50 );
+        }
+    }
+    return false;
+}
+
+}
@@ -0,0 +1,205 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#ifndef _KALICORE_LATENCYTRACER_HPP_
+#define	_KALICORE_LATENCYTRACER_HPP_
+
+#include <mvp-player-core/Singleton.hpp>
+
+#include <boost/cstdint.hpp>
+#include <boost/serialization/vector.hpp>
+
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace kaliscope
+{
+
+/// Latency reports are written every kLatencyReportPeriod traced frames
+static const std::size_t kLatencyReportPeriod( 50 );
+
+/// Maximum number of frames traced at the same time (the motor restarts before the frame is processed)
+static const std::size_t kMaxTracesInFlight( 4 );
+
+/**
+ * @brief hops of the capture synchronization chain, in order
+ * kalisync stamps the GPIO edge, trigger sent, exposure received and motor
+ * restarted hops, kaliscope stamps the others.
+ */
+enum ESyncHop
+{
+    eSyncHopGpioEdge = 0,           ///< GPIO edge detected (kalisync)
+    eSyncHopTriggerSent,            ///< EvNextTrack sent (kalisync)
+    eSyncHopTriggerReceived,        ///< EvNextTrack received (kaliscope)
+    eSyncHopCaptureStarted,         ///< frame capture started (kaliscope)
+    eSyncHopExposureSent,           ///< frame exposed event sent (kaliscope)
+    eSyncHopFrameProcessed,         ///< frame processed (kaliscope)
+    eSyncHopReplySent,              ///< frame captured event sent (kaliscope)
+    eSyncHopExposureReceived,       ///< frame exposed event received (kalisync)
+    eSyncHopMotorRestarted,         ///< motor restarted (kalisync)
+    eNbSyncHops
+};
+
+struct SyncMessage;
+
+/**
+ * @brief timestamps of one frame along the synchronization chain
+ * Timestamps are monotonic clock microseconds of the process that took them,
+ * 0 means not stamped.
+ */
+struct SyncTrace
+{
+    SyncTrace( const boost::uint64_t id = 0 )
+    : frameId( id )
+    , stamps( eNbSyncHops, 0 )
+    {}
+
+    inline bool has( const ESyncHop hop ) const
+    { return stamps[hop] != 0; }
+
+    friend class boost::serialization::access;
+    template<class Archive>
+    void serialize( Archive & ar, const unsigned int version )
+    {
+        ar & frameId;
+        ar & stamps;
+    }
+
+    boost::uint64_t frameId;
+    std::vector<boost::int64_t> stamps;
+};
+
+/**
+ * @brief frame trigger latency tracer
+ * Keeps the traces of the frames in flight, and the latency of each
+ * segment of the chain for the last frames. Both processes only compare
+ * timestamps of their own clock: the network legs are estimated from the
+ * round trip minus the time spent in kaliscope.
+ *
+ * A frame is triggered while the previous one may still be processed:
+ * trigger hops are stamped on the newest trace, the other hops on the
+ * oldest one (frames are captured and replied in order).
+ */
+class LatencyTracer : public mvpplayer::Singleton<LatencyTracer>
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    LatencyTracer();
+
+    /**
+     * @brief start the trace of a new frame
+     * @return the new frame id
+     */
+    boost::uint64_t begin();
+
+    /**
+     * @brief start the trace of a frame triggered by the other process, its
+     *        id comes later with the trace of the other process
+     */
+    void beginRemote();
+
+    /**
+     * @brief set the frame id of the newest trace
+     */
+    void setFrameId( const boost::uint64_t frameId );
+
+    /**
+     * @brief stamp a hop of the newest (trigger hops) or oldest frame
+     * @param hop the hop
+     * @param time when the hop happened
+     */
+    void stamp( const ESyncHop hop, const Clock::time_point & time = Clock::now() );
+
+    /**
+     * @brief get the trace of the last triggered frame
+     */
+    SyncTrace newest() const;
+
+    /**
+     * @brief get the trace of the oldest frame in flight
+     */
+    SyncTrace oldest() const;
+
+    /**
+     * @brief copy the trace of the last triggered frame into a sync message
+     */
+    void newest( SyncMessage & message ) const;
+
+    /**
+     * @brief copy the trace of the oldest frame in flight into a sync message
+     */
+    void oldest( SyncMessage & message ) const;
+
+    /**
+     * @brief merge the hops stamped by the other process into the trace of
+     *        the same frame (ignored if there is none), then complete it
+     * @param remote trace received from the other process
+     */
+    void merge( const SyncTrace & remote );
+
+    /**
+     * @brief merge the trace carried by a sync message (see merge)
+     */
+    void merge( const SyncMessage & remote );
+
+    /**
+     * @brief record the latencies of the oldest trace, and forget it
+     */
+    void complete();
+
+    /**
+     * @brief number of completed traces
+     */
+    std::size_t nbCompleted() const;
+
+    /**
+     * @brief write p50/p99 of each segment to a text file
+     * @param filename output file
+     * @return false on success, true if error
+     */
+    bool writeReport( const std::string & filename ) const;
+
+private:
+    /**
+     * @brief start a new trace, the oldest one is dropped if too many are in flight
+     */
+    void push( const SyncTrace & trace );
+
+    /**
+     * @brief copy a trace into a sync message
+     */
+    static void copy( const SyncTrace & trace, SyncMessage & message );
+
+    /**
+     * @brief merge remote hops into the trace of the same frame, then complete it
+     */
+    void merge( const boost::uint64_t frameId, const boost::int64_t * stamps );
+
+    /**
+     * @brief record the latencies of a trace
+     */
+    void record( const SyncTrace & trace );
+
+    /**
+     * @brief record one latency sample
+     */
+    void addSample( const std::size_t segment, const boost::int64_t microseconds );
+
+private:
+    mutable std::mutex _mutex;                          ///< Hops are stamped from several threads
+    std::deque<SyncTrace> _traces;                      ///< Traces of the frames in flight, oldest first
+    boost::uint64_t _nextFrameId;                       ///< Next frame id
+    std::size_t _nbCompleted;                           ///< Number of completed traces
+    boost::int64_t _lastGpioEdge;                       ///< Previous GPIO edge stamp, gives the frame period
+    std::vector< std::deque<boost::int64_t> > _samples; ///< Latest samples of each segment (microseconds)
+};
+
+}
+
+#endif
@@ -0,0 +1,76 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#ifndef _KALICORE_SPSCQUEUE_HPP_
+#define	_KALICORE_SPSCQUEUE_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace kaliscope
+{
+
+/**
+ * @brief bounded lock-free queue between one producer thread and one
+ *        consumer thread
+ * No lock and no allocation after construction: a real-time thread can push
+ * without ever waiting for the consumer. Items are copied in and out.
+ * @tparam Capacity maximum number of items, a power of two
+ */
+template<class T, std::size_t Capacity>
+class SpscQueue
+{
+    static_assert( Capacity && !( Capacity & ( Capacity - 1 ) ), "SpscQueue capacity must be a power of two" );
+public:
+    SpscQueue()
+    : _head( 0 )
+    , _tail( 0 )
+    {}
+
+    /**
+     * @brief add an item (producer thread only)
+     * @return false if the queue is full, true otherwise
+     */
+    bool push( const T & item )
+    {
+        const std::size_t tail = _tail.load( std::memory_order_relaxed );
+        if ( tail - _head.load( std::memory_order_acquire ) == Capacity )
+        {
+            return false;
+        }
+        _items[tail & ( Capacity - 1 )] = item;
+        _tail.store( tail + 1, std::memory_order_release );
+        return true;
+    }
+
+    /**
+     * @brief take the oldest item (consumer thread only)
+     * @return false if the queue is empty, true otherwise
+     */
+    bool pop( T & item )
+    {
+        const std::size_t head = _head.load( std::memory_order_relaxed );
+        if ( head == _tail.load( std::memory_order_acquire ) )
+        {
+            return false;
+        }
+        item = _items[head & ( Capacity - 1 )];
+        _head.store( head + 1, std::memory_order_release );
+        return true;
+    }
+
+    inline bool empty() const
+    { return _head.load( std::memory_order_acquire ) == _tail.load( std::memory_order_acquire ); }
+
+private:
+    std::array<T, Capacity> _items;                 ///< Ring buffer
+    alignas( 64 ) std::atomic<std::size_t> _head;   ///< Next item to pop, written by the consumer
+    alignas( 64 ) std::atomic<std::size_t> _tail;   ///< Next item to push, written by the producer
+};
+
+}
+
+#endif
@@ -0,0 +1,316 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#include "SyncLink.hpp"
+
+#include <chrono>
+#include <iostream>
+
+namespace kaliscope
+{
+
+using boost::asio::ip::udp;
+
+SyncLink::SyncLink()
+: _socket( _ioService )
+, _resendTimer( _ioService )
+, _hasPeer( false )
+, _stopped( true )
+// Numbers of a restarted kalisync must not look like requests already received
+, _nextSequence( std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count() + 1 )
+, _hasPendingRequest( false )
+, _nbSends( 0 )
+, _lastRequestSequence( 0 )
+, _hasLastReply( false )
+{
+}
+
+SyncLink::~SyncLink()
+{
+    close();
+}
+
+bool SyncLink::listen( const unsigned short port )
+{
+    close();
+    boost::system::error_code error;
+    _socket.open( udp::v4(), error );
+    if ( !error )
+    {
+        _socket.bind( udp::endpoint( udp::v4(), port ), error );
+    }
+    if ( error )
+    {
+        std::cerr << "OPERATION FAILED: Unable to listen on sync port " << port << ": " << error.message() << std::endl;
+        _socket.close( error );
+        return true;
+    }
+    start();
+    return false;
+}
+
+bool SyncLink::connect( const std::string & host, const unsigned short port )
+{
+    close();
+    boost::system::error_code error;
+    const boost::asio::ip::address address = boost::asio::ip::address::from_string( host, error );
+    if ( !error )
+    {
+        _socket.open( udp::v4(), error );
+    }
+    if ( !error )
+    {
+        _socket.bind( udp::endpoint( udp::v4(), 0 ), error );
+    }
+    if ( error )
+    {
+        std::cerr << "OPERATION FAILED: Unable to connect the sync link to " << host << ": " << error.message() << std::endl;
+        _socket.close( error );
+        return true;
+    }
+    {
+        std::unique_lock<std::mutex> lock( _mutexPeer );
+        _peer = udp::endpoint( address, port );
+        _hasPeer = true;
+    }
+    start();
+    return send( SyncMessage( eSyncActionHello ) );
+}
+
+void SyncLink::start()
+{
+    _stopped = false;
+    _ioService.reset();
+    asyncReceive();
+    _receiveThread.reset( new std::thread( [this]() { _ioService.run(); } ) );
+}
+
+void SyncLink::close()
+{
+    if ( _receiveThread )
+    {
+        // The peer stops sending to us
+        send( SyncMessage( eSyncActionBye ) );
+        _stopped = true;
+        // Abort the receive and the resend timer: run() returns once their handlers are called
+        _ioService.post(
+            [this]()
+            {
+                boost::system::error_code error;
+                _socket.cancel( error );
+                _resendTimer.cancel( error );
+            }
+        );
+        if ( _receiveThread->joinable() )
+        {
+            _receiveThread->join();
+        }
+        _receiveThread.reset();
+    }
+    if ( _socket.is_open() )
+    {
+        boost::system::error_code error;
+        _socket.close( error );
+    }
+    std::unique_lock<std::mutex> lock( _mutexPeer );
+    _hasPeer = false;
+    _hasPendingRequest = false;
+    _lastRequestSequence = 0;
+    _hasLastReply = false;
+}
+
+bool SyncLink::sendTo( const SyncMessage & message, const udp::endpoint & peer )
+{
+    unsigned char buffer[kSyncMessageSize];
+    encodeSyncMessage( message, buffer );
+    boost::system::error_code error;
+    _socket.send_to( boost::asio::buffer( buffer ), peer, 0, error );
+    if ( error )
+    {
+        std::cerr << "OPERATION FAILED: Unable to send sync message: " << error.message() << std::endl;
+        return true;
+    }
+    return false;
+}
+
+bool SyncLink::send( const SyncMessage & message )
+{
+    udp::endpoint peer;
+    {
+        std::unique_lock<std::mutex> lock( _mutexPeer );
+        if ( !_hasPeer )
+        {
+            return true;
+        }
+        peer = _peer;
+    }
+    return sendTo( message, peer );
+}
+
+bool SyncLink::request( const SyncMessage & message )
+{
+    SyncMessage numbered( message );
+    udp::endpoint peer;
+    {
+        std::unique_lock<std::mutex> lock( _mutexPeer );
+        if ( !_hasPeer )
+        {
+            return true;
+        }
+        numbered.sequence = _nextSequence++;
+        _pendingRequest = numbered;
+        _hasPendingRequest = true;
+        _nbSends = 1;
+        peer = _peer;
+    }
+    // A send error is handled like a lost datagram
+    sendTo( numbered, peer );
+    const boost::uint64_t sequence = numbered.sequence;
+    _ioService.post( [this, sequence]() { armResend( sequence ); } );
+    return false;
+}
+
+void SyncLink::cancelRequest()
+{
+    std::unique_lock<std::mutex> lock( _mutexPeer );
+    _hasPendingRequest = false;
+}
+
+bool SyncLink::reply( const SyncMessage & message )
+{
+    SyncMessage numbered( message );
+    udp::endpoint peer;
+    {
+        std::unique_lock<std::mutex> lock( _mutexPeer );
+        if ( !_hasPeer || _lastRequestSequence == 0 )
+        {
+            return true;
+        }
+        numbered.sequence = _lastRequestSequence;
+        // Sent again if the request comes again
+        _lastReply = numbered;
+        _hasLastReply = true;
+        peer = _peer;
+    }
+    return sendTo( numbered, peer );
+}
+
+void SyncLink::armResend( const boost::uint64_t sequence )
+{
+    if ( _stopped )
+    {
+        return;
+    }
+    // Replaces the wait of the previous request
+    _resendTimer.expires_from_now( std::chrono::milliseconds( kSyncResendPeriodMs ) );
+    _resendTimer.async_wait( [this, sequence]( const boost::system::error_code & error ) { resendTimeout( error, sequence ); } );
+}
+
+void SyncLink::resendTimeout( const boost::system::error_code & error, const boost::uint64_t sequence )
+{
+    if ( _stopped || error == boost::asio::error::operation_aborted )
+    {
+        return;
+    }
+    SyncMessage message;
+    udp::endpoint peer;
+    bool lost = false;
+    {
+        std::unique_lock<std::mutex> lock( _mutexPeer );
+        if ( !_hasPendingRequest || _pendingRequest.sequence != sequence )
+        {
+            return;
+        }
+        message = _pendingRequest;
+        peer = _peer;
+        if ( _nbSends >= kSyncMaxSends )
+        {
+            // The peer is gone: the next requests fail until it says hello again
+            _hasPendingRequest = false;
+            _hasPeer = false;
+            lost = true;
+        }
+        else
+        {
+            ++_nbSends;
+        }
+    }
+    if ( lost )
+    {
+        std::cerr << "OPERATION FAILED: No reply to the sync request " << sequence << ", the peer is forgotten." << std::endl;
+        signalRequestLost( message );
+        return;
+    }
+    sendTo( message, peer );
+    armResend( sequence );
+}
+
+void SyncLink::asyncReceive()
+{
+    _socket.async_receive_from( boost::asio::buffer( _receiveBuffer ), _sender,
+        [this]( const boost::system::error_code & error, const std::size_t size ) { received( error, size ); } );
+}
+
+bool SyncLink::accept( const SyncMessage & message )
+{
+    std::unique_lock<std::mutex> lock( _mutexPeer );
+    if ( message.action == eSyncActionHello )
+    {
+        _peer = _sender;
+        _hasPeer = true;
+        return true;
+    }
+    if ( message.action == eSyncActionBye )
+    {
+        _hasPeer = false;
+        _hasPendingRequest = false;
+        return true;
+    }
+    if ( message.sequence == 0 )
+    {
+        return true;
+    }
+    if ( isSyncRequest( message.action ) )
+    {
+        if ( message.sequence == _lastRequestSequence )
+        {
+            // Our reply was lost (or is not sent yet): the request is only signaled once
+            if ( _hasLastReply && _hasPeer )
+            {
+                sendTo( _lastReply, _peer );
+            }
+            return false;
+        }
+        _lastRequestSequence = message.sequence;
+        _hasLastReply = false;
+        return true;
+    }
+    // Replies to older requests and duplicated replies are dropped
+    if ( !_hasPendingRequest || message.sequence != _pendingRequest.sequence )
+    {
+        return false;
+    }
+    _hasPendingRequest = false;
+    boost::system::error_code error;
+    _resendTimer.cancel( error );
+    return true;
+}
+
+void SyncLink::received( const boost::system::error_code & error, const std::size_t size )
+{
+    if ( _stopped || error == boost::asio::error::operation_aborted )
+    {
+        return;
+    }
+    SyncMessage message;
+    // Ignore errors (ICMP port unreachable is reported on UDP sockets) and garbage
+    if ( !error && !decodeSyncMessage( _receiveBuffer, size, message ) && accept( message ) )
+    {
+        signalMessage( message );
+    }
+    asyncReceive();
+}
+
+}
@@ -0,0 +1,169 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#ifndef _KALICORE_SYNCLINK_HPP_
+#define	_KALICORE_SYNCLINK_HPP_
+
+#include "SyncMessage.hpp"
+
+#include <boost/asio.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/signals2.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace kaliscope
+{
+
+/// Default UDP port of the sync link (kalisync side)
+static const unsigned short kDefaultSyncPort( 11998 );
+
+/// A request without reply is sent again after this delay
+static const std::size_t kSyncResendPeriodMs( 25 );
+
+/// A request is lost (and the peer forgotten) after this number of unanswered sends
+static const std::size_t kSyncMaxSends( 40 );
+
+/**
+ * @brief frame synchronization link between kalisync and kaliscope
+ * One UDP datagram per SyncMessage, received in a fixed buffer and decoded
+ * without allocation by a dedicated thread. Receivers dispatch with a switch
+ * on the message action.
+ * kalisync listens, kaliscope connects and says hello: kalisync then knows
+ * where to send the triggers. kaliscope says bye when it closes the link.
+ *
+ * Datagrams can be lost: a request (the trigger) is numbered and sent again
+ * until the reply carrying its number comes back. A request received twice
+ * is not signaled again, the reply already sent to it is sent again instead.
+ * When a request stays unanswered, the peer is forgotten and
+ * signalRequestLost lets the sender use another way.
+ */
+class SyncLink
+{
+public:
+    SyncLink();
+    ~SyncLink();
+
+    /**
+     * @brief wait for messages on a port, the peer is the last sender
+     * @param port UDP port
+     * @return false on success, true if error
+     */
+    bool listen( const unsigned short port = kDefaultSyncPort );
+
+    /**
+     * @brief connect to a listening link
+     * @param host peer address
+     * @param port peer UDP port
+     * @return false on success, true if error
+     */
+    bool connect( const std::string & host, const unsigned short port = kDefaultSyncPort );
+
+    /**
+     * @brief stop receiving and close the socket
+     */
+    void close();
+
+    /**
+     * @brief do we know where to send messages
+     */
+    bool hasPeer() const
+    { return _hasPeer; }
+
+    /**
+     * @brief send a message to the peer, once
+     * @return false on success, true if error (no peer)
+     */
+    bool send( const SyncMessage & message );
+
+    /**
+     * @brief send a request, resent until the peer replies to it
+     * It replaces the pending request, if any.
+     * @return false on success, true if error (no peer)
+     */
+    bool request( const SyncMessage & message );
+
+    /**
+     * @brief stop resending the pending request
+     */
+    void cancelRequest();
+
+    /**
+     * @brief reply to the last received request
+     * @return false on success, true if error (no peer or no request)
+     */
+    bool reply( const SyncMessage & message );
+
+// Signals
+public:
+    boost::signals2::signal<void( const SyncMessage & message )> signalMessage;       ///< Signals a received message (from the receive thread)
+    boost::signals2::signal<void( const SyncMessage & message )> signalRequestLost;   ///< Signals an unanswered request (from the receive thread)
+
+private:
+    /**
+     * @brief start the receive thread
+     */
+    void start();
+
+    /**
+     * @brief wait for the next datagram
+     */
+    void asyncReceive();
+
+    /**
+     * @brief handle a received datagram
+     */
+    void received( const boost::system::error_code & error, const std::size_t size );
+
+    /**
+     * @brief resend the pending request if it is still unanswered
+     */
+    void resendTimeout( const boost::system::error_code & error, const boost::uint64_t sequence );
+
+    /**
+     * @brief wait for the reply of the pending request (receive thread)
+     */
+    void armResend( const boost::uint64_t sequence );
+
+    /**
+     * @brief update the peer and the requests with a received message
+     * @return true if the message must be signaled
+     */
+    bool accept( const SyncMessage & message );
+
+    /**
+     * @brief encode and send a message
+     * @return false on success, true if error
+     */
+    bool sendTo( const SyncMessage & message, const boost::asio::ip::udp::endpoint & peer );
+
+private:
+    boost::asio::io_service _ioService;
+    boost::asio::ip::udp::socket _socket;
+    boost::asio::steady_timer _resendTimer;             ///< Resends the pending request
+    std::mutex _mutexPeer;                              ///< The peer and the requests are changed by the receive thread
+    boost::asio::ip::udp::endpoint _peer;               ///< Where messages are sent
+    std::atomic<bool> _hasPeer;                         ///< Peer known
+    std::atomic<bool> _stopped;                         ///< The receive thread is stopping
+    boost::uint64_t _nextSequence;                      ///< Number of the next request sent
+    SyncMessage _pendingRequest;                        ///< Request sent and not answered yet
+    bool _hasPendingRequest;                            ///< _pendingRequest is waiting for its reply
+    std::size_t _nbSends;                               ///< Number of sends of the pending request
+    boost::uint64_t _lastRequestSequence;               ///< Number of the last received request (0: none)
+    SyncMessage _lastReply;                             ///< Reply to the last received request
+    bool _hasLastReply;                                 ///< _lastReply has been sent
+    boost::asio::ip::udp::endpoint _sender;             ///< Sender of the received datagram
+    std::unique_ptr<std::thread> _receiveThread;        ///< Receive thread
+    unsigned char _receiveBuffer[kSyncMessageSize + 1]; ///< One more byte to detect oversized datagrams
+};
+
+}
+
+#endif
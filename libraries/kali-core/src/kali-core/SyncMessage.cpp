@@ -0,0 +1,71 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#include "SyncMessage.hpp"
+
+namespace kaliscope
+{
+
+namespace
+{
+
+inline void writeUInt64( const boost::uint64_t value, unsigned char * buffer )
+{
+    for( std::size_t i = 0; i < 8; ++i )
+    {
+        buffer[i] = static_cast<unsigned char>( value >> ( 8 * i ) );
+    }
+}
+
+inline boost::uint64_t readUInt64( const unsigned char * buffer )
+{
+    boost::uint64_t value = 0;
+    for( std::size_t i = 0; i < 8; ++i )
+    {
+        value |= static_cast<boost::uint64_t>( buffer[i] ) << ( 8 * i );
+    }
+    return value;
+}
+
+}
+
+void encodeSyncMessage( const SyncMessage & message, unsigned char * buffer )
+{
+    buffer[0] = 'K';
+    buffer[1] = 'S';
+    buffer[2] = kSyncMessageVersion;
+    buffer[3] = static_cast<unsigned char>( message.action );
+    buffer += kSyncMessageHeaderSize;
+    writeUInt64( message.sequence, buffer );
+    buffer += 8;
+    writeUInt64( message.frameId, buffer );
+    for( std::size_t hop = 0; hop < eNbSyncHops; ++hop )
+    {
+        buffer += 8;
+        writeUInt64( static_cast<boost::uint64_t>( message.stamps[hop] ), buffer );
+    }
+}
+
+bool decodeSyncMessage( const unsigned char * buffer, const std::size_t size, SyncMessage & message )
+{
+    if ( size != kSyncMessageSize || buffer[0] != 'K' || buffer[1] != 'S' ||
+         buffer[2] != kSyncMessageVersion || buffer[3] >= eNbSyncActions )
+    {
+        return true;
+    }
+    message.action = static_cast<ESyncAction>( buffer[3] );
+    buffer += kSyncMessageHeaderSize;
+    message.sequence = readUInt64( buffer );
+    buffer += 8;
+    message.frameId = readUInt64( buffer );
+    for( std::size_t hop = 0; hop < eNbSyncHops; ++hop )
+    {
+        buffer += 8;
+        message.stamps[hop] = static_cast<boost::int64_t>( readUInt64( buffer ) );
+    }
+    return false;
+}
+
+}
@@ -0,0 +1,87 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#ifndef _KALICORE_SYNCMESSAGE_HPP_
+#define	_KALICORE_SYNCMESSAGE_HPP_
+
+#include "LatencyTracer.hpp"
+
+#include <boost/cstdint.hpp>
+
+#include <cstddef>
+
+namespace kaliscope
+{
+
+/**
+ * @brief action codes of the frame synchronization messages
+ * Only the per frame events go thru the sync link, the control events
+ * (stop, flat field...) are still serialized events.
+ */
+enum ESyncAction
+{
+    eSyncActionHello = 0,           ///< kaliscope announces itself, kalisync learns where to send the triggers
+    eSyncActionNextFrame,           ///< capture the next frame (kalisync -> kaliscope), a request
+    eSyncActionFrameExposed,        ///< the sensor has integrated the frame (kaliscope -> kalisync), the reply to the trigger
+    eSyncActionFrameCaptured,       ///< the frame has been processed (kaliscope -> kalisync)
+    eSyncActionBye,                 ///< kaliscope leaves, kalisync forgets it
+    eNbSyncActions
+};
+
+/**
+ * @brief is the action a request, resent until the peer replies to it
+ */
+inline bool isSyncRequest( const ESyncAction action )
+{
+    return action == eSyncActionNextFrame;
+}
+
+/**
+ * @brief frame synchronization message, carries the latency trace of the
+ *        frame (see SyncTrace)
+ */
+struct SyncMessage
+{
+    SyncMessage( const ESyncAction a = eSyncActionHello )
+    : action( a )
+    , sequence( 0 )
+    , frameId( 0 )
+    {
+        for( std::size_t hop = 0; hop < eNbSyncHops; ++hop )
+        {
+            stamps[hop] = 0;
+        }
+    }
+
+    ESyncAction action;
+    boost::uint64_t sequence;       ///< Request number, also carried by its reply (0: neither a request nor a reply)
+    boost::uint64_t frameId;
+    boost::int64_t stamps[eNbSyncHops];
+};
+
+/// Wire layout: 'K' 'S' version action, sequence, frame id, stamps (little endian)
+static const unsigned char kSyncMessageVersion( 2 );
+static const std::size_t kSyncMessageHeaderSize( 4 );
+static const std::size_t kSyncMessageSize( kSyncMessageHeaderSize + 8 + 8 + 8 * eNbSyncHops );
+
+/**
+ * @brief write a message
+ * @param message the message
+ * @param buffer kSyncMessageSize bytes
+ */
+void encodeSyncMessage( const SyncMessage & message, unsigned char * buffer );
+
+/**
+ * @brief read a message (no allocation)
+ * @param buffer received bytes
+ * @param size number of received bytes
+ * @param message[out] the message
+ * @return false on success, true if the bytes are not a sync message
+ */
+bool decodeSyncMessage( const unsigned char * buffer, const std::size_t size, SyncMessage & message );
+
+}
+
+#endif
@@ -214,6 +214,28 @@ bool VideoPlayer::play( const bool pause )
     return true;
 }
 
+/**
+ * @brief compute the reader node only
+ * @return the reader output, null if error
+ */
+DefaultImageT VideoPlayer::captureFrame( const double nFrame )
+{
+    try
+    {
+        std::unique_lock<std::mutex> lock( _mutexPlayer );
+        _currentPosition = nFrame;
+        _graph->compute( _outputCache, *_nodeRead, tuttle::host::ComputeOptions( nFrame ) );
+        _hasCapturedFrame = true;
+        _capturedFrame = nFrame;
+        return cache().get( _nodeRead->getName(), nFrame );
+    }
+    catch( ... )
+    {
+        TUTTLE_LOG_CURRENT_EXCEPTION;
+        return DefaultImageT();
+    }
+}
+
 /**
  * @brief get a frame at a certain time
  * @return an image, null if error
@@ -224,8 +246,24 @@ DefaultImageT VideoPlayer::getFrame( const double nFrame )
     {
         std::unique_lock<std::mutex> lock( _mutexPlayer );
         _currentPosition = nFrame;
-        _graph->compute( _outputCache, *_nodeFinal, tuttle::host::ComputeOptions( nFrame ) );
-        DefaultImageT frame = cache().get( _nodeFinal->getName(), nFrame );
+        // Already there if the reader is the final node and this frame has just
+        // been captured. Otherwise the graph is computed again from the reader:
+        // the live readers give back the frame they have rendered for this time
+        // (the exposed one), the file readers read the same image again.
+        DefaultImageT frame;
+        if ( _hasCapturedFrame && _capturedFrame == nFrame )
+        {
+            _hasCapturedFrame = false;
+            if ( _nodeFinal == _nodeRead )
+            {
+                frame = cache().get( _nodeFinal->getName(), nFrame );
+            }
+        }
+        if ( !frame )
+        {
+            _graph->compute( _outputCache, *_nodeFinal, tuttle::host::ComputeOptions( nFrame ) );
+            frame = cache().get( _nodeFinal->getName(), nFrame );
+        }
         _outputCache.clearUnused();
         return frame;
     }
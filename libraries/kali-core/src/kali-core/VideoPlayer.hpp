@@ -114,6 +114,23 @@ public:
      */
     bool play (const bool pause = false) override;
 
+    /**
+     * @brief compute the reader node only (the sensor has integrated the
+     *        frame once it returns). getFrame then processes the graph at
+     *        the same time, where a live reader renders this frame again
+     *        instead of a newer one
+     * @param nFrame frame number in time domain
+     * @return the reader output, null if error
+     */
+    DefaultImageT captureFrame( const double nFrame );
+
+    /**
+     * @brief get current frame read at a certain time
+     * @return the reader output, null if error
+     */
+    DefaultImageT captureFrame()
+    { return captureFrame( _currentPosition ); }
+
     /**
      * @brief get a frame at a certain time
      * @param nFrame frame number in time domain
@@ -229,6 +246,8 @@ private:
     double _currentLength = 0.0;        ///< Current track length
     double _currentFPS = 0.0;           ///< Current frames per seconds
     bool _playing = false;              ///< 'Is playing track' status
+    bool _hasCapturedFrame = false;     ///< captureFrame computed _capturedFrame, not yet returned by getFrame
+    double _capturedFrame = 0.0;        ///< Frame computed by the last captureFrame
 
 // Thread related
 private:
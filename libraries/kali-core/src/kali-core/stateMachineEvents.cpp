@@ -8,3 +8,5 @@
 #include <boost/archive/text_oarchive.hpp>
 
 #include "stateMachineEvents.hpp"
+
+BOOST_CLASS_EXPORT_IMPLEMENT( kaliscope::logic::EvSyncTrace );
@@ -6,6 +6,8 @@
 #ifndef _KALISCOPE_STATEMACHINEEVENTS_HPP_
 #define	_KALISCOPE_STATEMACHINEEVENTS_HPP_
 
+#include "LatencyTracer.hpp"
+
 #include <mvp-player-core/IEvent.hpp>
 
 #include <boost/statechart/event.hpp>
@@ -23,9 +25,77 @@
 namespace kaliscope
 {
     
+/// The sensor has integrated the frame, it is still being processed
+static const std::string kFrameExposedCustomStateAction( "kFrameExposedCustomStateAction" );
+/// The frame has been processed
 static const std::string kFrameCapturedCustomStateAction( "kFrameCapturedCustomStateAction" );
 static const std::string kCaptureStopCustomStateAction( "kCaptureStopCustomStateAction" );
+/// Light a uniform field with the projector and capture it without advancing the film
+static const std::string kFlatFieldStartCustomStateAction( "kFlatFieldStartCustomStateAction" );
+/// Enough flat field frames have been captured
+static const std::string kFlatFieldStopCustomStateAction( "kFlatFieldStopCustomStateAction" );
+
+namespace logic
+{
+
+namespace sc = boost::statechart;
+
+/**
+ * @brief carries the latency trace of a frame between kalisync and kaliscope
+ * Sent right after the event it traces, so that it doesn't delay it.
+ */
+struct EvSyncTrace : mvpplayer::IEvent, sc::event< EvSyncTrace >
+{
+private:
+    typedef EvSyncTrace This;
+public:
+
+    EvSyncTrace()
+    {}
+
+    EvSyncTrace( const SyncTrace & trace )
+    : _trace( trace )
+    {}
+
+    // This is needed to avoid a strange error on BOOST_CLASS_EXPORT_KEY
+    static void operator delete( void *p, const std::size_t n )
+    { ::operator delete(p); }
+
+    friend class boost::serialization::access;
+    template<class Archive>
+    void serialize(Archive & ar, const unsigned int version)
+    {
+        ar & boost::serialization::base_object<IEvent>( *this );
+        ar & _trace;
+    }
+
+    /**
+     * @brief this event is meant to be sent thru the network
+     */
+    bool shallDispatch() const
+    { return true; }
+
+    /**
+     * @brief process this event (needed to avoid dynamic_casts)
+     * @param scheduler event scheduler
+     * @param processor event processor
+     */
+    void processSelf( boost::statechart::fifo_scheduler<> & scheduler, boost::statechart::fifo_scheduler<>::processor_handle & processor )
+    {
+        scheduler.queue_event( processor, boost::intrusive_ptr< This >( this ) );
+    }
+
+    const SyncTrace & trace() const
+    { return _trace; }
+
+private:
+    SyncTrace _trace;
+};
+
+}
 
 }
 
+BOOST_CLASS_EXPORT_KEY( kaliscope::logic::EvSyncTrace );
+
 #endif
@@ -38,10 +38,296 @@
 #include "ofxsUtilities.h"
 #include <iostream>
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <condition_variable>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 namespace OFX {
 
 namespace MultiThread {
 
+namespace {
+
+std::atomic<bool> gNumaAware( true );
+
+/** @brief cpus the process may run on (taskset, cgroups cpuset, isolcpus) */
+std::vector<int> readAllowedCpus()
+{
+	std::vector<int> cpuList;
+#ifdef __linux__
+	cpu_set_t cpus;
+	CPU_ZERO( &cpus );
+	if( sched_getaffinity( 0, sizeof( cpus ), &cpus ) == 0 )
+	{
+		for( int cpu = 0; cpu < CPU_SETSIZE; ++cpu )
+		{
+			if( CPU_ISSET( cpu, &cpus ) )
+				cpuList.push_back( cpu );
+		}
+	}
+#endif
+	return cpuList;
+}
+
+/** @brief cpus the process may run on, empty if unknown */
+const std::vector<int>& allowedCpus()
+{
+	static const std::vector<int> cpus = readAllowedCpus();
+	return cpus;
+}
+
+/** @brief cpus of each numa node having some the process may run on, from sysfs */
+std::vector<std::vector<int> > readNumaNodes()
+{
+	std::vector<std::vector<int> > nodes;
+#ifdef __linux__
+	const std::vector<int>& allowed = allowedCpus();
+	for( unsigned int node = 0; node < kMaxNumaNodes; ++node )
+	{
+		std::ostringstream path;
+		path << "/sys/devices/system/node/node" << node << "/cpulist";
+		std::ifstream file( path.str().c_str() );
+		if( !file )
+			continue;
+		// "0-7,16-23"
+		std::vector<int> cpus;
+		std::string range;
+		while( std::getline( file, range, ',' ) )
+		{
+			std::istringstream in( range );
+			int first = 0;
+			if( !( in >> first ) )
+				continue;
+			int last = first;
+			char dash = 0;
+			if( in >> dash && dash == '-' )
+				in >> last;
+			for( int cpu = first; cpu <= last; ++cpu )
+			{
+				if( allowed.empty() || std::binary_search( allowed.begin(), allowed.end(), cpu ) )
+					cpus.push_back( cpu );
+			}
+		}
+		if( !cpus.empty() )
+			nodes.push_back( cpus );
+	}
+#endif
+	return nodes;
+}
+
+const std::vector<std::vector<int> >& numaNodes()
+{
+	static const std::vector<std::vector<int> > nodes = readNumaNodes();
+	return nodes;
+}
+
+#ifdef __linux__
+/** @brief pin the calling thread to a set of cpus
+ *  @return false if the cpus were refused
+ */
+bool pinCurrentThread( const std::vector<int>& cpuList )
+{
+	cpu_set_t cpus;
+	CPU_ZERO( &cpus );
+	for( std::vector<int>::const_iterator it = cpuList.begin(); it != cpuList.end(); ++it )
+	{
+		if( *it < CPU_SETSIZE )
+			CPU_SET( *it, &cpus );
+	}
+	const int error = pthread_setaffinity_np( pthread_self(), sizeof( cpus ), &cpus );
+	if( error != 0 )
+	{
+		OFXS_COUT_ERROR( "Unable to pin a plug-in thread: " << std::strerror( error ) );
+		return false;
+	}
+	return true;
+}
+#endif
+
+/** @brief Plug-in side workers, parked on a condition variable between the calls
+ *
+ * Processor::multiThread wakes them up instead of creating threads. Worker i
+ * always runs the index i of a call, so the same rows stay on the same
+ * thread. The calling thread runs the index 0 and the workers are left to the
+ * scheduler: each plug-in has its own pool, pinning them would pile the
+ * plug-ins rendered at the same time on the same cpus. When numa aware, the
+ * workers run all the indexes and are pinned to the allowed cpus of the node
+ * of their index (see getThreadNumaNode).
+ * One call at a time: a concurrent call goes to the host suite.
+ */
+class ThreadPool
+{
+public:
+	ThreadPool()
+		: _processor( NULL )
+		, _nbIndexes( 0 )
+		, _firstWorkerIndex( 1 )
+		, _nbRunning( 0 )
+		, _generation( 0 )
+		, _stop( false )
+	{}
+
+	~ThreadPool()
+	{
+		{
+			std::unique_lock<std::mutex> lock( _mutex );
+			_stop = true;
+		}
+		_wake.notify_all();
+		for( std::vector<std::thread>::iterator it = _workers.begin(); it != _workers.end(); ++it )
+			it->join();
+	}
+
+	static ThreadPool& instance()
+	{
+		static ThreadPool pool;
+		return pool;
+	}
+
+	/** @brief call processor.multiThreadFunction on nThreads threads and wait for them
+	 *  @return false if the pool is busy (nothing was run), true otherwise
+	 */
+	bool run( Processor& processor, const unsigned int nThreads )
+	{
+		std::unique_lock<std::mutex> runLock( _runMutex, std::try_to_lock );
+		if( !runLock.owns_lock() )
+			return false;
+
+		// The calling thread can be on any node
+		const unsigned int firstWorkerIndex = getNumaNodes() > 1 ? 0 : 1;
+		std::exception_ptr error;
+		{
+			std::unique_lock<std::mutex> lock( _mutex );
+			while( _workers.size() + firstWorkerIndex < nThreads )
+				_workers.push_back( std::thread( &ThreadPool::work, this, static_cast<unsigned int>( _workers.size() + 1 ), _generation ) );
+			_processor  = &processor;
+			_nbIndexes  = nThreads;
+			_firstWorkerIndex = firstWorkerIndex;
+			_nbRunning  = nThreads - firstWorkerIndex;
+			_error      = std::exception_ptr();
+			++_generation;
+		}
+		_wake.notify_all();
+
+		if( firstWorkerIndex == 1 )
+		{
+			try
+			{
+				processor.multiThreadFunction( 0, nThreads );
+			}
+			catch( ... )
+			{
+				error = std::current_exception();
+			}
+		}
+
+		std::unique_lock<std::mutex> lock( _mutex );
+		_done.wait( lock, [this]() { return _nbRunning == 0; } );
+		_processor = NULL;
+		if( !error )
+			error = _error;
+		lock.unlock();
+		if( error )
+			std::rethrow_exception( error );
+		return true;
+	}
+
+private:
+	/** @brief pin the worker to the node of its index, or give it back all
+	 *         the allowed cpus when numa awareness has been turned off.
+	 *         A refused pinning is reported once, not retried on each call.
+	 *  @param pinnedNode  node the worker is pinned to, -1 if not pinned
+	 */
+	void pin( const unsigned int index, const unsigned int nbIndexes, int& pinnedNode ) const
+	{
+#ifdef __linux__
+		const int node = getNumaNodes() > 1 ? static_cast<int>( getThreadNumaNode( index, nbIndexes ) ) : -1;
+		if( node == pinnedNode || ( node < 0 && allowedCpus().empty() ) )
+			return;
+		pinnedNode = node;
+		pinCurrentThread( node >= 0 ? numaNodes()[node] : allowedCpus() );
+#endif
+	}
+
+	/** @param seen last call before the worker was created */
+	void work( const unsigned int worker, unsigned long long seen )
+	{
+		int pinnedNode = -1;
+		std::unique_lock<std::mutex> lock( _mutex );
+		for( ;; )
+		{
+			_wake.wait( lock, [this, seen]() { return _stop || _generation != seen; } );
+			if( _stop )
+				return;
+			seen = _generation;
+			// More workers than needed by this call
+			const unsigned int index = worker - 1 + _firstWorkerIndex;
+			if( index >= _nbIndexes )
+				continue;
+
+			Processor* processor = _processor;
+			const unsigned int nbIndexes = _nbIndexes;
+			lock.unlock();
+			pin( index, nbIndexes, pinnedNode );
+			std::exception_ptr error;
+			try
+			{
+				processor->multiThreadFunction( index, nbIndexes );
+			}
+			catch( ... )
+			{
+				error = std::current_exception();
+			}
+			lock.lock();
+			if( error && !_error )
+				_error = error;
+			if( --_nbRunning == 0 )
+				_done.notify_all();
+		}
+	}
+
+private:
+	std::mutex _runMutex;              ///< Held by the running call
+	std::mutex _mutex;
+	std::condition_variable _wake;     ///< Workers wait for a new call
+	std::condition_variable _done;     ///< The caller waits for the workers
+	std::vector<std::thread> _workers;
+	Processor* _processor;             ///< Processor of the running call
+	unsigned int _nbIndexes;           ///< Thread indexes of the running call
+	unsigned int _firstWorkerIndex;    ///< Index run by the worker 1, 0 if the caller doesn't run one
+	unsigned int _nbRunning;           ///< Worker indexes not done yet
+	unsigned long long _generation;    ///< Incremented by each call
+	std::exception_ptr _error;         ///< First exception thrown by a worker
+	bool _stop;
+};
+
+std::atomic<bool> gUsePluginThreads( true );
+
+/** @brief TuttleOfx calls the plug-ins from any thread, and doesn't need to know about their threads.
+ *         Processors run from host spawned threads keep using the host suite.
+ */
+bool pluginThreadsAllowed()
+{
+	return gUsePluginThreads &&
+		OFX::getImageEffectHostDescription()->hostName == "TuttleOfx" &&
+		!isSpawnedThread();
+}
+
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // SMP class
 
@@ -81,6 +367,10 @@ void Processor::multiThread( const unsigned int nCPUs )
 	}
 	else
 	{
+		// A wakeup of the persistent workers instead of a thread creation
+		if( pluginThreadsAllowed() && ThreadPool::instance().run( *this, realNbCPUs ) )
+			return;
+
 		// OK do it
 		OfxStatus stat = OFX::Private::gThreadSuite->multiThread( staticMultiThreadFunction, realNbCPUs, (void*)this );
 
@@ -92,6 +382,34 @@ void Processor::multiThread( const unsigned int nCPUs )
 ////////////////////////////////////////////////////////////////////////////////
 // futility functions
 
+/** @brief Run Processor::multiThread on persistent plug-in threads when the host allows it */
+void setUsePluginThreads( const bool use )
+{
+	gUsePluginThreads = use;
+}
+
+/** @brief Place the plug-in threads and the rows on the numa nodes (default, when there are several) */
+void setNumaAware( const bool numa )
+{
+	gNumaAware = numa;
+}
+
+/** @brief The number of numa nodes the threads are spread on, 1 if not numa aware */
+unsigned int getNumaNodes( void )
+{
+	const std::size_t nbNodes = numaNodes().size();
+	return gNumaAware && nbNodes > 1 ? static_cast<unsigned int>( nbNodes ) : 1;
+}
+
+/** @brief The numa node of the thread index of a call on nThreads threads */
+unsigned int getThreadNumaNode( const unsigned int threadIndex, const unsigned int nThreads )
+{
+	const unsigned int nbNodes = getNumaNodes();
+	if( nThreads == 0 )
+		return 0;
+	return std::min( nbNodes - 1, threadIndex * nbNodes / nThreads );
+}
+
 /** @brief Has the current thread been spawned from an MP */
 bool isSpawnedThread( void )
 {
@@ -52,6 +52,9 @@ namespace OFX {
 /** @brief Multi thread namespace */
 namespace MultiThread {
 
+/** @brief Maximum number of numa nodes the threads are spread on, the nodes above are ignored */
+static const unsigned int kMaxNumaNodes = 64;
+
 /** @brief Class that wraps up SMP multi-processing */
 class Processor
 {
@@ -73,6 +76,26 @@ public:
 	virtual void multiThread( const unsigned int nCPUs = 0 );
 };
 
+/** @brief Run Processor::multiThread on persistent plug-in threads when the host allows it (default),
+ *         instead of asking the host suite to spawn threads for every call */
+void setUsePluginThreads( const bool use );
+
+/** @brief Place the plug-in threads and the rows on the numa nodes (default, when there are several)
+ *
+ * The threads of a call are split in contiguous groups, one per node, and
+ * pinned to the cpus of their node the process may run on (the threads
+ * are not pinned otherwise). ImageProcessor gives each group the
+ * same rows of every image, so they stay in the memory of the node, and
+ * lets the groups done with their rows help the others.
+ */
+void setNumaAware( const bool numa );
+
+/** @brief The number of numa nodes the threads are spread on, 1 if not numa aware */
+unsigned int getNumaNodes( void );
+
+/** @brief The numa node of the thread index of a call on nThreads threads */
+unsigned int getThreadNumaNode( const unsigned int threadIndex, const unsigned int nThreads );
+
 /** @brief Has the current thread been spawned from an MP */
 bool isSpawnedThread( void );
 
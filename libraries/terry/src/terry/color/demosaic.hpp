@@ -0,0 +1,174 @@
+#ifndef _TERRY_COLOR_DEMOSAIC_HPP_
+#define _TERRY_COLOR_DEMOSAIC_HPP_
+
+#include <terry/simd.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace terry {
+namespace color {
+
+enum EDemosaicMethod
+{
+	eDemosaicBilinear = 0,     ///< average of the nearest samples of each color
+	eDemosaicEdgeAware         ///< green is interpolated along the edges, red and blue are bilinear
+};
+
+/**
+ * @brief Layout of a bayer sensor: position of the red sample in the 2x2 quad
+ *        (RGGB is { 0, 0 }, GRBG { 1, 0 }, GBRG { 0, 1 }, BGGR { 1, 1 }).
+ */
+struct BayerPattern
+{
+	BayerPattern( const int x = 0, const int y = 0 )
+	: redX( x )
+	, redY( y )
+	{}
+
+	int redX;
+	int redY;
+};
+
+/**
+ * @brief Rows above and below y, mirrored on the image borders so that they
+ *        keep the color layout of the missing rows.
+ * @warning height must be at least 2
+ */
+inline void bayerNeighbourRows( const std::ptrdiff_t y, const std::ptrdiff_t height, std::ptrdiff_t& above, std::ptrdiff_t& below )
+{
+	above = y > 0 ? y - 1 : 1;
+	below = y < height - 1 ? y + 1 : height - 2;
+}
+
+/**
+ * @brief Row based bayer demosaic.
+ *
+ * Each output row only needs the mosaic rows above and below, so an image can
+ * be split in bands and demosaiced by several threads, each one using its own
+ * BayerDemosaic (it keeps scratch rows). Four pixels are computed at once.
+ */
+class BayerDemosaic
+{
+public:
+	/**
+	 * @param scale  factor applied to the samples (1 / white level to get [0, 1] values)
+	 */
+	BayerDemosaic( const BayerPattern& pattern, const EDemosaicMethod method, const float scale )
+	: _pattern( pattern )
+	, _method( method )
+	, _scale( scale )
+	{}
+
+	/**
+	 * @brief Demosaic row y
+	 * @param[in]  above  mosaic row y - 1 (see bayerNeighbourRows)
+	 * @param[in]  row    mosaic row y
+	 * @param[in]  below  mosaic row y + 1
+	 * @param[out] dst    interleaved rgb floats, 3 * width values
+	 * @param[in]  width  row width, at least 2
+	 * @param[in]  y      row index in the mosaic (only its parity matters)
+	 */
+	template<typename Sample>
+	void operator()( const Sample* above, const Sample* row, const Sample* below, float* dst, const std::size_t width, const std::ptrdiff_t y )
+	{
+		using namespace simd;
+		// Rows are converted to float with one mirrored sample on each side,
+		// and some padding so that the last group of 4 pixels can be loaded.
+		const std::size_t padded = width + 6;
+		_rows.resize( 3 * padded );
+		float* const a = &_rows[0];
+		float* const c = a + padded;
+		float* const b = c + padded;
+		loadRow( above, a, width );
+		loadRow( row, c, width );
+		loadRow( below, b, width );
+
+		// Site masks of the 4 lanes: the color layout has a period of 2
+		const bool redRow = ( y & 1 ) == _pattern.redY;
+		float nativeR[4], nativeB[4], greenRedRow[4], greenBlueRow[4];
+		for( int i = 0; i < 4; ++i )
+		{
+			const bool redColumn = ( i & 1 ) == _pattern.redX;
+			nativeR[i] = ( redRow && redColumn ) ? 1.0f : 0.0f;
+			nativeB[i] = ( !redRow && !redColumn ) ? 1.0f : 0.0f;
+			greenRedRow[i] = ( redRow && !redColumn ) ? 1.0f : 0.0f;
+			greenBlueRow[i] = ( !redRow && redColumn ) ? 1.0f : 0.0f;
+		}
+		const float4 nR = load( nativeR );
+		const float4 nB = load( nativeB );
+		const float4 gR = load( greenRedRow );
+		const float4 gB = load( greenBlueRow );
+		const float4 nG = add( gR, gB );
+		const float4 nRB = add( nR, nB );
+		const float4 half = set1( 0.5f );
+		const float4 quarter = set1( 0.25f );
+		const float4 zero = set1( 0.0f );
+		const float4 epsilon = set1( 1e-6f ); // flat areas: both directions count the same
+		const bool edgeAware = _method == eDemosaicEdgeAware;
+
+		float r[4], g[4], bl[4];
+		for( std::size_t x = 0; x < width; x += 4 )
+		{
+			// Pixel x is at index x + 1 in the padded rows
+			const float4 center = load( c + x + 1 );
+			const float4 left = load( c + x );
+			const float4 right = load( c + x + 2 );
+			const float4 up = load( a + x + 1 );
+			const float4 down = load( b + x + 1 );
+			const float4 horiz = mul( add( left, right ), half );
+			const float4 vert = mul( add( up, down ), half );
+			const float4 diag = mul( add( add( load( a + x ), load( a + x + 2 ) ), add( load( b + x ), load( b + x + 2 ) ) ), quarter );
+
+			float4 green;
+			if( edgeAware )
+			{
+				// Weight each direction by the gradient across the other one,
+				// so that green is not averaged across an edge
+				const float4 dh = sub( left, right );
+				const float4 dv = sub( up, down );
+				const float4 gradH = add( max( dh, sub( zero, dh ) ), epsilon );
+				const float4 gradV = add( max( dv, sub( zero, dv ) ), epsilon );
+				green = mul( madd( horiz, gradV, mul( vert, gradH ) ), rcp( add( gradH, gradV ) ) );
+			}
+			else
+			{
+				green = mul( add( horiz, vert ), half );
+			}
+
+			store( r, madd( center, nR, madd( diag, nB, madd( horiz, gR, mul( vert, gB ) ) ) ) );
+			store( g, madd( center, nG, mul( green, nRB ) ) );
+			store( bl, madd( center, nB, madd( diag, nR, madd( vert, gR, mul( horiz, gB ) ) ) ) );
+			const std::size_t n = std::min<std::size_t>( 4, width - x );
+			for( std::size_t i = 0; i < n; ++i, dst += 3 )
+			{
+				dst[0] = r[i];
+				dst[1] = g[i];
+				dst[2] = bl[i];
+			}
+		}
+	}
+
+private:
+	template<typename Sample>
+	void loadRow( const Sample* src, float* dst, const std::size_t width ) const
+	{
+		for( std::size_t x = 0; x < width; ++x )
+			dst[x + 1] = src[x] * _scale;
+		dst[0] = dst[2];
+		dst[width + 1] = dst[width - 1];
+		std::fill( dst + width + 2, dst + width + 6, 0.0f );
+	}
+
+private:
+	BayerPattern _pattern;
+	EDemosaicMethod _method;
+	float _scale;
+	std::vector<float> _rows; ///< Scratch rows, reused between calls
+};
+
+}
+}
+
+#endif
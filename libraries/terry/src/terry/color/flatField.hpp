@@ -0,0 +1,206 @@
+#ifndef _TERRY_COLOR_FLATFIELD_HPP_
+#define _TERRY_COLOR_FLATFIELD_HPP_
+
+#include <terry/simd.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace terry {
+namespace color {
+
+/**
+ * @brief Flat-field gain map: one gain per pixel and channel, interleaved
+ *        channels, rows in image memory order.
+ *
+ * The corrected value is value * gain, so correcting a frame is a single
+ * multiply (see applyGain).
+ */
+struct GainMap
+{
+	GainMap()
+	: width( 0 )
+	, height( 0 )
+	, channels( 0 )
+	{}
+
+	bool empty() const
+	{ return gains.empty(); }
+
+	const float* row( const std::size_t y ) const
+	{ return &gains[y * width * channels]; }
+
+	/**
+	 * @brief Nearest pixel copy of this map with another size
+	 */
+	void resample( const std::size_t w, const std::size_t h, GainMap& dst ) const
+	{
+		dst.width = w;
+		dst.height = h;
+		dst.channels = channels;
+		dst.gains.resize( w * h * channels );
+		float* out = &dst.gains[0];
+		for( std::size_t y = 0; y < h; ++y )
+		{
+			const float* src = row( y * height / h );
+			for( std::size_t x = 0; x < w; ++x, out += channels )
+				std::copy( src + ( x * width / w ) * channels, src + ( x * width / w + 1 ) * channels, out );
+		}
+	}
+
+	std::size_t width;
+	std::size_t height;
+	std::size_t channels;
+	std::vector<float> gains;
+};
+
+/**
+ * @brief Average of frames of a uniform field, gives the gain map.
+ */
+class FlatFieldAccumulator
+{
+public:
+	FlatFieldAccumulator()
+	: _width( 0 )
+	, _height( 0 )
+	, _channels( 0 )
+	, _nbFrames( 0 )
+	{}
+
+	void reset( const std::size_t width, const std::size_t height, const std::size_t channels )
+	{
+		_width = width;
+		_height = height;
+		_channels = channels;
+		_nbFrames = 0;
+		_sums.assign( width * height * channels, 0.0f );
+	}
+
+	std::size_t nbFrames() const
+	{ return _nbFrames; }
+
+	/**
+	 * @brief add a frame
+	 * @param data         height rows of width pixels of srcChannels interleaved samples
+	 * @param rowBytes     distance in bytes between the starts of two rows (rows may be padded)
+	 * @param srcChannels  samples per pixel in data, the first channels ones are used (alpha is skipped)
+	 * @param scale        factor applied to the samples (1 / maximum value)
+	 */
+	template<typename Sample>
+	void add( const Sample* data, const std::size_t rowBytes, const std::size_t srcChannels, const float scale )
+	{
+		float* sums = &_sums[0];
+		const unsigned char* row = reinterpret_cast<const unsigned char*>( data );
+		for( std::size_t y = 0; y < _height; ++y, row += rowBytes )
+		{
+			const Sample* src = reinterpret_cast<const Sample*>( row );
+			if( srcChannels == _channels )
+			{
+				for( std::size_t i = 0; i < _width * _channels; ++i )
+					sums[i] += src[i] * scale;
+				sums += _width * _channels;
+			}
+			else
+			{
+				for( std::size_t x = 0; x < _width; ++x, src += srcChannels, sums += _channels )
+					for( std::size_t c = 0; c < _channels; ++c )
+						sums[c] += src[c] * scale;
+			}
+		}
+		++_nbFrames;
+	}
+
+	/**
+	 * @brief get the gain map: brings each pixel to the mean of its channel
+	 * @param maxGain  limit of the gains (dust, vignetting in the corners)
+	 */
+	void gainMap( GainMap& map, const float maxGain = 8.0f ) const
+	{
+		map.width = _width;
+		map.height = _height;
+		map.channels = _channels;
+		map.gains.resize( _sums.size() );
+		if( _sums.empty() || !_nbFrames )
+			return;
+
+		std::vector<double> means( _channels, 0.0 );
+		for( std::size_t i = 0; i < _sums.size(); ++i )
+			means[i % _channels] += _sums[i];
+		const double nbPixels = static_cast<double>( _width * _height );
+		for( std::size_t c = 0; c < _channels; ++c )
+			means[c] /= nbPixels;
+
+		const float minSum = 1e-6f;
+		for( std::size_t i = 0; i < _sums.size(); ++i )
+			map.gains[i] = std::min( maxGain, static_cast<float>( means[i % _channels] / std::max( _sums[i], minSum ) ) );
+	}
+
+private:
+	std::size_t _width;
+	std::size_t _height;
+	std::size_t _channels;
+	std::size_t _nbFrames;
+	std::vector<float> _sums;   ///< Sum of the frames
+};
+
+/**
+ * @brief Flat-field correction of n values (a row): values *= gains
+ */
+inline void applyGain( float* values, const float* gains, const std::size_t n )
+{
+	using namespace simd;
+	std::size_t i = 0;
+	for( ; i + 4 <= n; i += 4 )
+		store( values + i, mul( load( values + i ), load( gains + i ) ) );
+	for( ; i < n; ++i )
+		values[i] *= gains[i];
+}
+
+static const char* const kGainMapMagic = "KALIGAIN";
+
+/**
+ * @brief Write a gain map: a text header (magic, width height channels)
+ *        followed by the raw floats in host byte order.
+ * @return false if the file can't be written
+ */
+inline bool writeGainMap( const std::string& filename, const GainMap& map )
+{
+	std::ofstream out( filename.c_str(), std::ios::binary );
+	if( !out.good() )
+		return false;
+	out << kGainMapMagic << "\n" << map.width << " " << map.height << " " << map.channels << "\n";
+	out.write( reinterpret_cast<const char*>( map.gains.data() ), map.gains.size() * sizeof( float ) );
+	return out.good();
+}
+
+/**
+ * @brief Read a gain map written by writeGainMap
+ * @return false if the file can't be read or is malformed
+ */
+inline bool readGainMap( const std::string& filename, GainMap& map )
+{
+	std::ifstream in( filename.c_str(), std::ios::binary );
+	std::string magic;
+	if( !( in >> magic ) || magic != kGainMapMagic )
+		return false;
+	std::size_t width = 0, height = 0, channels = 0;
+	if( !( in >> width >> height >> channels ) || !width || !height || !channels )
+		return false;
+	in.get(); // end of the header line
+	std::vector<float> gains( width * height * channels );
+	if( !in.read( reinterpret_cast<char*>( &gains[0] ), gains.size() * sizeof( float ) ) )
+		return false;
+	map.width = width;
+	map.height = height;
+	map.channels = channels;
+	map.gains.swap( gains );
+	return true;
+}
+
+}
+}
+
+#endif
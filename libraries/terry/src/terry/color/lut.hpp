@@ -0,0 +1,230 @@
+#ifndef _TERRY_COLOR_LUT_HPP_
+#define _TERRY_COLOR_LUT_HPP_
+
+#include <terry/simd.hpp>
+
+#include <boost/array.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace terry {
+namespace color {
+
+enum ELutInterpolation
+{
+	eLutInterpolationTrilinear,
+	eLutInterpolationTetrahedral
+};
+
+/**
+ * @brief Per channel 1D lookup table, used as a shaper in front of a 3D lattice.
+ *
+ * Maps an input value of [domainMin, domainMax] to the normalized lattice
+ * coordinate [0, 1]. Values are linearly interpolated.
+ */
+class Lut1D
+{
+public:
+	Lut1D()
+	: _size( 0 )
+	{
+		_domainMin.fill( 0.0f );
+		_domainMax.fill( 1.0f );
+	}
+
+	inline bool empty() const { return _size == 0; }
+	inline std::size_t size() const { return _size; }
+
+	void resize( const std::size_t size )
+	{
+		_size = size;
+		for( int c = 0; c < 3; ++c )
+			_values[c].assign( size, 0.0f );
+	}
+
+	inline void setValue( const std::size_t i, const float r, const float g, const float b )
+	{
+		_values[0][i] = r;
+		_values[1][i] = g;
+		_values[2][i] = b;
+	}
+
+	inline void setDomain( const int channel, const float vmin, const float vmax )
+	{
+		_domainMin[channel] = vmin;
+		_domainMax[channel] = vmax;
+	}
+
+	/// @brief evaluate channel c at value v
+	inline float operator()( const int c, const float v ) const
+	{
+		const float range = _domainMax[c] - _domainMin[c];
+		const float pos = std::min( std::max( ( v - _domainMin[c] ) / range, 0.0f ), 1.0f ) * ( _size - 1 );
+		const std::size_t i = std::min( static_cast<std::size_t>( pos ), _size - 2 );
+		const float f = pos - i;
+		const std::vector<float>& values = _values[c];
+		return values[i] + ( values[i + 1] - values[i] ) * f;
+	}
+
+private:
+	std::size_t _size;
+	boost::array<std::vector<float>, 3> _values;
+	boost::array<float, 3> _domainMin;
+	boost::array<float, 3> _domainMax;
+};
+
+/**
+ * @brief 3D lookup table with trilinear and tetrahedral interpolation.
+ *
+ * Lattice nodes are stored red fastest, padded to 4 floats so that each node
+ * is a single vector load and the interpolation weights are applied to the
+ * three channels at once.
+ */
+class Lut3D
+{
+public:
+	Lut3D()
+	: _size( 0 )
+	{
+		_domainMin.fill( 0.0f );
+		_domainMax.fill( 1.0f );
+	}
+
+	inline bool empty() const { return _size == 0; }
+	inline std::size_t size() const { return _size; }
+
+	void resize( const std::size_t size )
+	{
+		_size = size;
+		_lattice.assign( size * size * size * 4, 0.0f );
+	}
+
+	/// @brief set the node at lattice coordinates (ir, ig, ib)
+	inline void setValue( const std::size_t ir, const std::size_t ig, const std::size_t ib, const float r, const float g, const float b )
+	{
+		float* node = &_lattice[ index( ir, ig, ib ) ];
+		node[0] = r;
+		node[1] = g;
+		node[2] = b;
+	}
+
+	inline void setDomain( const int channel, const float vmin, const float vmax )
+	{
+		_domainMin[channel] = vmin;
+		_domainMax[channel] = vmax;
+	}
+
+	inline Lut1D& shaper() { return _shaper; }
+	inline const Lut1D& shaper() const { return _shaper; }
+
+	/**
+	 * @brief Apply the lut on a single pixel
+	 * @param[in, out] rgb  red, green, blue values
+	 */
+	inline void apply( float* rgb, const ELutInterpolation interpolation ) const
+	{
+		const std::size_t last = _size - 1;
+		float pos[3];
+		for( int c = 0; c < 3; ++c )
+		{
+			float v;
+			if( _shaper.empty() )
+				v = ( rgb[c] - _domainMin[c] ) / ( _domainMax[c] - _domainMin[c] );
+			else
+				v = _shaper( c, rgb[c] );
+			pos[c] = std::min( std::max( v, 0.0f ), 1.0f ) * last;
+		}
+		// index of the lower corner, kept inside the lattice so that the
+		// upper corner is always valid
+		const std::size_t r0 = std::min( static_cast<std::size_t>( pos[0] ), last - 1 );
+		const std::size_t g0 = std::min( static_cast<std::size_t>( pos[1] ), last - 1 );
+		const std::size_t b0 = std::min( static_cast<std::size_t>( pos[2] ), last - 1 );
+		const float fr = pos[0] - r0;
+		const float fg = pos[1] - g0;
+		const float fb = pos[2] - b0;
+
+		const std::size_t sr = 4;
+		const std::size_t sg = 4 * _size;
+		const std::size_t sb = 4 * _size * _size;
+		const float* c000 = &_lattice[ index( r0, g0, b0 ) ];
+
+		simd::float4 res;
+		if( interpolation == eLutInterpolationTetrahedral )
+		{
+			// split the cube in 6 tetrahedra, sharing the c000-c111 diagonal
+			const float* c111 = c000 + sr + sg + sb;
+			const float* c1;
+			const float* c2;
+			float w0, w1, w2, w3;
+			if( fr > fg )
+			{
+				if( fg > fb )      { c1 = c000 + sr; c2 = c1 + sg; w0 = 1.0f - fr; w1 = fr - fg; w2 = fg - fb; w3 = fb; }
+				else if( fr > fb ) { c1 = c000 + sr; c2 = c1 + sb; w0 = 1.0f - fr; w1 = fr - fb; w2 = fb - fg; w3 = fg; }
+				else               { c1 = c000 + sb; c2 = c1 + sr; w0 = 1.0f - fb; w1 = fb - fr; w2 = fr - fg; w3 = fg; }
+			}
+			else
+			{
+				if( fb > fg )      { c1 = c000 + sb; c2 = c1 + sg; w0 = 1.0f - fb; w1 = fb - fg; w2 = fg - fr; w3 = fr; }
+				else if( fb > fr ) { c1 = c000 + sg; c2 = c1 + sb; w0 = 1.0f - fg; w1 = fg - fb; w2 = fb - fr; w3 = fr; }
+				else               { c1 = c000 + sg; c2 = c1 + sr; w0 = 1.0f - fg; w1 = fg - fr; w2 = fr - fb; w3 = fb; }
+			}
+			res = simd::mul( simd::load( c000 ), simd::set1( w0 ) );
+			res = simd::madd( simd::load( c1 ), simd::set1( w1 ), res );
+			res = simd::madd( simd::load( c2 ), simd::set1( w2 ), res );
+			res = simd::madd( simd::load( c111 ), simd::set1( w3 ), res );
+		}
+		else
+		{
+			const simd::float4 vfr = simd::set1( fr );
+			const simd::float4 vfg = simd::set1( fg );
+			const simd::float4 vfb = simd::set1( fb );
+			simd::float4 c00 = lerp( simd::load( c000 ),           simd::load( c000 + sr ),           vfr );
+			simd::float4 c10 = lerp( simd::load( c000 + sg ),      simd::load( c000 + sg + sr ),      vfr );
+			simd::float4 c01 = lerp( simd::load( c000 + sb ),      simd::load( c000 + sb + sr ),      vfr );
+			simd::float4 c11 = lerp( simd::load( c000 + sb + sg ), simd::load( c000 + sb + sg + sr ), vfr );
+			res = lerp( lerp( c00, c10, vfg ), lerp( c01, c11, vfg ), vfb );
+		}
+		float out[4];
+		simd::store( out, res );
+		rgb[0] = out[0];
+		rgb[1] = out[1];
+		rgb[2] = out[2];
+	}
+
+	/**
+	 * @brief Apply the lut on a row of interleaved float pixels
+	 * @param[in, out] data    first pixel of the row
+	 * @param[in]      nbPixels number of pixels
+	 * @param[in]      step    number of floats between two pixels (3 for rgb, 4 for rgba)
+	 */
+	inline void applyRow( float* data, const std::size_t nbPixels, const std::size_t step, const ELutInterpolation interpolation ) const
+	{
+		for( std::size_t i = 0; i < nbPixels; ++i, data += step )
+			apply( data, interpolation );
+	}
+
+private:
+	inline std::size_t index( const std::size_t ir, const std::size_t ig, const std::size_t ib ) const
+	{
+		return 4 * ( ( ib * _size + ig ) * _size + ir );
+	}
+
+	static inline simd::float4 lerp( const simd::float4& a, const simd::float4& b, const simd::float4& f )
+	{
+		return simd::madd( simd::sub( b, a ), f, a );
+	}
+
+private:
+	std::size_t _size;
+	std::vector<float> _lattice;        ///< nodes, 4 floats each, red fastest
+	boost::array<float, 3> _domainMin;
+	boost::array<float, 3> _domainMax;
+	Lut1D _shaper;                      ///< optional shaper, replaces the domain when set
+};
+
+}
+}
+
+#endif
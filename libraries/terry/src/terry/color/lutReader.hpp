@@ -0,0 +1,268 @@
+#ifndef _TERRY_COLOR_LUTREADER_HPP_
+#define _TERRY_COLOR_LUTREADER_HPP_
+
+#include "lut.hpp"
+
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/trim.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace terry {
+namespace color {
+
+namespace details {
+
+/// @brief get next line that is neither empty nor a comment
+inline bool nextLutLine( std::istream& in, std::string& line )
+{
+	while( std::getline( in, line ) )
+	{
+		boost::algorithm::trim( line );
+		if( !line.empty() && line[0] != '#' )
+			return true;
+	}
+	return false;
+}
+
+/// @brief smallest 2^n - 1 greater or equal to v (used to guess the bit depth of .3dl files)
+inline double lutBitDepthMax( const double v )
+{
+	double vmax = 1.0;
+	while( vmax < v )
+		vmax = vmax * 2.0 + 1.0;
+	return vmax;
+}
+
+}
+
+/**
+ * @brief Read a .cube lut (Adobe/Iridas/Resolve).
+ *
+ * Supports 3D tables, 1D tables (used as a shaper on an identity lattice)
+ * and 1D + 3D tables (the 1D table becomes the shaper).
+ *
+ * @return false if the file can't be read or is malformed
+ */
+inline bool readCubeLut( const std::string& filename, Lut3D& lut )
+{
+	std::ifstream in( filename.c_str() );
+	if( !in.good() )
+		return false;
+
+	std::size_t size1D = 0;
+	std::size_t size3D = 0;
+	float domainMin[3] = { 0.0f, 0.0f, 0.0f };
+	float domainMax[3] = { 1.0f, 1.0f, 1.0f };
+	float range1D[2] = { 0.0f, 1.0f };
+	float range3D[2] = { 0.0f, 1.0f };
+	std::vector<float> values;
+
+	std::string line;
+	while( details::nextLutLine( in, line ) )
+	{
+		std::istringstream iss( line );
+		std::string keyword;
+		if( std::isalpha( static_cast<unsigned char>( line[0] ) ) )
+		{
+			iss >> keyword;
+			if( keyword == "LUT_1D_SIZE" )
+				iss >> size1D;
+			else if( keyword == "LUT_3D_SIZE" )
+				iss >> size3D;
+			else if( keyword == "DOMAIN_MIN" )
+				iss >> domainMin[0] >> domainMin[1] >> domainMin[2];
+			else if( keyword == "DOMAIN_MAX" )
+				iss >> domainMax[0] >> domainMax[1] >> domainMax[2];
+			else if( keyword == "LUT_1D_INPUT_RANGE" )
+				iss >> range1D[0] >> range1D[1];
+			else if( keyword == "LUT_3D_INPUT_RANGE" )
+				iss >> range3D[0] >> range3D[1];
+			// TITLE and unknown keywords are ignored
+			if( iss.fail() )
+				return false;
+			continue;
+		}
+		float r, g, b;
+		if( !( iss >> r >> g >> b ) )
+			return false;
+		values.push_back( r );
+		values.push_back( g );
+		values.push_back( b );
+	}
+
+	if( ( size1D == 0 && size3D < 2 ) || ( size1D == 1 ) || size3D == 1 )
+		return false;
+	if( values.size() != 3 * ( size1D + size3D * size3D * size3D ) )
+		return false;
+
+	const float* v = &values[0];
+	if( size1D )
+	{
+		Lut1D& shaper = lut.shaper();
+		shaper.resize( size1D );
+		// With a 3D table, the shaper output is the 3D input range,
+		// normalize it to lattice coordinates.
+		const float outMin = size3D ? range3D[0] : 0.0f;
+		const float outScale = size3D ? 1.0f / ( range3D[1] - range3D[0] ) : 1.0f;
+		for( std::size_t i = 0; i < size1D; ++i, v += 3 )
+			shaper.setValue( i, ( v[0] - outMin ) * outScale, ( v[1] - outMin ) * outScale, ( v[2] - outMin ) * outScale );
+		for( int c = 0; c < 3; ++c )
+		{
+			if( size3D )
+				shaper.setDomain( c, range1D[0], range1D[1] );
+			else
+				shaper.setDomain( c, domainMin[c], domainMax[c] );
+		}
+	}
+
+	if( size3D )
+	{
+		lut.resize( size3D );
+		for( std::size_t ib = 0; ib < size3D; ++ib )
+			for( std::size_t ig = 0; ig < size3D; ++ig )
+				for( std::size_t ir = 0; ir < size3D; ++ir, v += 3 )
+					lut.setValue( ir, ig, ib, v[0], v[1], v[2] );
+		for( int c = 0; c < 3; ++c )
+		{
+			if( size1D )
+				lut.setDomain( c, 0.0f, 1.0f );
+			else
+				lut.setDomain( c, domainMin[c], domainMax[c] );
+		}
+	}
+	else
+	{
+		// 1D only: identity lattice, the shaper does the job
+		lut.resize( 2 );
+		for( std::size_t ib = 0; ib < 2; ++ib )
+			for( std::size_t ig = 0; ig < 2; ++ig )
+				for( std::size_t ir = 0; ir < 2; ++ir )
+					lut.setValue( ir, ig, ib, ir, ig, ib );
+	}
+	return true;
+}
+
+/**
+ * @brief Read a .3dl lut (Autodesk Lustre/Flame).
+ *
+ * The first line of integers is the input mesh, then come the lattice
+ * nodes, blue fastest. Input and output bit depths are guessed from the
+ * values unless a "Mesh" keyword gives the output one. A non uniform
+ * input mesh is converted to a shaper.
+ *
+ * @return false if the file can't be read or is malformed
+ */
+inline bool read3dlLut( const std::string& filename, Lut3D& lut )
+{
+	std::ifstream in( filename.c_str() );
+	if( !in.good() )
+		return false;
+
+	std::vector<double> mesh;
+	std::vector<double> values;
+	double outputMax = 0.0;
+
+	std::string line;
+	while( details::nextLutLine( in, line ) )
+	{
+		std::istringstream iss( line );
+		if( std::isalpha( static_cast<unsigned char>( line[0] ) ) )
+		{
+			std::string keyword;
+			iss >> keyword;
+			if( keyword == "Mesh" )
+			{
+				int inputBits = 0, outputBits = 0;
+				iss >> inputBits >> outputBits;
+				outputMax = std::pow( 2.0, outputBits ) - 1.0;
+			}
+			// 3DMESH, LUT8, gamma... are ignored
+			continue;
+		}
+		if( mesh.empty() )
+		{
+			double m;
+			while( iss >> m )
+				mesh.push_back( m );
+			continue;
+		}
+		double r, g, b;
+		if( !( iss >> r >> g >> b ) )
+			return false;
+		values.push_back( r );
+		values.push_back( g );
+		values.push_back( b );
+	}
+
+	const std::size_t size = mesh.size();
+	if( size < 2 || values.size() != 3 * size * size * size )
+		return false;
+
+	if( outputMax == 0.0 )
+		outputMax = details::lutBitDepthMax( *std::max_element( values.begin(), values.end() ) );
+	const double inputMax = details::lutBitDepthMax( mesh.back() );
+	const float outputScale = 1.0 / outputMax;
+
+	lut.resize( size );
+	const double* v = &values[0];
+	for( std::size_t ir = 0; ir < size; ++ir )
+		for( std::size_t ig = 0; ig < size; ++ig )
+			for( std::size_t ib = 0; ib < size; ++ib, v += 3 )
+				lut.setValue( ir, ig, ib, v[0] * outputScale, v[1] * outputScale, v[2] * outputScale );
+
+	// uniform mesh: a plain domain is enough
+	const double meshStep = ( mesh.back() - mesh.front() ) / ( size - 1 );
+	bool uniform = true;
+	for( std::size_t i = 1; i < size && uniform; ++i )
+		uniform = std::abs( mesh[i] - mesh[i - 1] - meshStep ) <= 1.0;
+	if( uniform )
+	{
+		for( int c = 0; c < 3; ++c )
+			lut.setDomain( c, mesh.front() / inputMax, mesh.back() / inputMax );
+		return true;
+	}
+
+	// non uniform mesh: sample its inverse into the shaper
+	static const std::size_t kShaperSize = 1024;
+	Lut1D& shaper = lut.shaper();
+	shaper.resize( kShaperSize );
+	std::size_t m = 0;
+	for( std::size_t i = 0; i < kShaperSize; ++i )
+	{
+		const double x = mesh.front() + ( mesh.back() - mesh.front() ) * i / ( kShaperSize - 1 );
+		while( m < size - 2 && x > mesh[m + 1] )
+			++m;
+		const double pos = ( m + ( x - mesh[m] ) / ( mesh[m + 1] - mesh[m] ) ) / ( size - 1 );
+		shaper.setValue( i, pos, pos, pos );
+	}
+	for( int c = 0; c < 3; ++c )
+		shaper.setDomain( c, mesh.front() / inputMax, mesh.back() / inputMax );
+	return true;
+}
+
+/**
+ * @brief Read a lut, the format is deduced from the file extension (.cube or .3dl)
+ * @return false if the file can't be read, is malformed or has an unknown extension
+ */
+inline bool readLut( const std::string& filename, Lut3D& lut )
+{
+	const std::string lower = boost::algorithm::to_lower_copy( filename );
+	if( boost::algorithm::ends_with( lower, ".cube" ) )
+		return readCubeLut( filename, lut );
+	else if( boost::algorithm::ends_with( lower, ".3dl" ) )
+		return read3dlLut( filename, lut );
+	return false;
+}
+
+}
+}
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef _TERRY_EXPOSUREMERGE_HPP_
+#define _TERRY_EXPOSUREMERGE_HPP_
+
+#include <terry/simd.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace terry {
+
+/**
+ * @brief Merge of bracketed exposures into one radiance row (HDR).
+ *
+ * Each exposure is a row of linear values in [0, 1] taken with a known
+ * exposure time. Values are divided by their exposure time and averaged with
+ * a hat weight, so that the clipped and noisy samples count less:
+ * w(v) = 1 - |2v - 1|.
+ * Where every exposure is clipped, the shortest one is kept.
+ *
+ * Rows are independent, so an image is merged band by band by several
+ * threads, each one with its own ExposureMerge. Four values are processed at
+ * once, channels are merged independently.
+ */
+class ExposureMerge
+{
+public:
+	ExposureMerge()
+	: _size( 0 )
+	, _shortest( std::numeric_limits<float>::max() )
+	{}
+
+	/**
+	 * @brief start a new row of size values
+	 */
+	void reset( const std::size_t size )
+	{
+		_size = size;
+		// Rounded up so that the last values are processed with the others
+		const std::size_t padded = ( size + 3 ) & ~std::size_t( 3 );
+		_radiance.assign( padded, 0.0f );
+		_weights.assign( padded, 0.0f );
+		_fallback.assign( padded, 0.0f );
+		_values.resize( padded );
+		_shortest = std::numeric_limits<float>::max();
+	}
+
+	/**
+	 * @brief add an exposure of the row
+	 * @param values        size linear values in [0, 1]
+	 * @param exposureTime  exposure time of these values (any unit, the same for all exposures)
+	 */
+	void addExposure( const float* values, const float exposureTime )
+	{
+		using namespace simd;
+		std::copy( values, values + _size, _values.begin() );
+		std::fill( _values.begin() + _size, _values.end(), 0.0f );
+
+		const float4 invTime = set1( 1.0f / exposureTime );
+		const float4 two = set1( 2.0f );
+		const float4 minusOne = set1( -1.0f );
+		const float4 one = set1( 1.0f );
+		const float4 zero = set1( 0.0f );
+		const bool shortest = exposureTime < _shortest;
+		for( std::size_t i = 0; i < _values.size(); i += 4 )
+		{
+			const float4 v = load( &_values[i] );
+			const float4 t = madd( v, two, minusOne );
+			const float4 w = max( sub( one, max( t, sub( zero, t ) ) ), zero );
+			const float4 radiance = mul( v, invTime );
+			store( &_radiance[i], madd( w, radiance, load( &_radiance[i] ) ) );
+			store( &_weights[i], add( w, load( &_weights[i] ) ) );
+			if( shortest )
+				store( &_fallback[i], radiance );
+		}
+		if( shortest )
+			_shortest = exposureTime;
+	}
+
+	/**
+	 * @brief get the merged row
+	 * @param dst  size radiance values (in 1 / exposure time unit)
+	 */
+	void result( float* dst )
+	{
+		using namespace simd;
+		// (radiance + eps * fallback) / (weights + eps): the fallback only
+		// matters where no exposure has a weight, no branch needed.
+		const float4 epsilon = set1( 1e-4f );
+		for( std::size_t i = 0; i < _values.size(); i += 4 )
+		{
+			const float4 num = madd( epsilon, load( &_fallback[i] ), load( &_radiance[i] ) );
+			const float4 den = add( epsilon, load( &_weights[i] ) );
+			store( &_values[i], mul( num, rcp( den ) ) );
+		}
+		std::copy( _values.begin(), _values.begin() + _size, dst );
+	}
+
+private:
+	std::size_t _size;              ///< Number of values of the row
+	float _shortest;                ///< Shortest exposure time added
+	std::vector<float> _radiance;   ///< Sum of weighted radiances
+	std::vector<float> _weights;    ///< Sum of weights
+	std::vector<float> _fallback;   ///< Radiance of the shortest exposure
+	std::vector<float> _values;     ///< Scratch row
+};
+
+}
+
+#endif
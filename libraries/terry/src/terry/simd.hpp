@@ -0,0 +1,190 @@
+#ifndef _TERRY_SIMD_HPP_
+#define _TERRY_SIMD_HPP_
+
+/**
+ * @brief Minimal 4 lanes float vector used by the terry kernels.
+ *
+ * SSE2 is used on x86, NEON on ARM (Raspberry Pi), with a plain scalar
+ * fallback everywhere else. Only the operations needed by the kernels are
+ * exposed, all loads and stores are unaligned.
+ */
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define TERRY_SIMD_SSE2
+#include <emmintrin.h>
+#elif defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+#define TERRY_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+#include <algorithm>
+#include <cstddef>
+
+namespace terry {
+namespace simd {
+
+#if defined( TERRY_SIMD_SSE2 )
+
+struct float4
+{
+	__m128 v;
+};
+
+inline float4 make( const __m128 v ) { float4 r; r.v = v; return r; }
+inline float4 load( const float* p ) { return make( _mm_loadu_ps( p ) ); }
+inline void store( float* p, const float4& a ) { _mm_storeu_ps( p, a.v ); }
+inline float4 set1( const float s ) { return make( _mm_set1_ps( s ) ); }
+inline float4 set( const float a, const float b, const float c, const float d ) { return make( _mm_setr_ps( a, b, c, d ) ); }
+inline float4 add( const float4& a, const float4& b ) { return make( _mm_add_ps( a.v, b.v ) ); }
+inline float4 sub( const float4& a, const float4& b ) { return make( _mm_sub_ps( a.v, b.v ) ); }
+inline float4 mul( const float4& a, const float4& b ) { return make( _mm_mul_ps( a.v, b.v ) ); }
+inline float4 min( const float4& a, const float4& b ) { return make( _mm_min_ps( a.v, b.v ) ); }
+inline float4 max( const float4& a, const float4& b ) { return make( _mm_max_ps( a.v, b.v ) ); }
+/// @brief a * b + c
+inline float4 madd( const float4& a, const float4& b, const float4& c ) { return make( _mm_add_ps( _mm_mul_ps( a.v, b.v ), c.v ) ); }
+/// @brief fast reciprocal, refined by one newton-raphson step
+inline float4 rcp( const float4& a )
+{
+	const __m128 r = _mm_rcp_ps( a.v );
+	return make( _mm_sub_ps( _mm_add_ps( r, r ), _mm_mul_ps( _mm_mul_ps( r, r ), a.v ) ) );
+}
+
+#elif defined( TERRY_SIMD_NEON )
+
+struct float4
+{
+	float32x4_t v;
+};
+
+inline float4 make( const float32x4_t v ) { float4 r; r.v = v; return r; }
+inline float4 load( const float* p ) { return make( vld1q_f32( p ) ); }
+inline void store( float* p, const float4& a ) { vst1q_f32( p, a.v ); }
+inline float4 set1( const float s ) { return make( vdupq_n_f32( s ) ); }
+inline float4 set( const float a, const float b, const float c, const float d )
+{
+	const float tmp[4] = { a, b, c, d };
+	return load( tmp );
+}
+inline float4 add( const float4& a, const float4& b ) { return make( vaddq_f32( a.v, b.v ) ); }
+inline float4 sub( const float4& a, const float4& b ) { return make( vsubq_f32( a.v, b.v ) ); }
+inline float4 mul( const float4& a, const float4& b ) { return make( vmulq_f32( a.v, b.v ) ); }
+inline float4 min( const float4& a, const float4& b ) { return make( vminq_f32( a.v, b.v ) ); }
+inline float4 max( const float4& a, const float4& b ) { return make( vmaxq_f32( a.v, b.v ) ); }
+/// @brief a * b + c
+inline float4 madd( const float4& a, const float4& b, const float4& c ) { return make( vmlaq_f32( c.v, a.v, b.v ) ); }
+/// @brief fast reciprocal, refined by one newton-raphson step
+inline float4 rcp( const float4& a )
+{
+	const float32x4_t r = vrecpeq_f32( a.v );
+	return make( vmulq_f32( vrecpsq_f32( a.v, r ), r ) );
+}
+
+#else
+
+struct float4
+{
+	float v[4];
+};
+
+inline float4 load( const float* p ) { float4 r; r.v[0] = p[0]; r.v[1] = p[1]; r.v[2] = p[2]; r.v[3] = p[3]; return r; }
+inline void store( float* p, const float4& a ) { p[0] = a.v[0]; p[1] = a.v[1]; p[2] = a.v[2]; p[3] = a.v[3]; }
+inline float4 set( const float a, const float b, const float c, const float d ) { float4 r; r.v[0] = a; r.v[1] = b; r.v[2] = c; r.v[3] = d; return r; }
+inline float4 set1( const float s ) { return set( s, s, s, s ); }
+inline float4 add( const float4& a, const float4& b ) { return set( a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] ); }
+inline float4 sub( const float4& a, const float4& b ) { return set( a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3] ); }
+inline float4 mul( const float4& a, const float4& b ) { return set( a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3] ); }
+inline float4 min( const float4& a, const float4& b ) { return set( std::min( a.v[0], b.v[0] ), std::min( a.v[1], b.v[1] ), std::min( a.v[2], b.v[2] ), std::min( a.v[3], b.v[3] ) ); }
+inline float4 max( const float4& a, const float4& b ) { return set( std::max( a.v[0], b.v[0] ), std::max( a.v[1], b.v[1] ), std::max( a.v[2], b.v[2] ), std::max( a.v[3], b.v[3] ) ); }
+/// @brief a * b + c
+inline float4 madd( const float4& a, const float4& b, const float4& c ) { return add( mul( a, b ), c ); }
+inline float4 rcp( const float4& a ) { return set( 1.0f / a.v[0], 1.0f / a.v[1], 1.0f / a.v[2], 1.0f / a.v[3] ); }
+
+#endif
+
+/// @brief clamp each lane into [lo, hi]
+inline float4 clamp( const float4& a, const float4& lo, const float4& hi )
+{
+	return min( max( a, lo ), hi );
+}
+
+/**
+ * @brief split n interleaved rgba pixels into 4 channel planes
+ */
+inline void deinterleave4( const float* src, float* const* planes, const std::size_t n )
+{
+	std::size_t i = 0;
+#if defined( TERRY_SIMD_SSE2 )
+	for( ; i + 4 <= n; i += 4, src += 16 )
+	{
+		__m128 p0 = _mm_loadu_ps( src );
+		__m128 p1 = _mm_loadu_ps( src + 4 );
+		__m128 p2 = _mm_loadu_ps( src + 8 );
+		__m128 p3 = _mm_loadu_ps( src + 12 );
+		_MM_TRANSPOSE4_PS( p0, p1, p2, p3 );
+		_mm_storeu_ps( planes[0] + i, p0 );
+		_mm_storeu_ps( planes[1] + i, p1 );
+		_mm_storeu_ps( planes[2] + i, p2 );
+		_mm_storeu_ps( planes[3] + i, p3 );
+	}
+#elif defined( TERRY_SIMD_NEON )
+	for( ; i + 4 <= n; i += 4, src += 16 )
+	{
+		const float32x4x4_t p = vld4q_f32( src );
+		vst1q_f32( planes[0] + i, p.val[0] );
+		vst1q_f32( planes[1] + i, p.val[1] );
+		vst1q_f32( planes[2] + i, p.val[2] );
+		vst1q_f32( planes[3] + i, p.val[3] );
+	}
+#endif
+	for( ; i < n; ++i, src += 4 )
+	{
+		planes[0][i] = src[0];
+		planes[1][i] = src[1];
+		planes[2][i] = src[2];
+		planes[3][i] = src[3];
+	}
+}
+
+/**
+ * @brief merge 4 channel planes of n pixels into interleaved rgba pixels
+ */
+inline void interleave4( const float* const* planes, float* dst, const std::size_t n )
+{
+	std::size_t i = 0;
+#if defined( TERRY_SIMD_SSE2 )
+	for( ; i + 4 <= n; i += 4, dst += 16 )
+	{
+		__m128 p0 = _mm_loadu_ps( planes[0] + i );
+		__m128 p1 = _mm_loadu_ps( planes[1] + i );
+		__m128 p2 = _mm_loadu_ps( planes[2] + i );
+		__m128 p3 = _mm_loadu_ps( planes[3] + i );
+		_MM_TRANSPOSE4_PS( p0, p1, p2, p3 );
+		_mm_storeu_ps( dst, p0 );
+		_mm_storeu_ps( dst + 4, p1 );
+		_mm_storeu_ps( dst + 8, p2 );
+		_mm_storeu_ps( dst + 12, p3 );
+	}
+#elif defined( TERRY_SIMD_NEON )
+	for( ; i + 4 <= n; i += 4, dst += 16 )
+	{
+		float32x4x4_t p;
+		p.val[0] = vld1q_f32( planes[0] + i );
+		p.val[1] = vld1q_f32( planes[1] + i );
+		p.val[2] = vld1q_f32( planes[2] + i );
+		p.val[3] = vld1q_f32( planes[3] + i );
+		vst4q_f32( dst, p );
+	}
+#endif
+	for( ; i < n; ++i, dst += 4 )
+	{
+		dst[0] = planes[0][i];
+		dst[1] = planes[1][i];
+		dst[2] = planes[2][i];
+		dst[3] = planes[3][i];
+	}
+}
+
+}
+}
+
+#endif
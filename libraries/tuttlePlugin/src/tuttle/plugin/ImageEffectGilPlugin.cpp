@@ -1,5 +1,7 @@
 #include "ImageEffectGilPlugin.hpp"
 
+#include <tuttle/plugin/numeric/rectOp.hpp>
+
 #include <ofxsImageEffect.h>
 #include <ofxsMultiThread.h>
 
@@ -18,5 +20,52 @@ ImageEffectGilPlugin::ImageEffectGilPlugin( OfxImageEffectHandle handle )
 ImageEffectGilPlugin::~ImageEffectGilPlugin()
 {}
 
+bool ImageEffectGilPlugin::getSourceHalo( OfxPointI& halo ) const
+{
+	return false;
+}
+
+void ImageEffectGilPlugin::getRegionsOfInterest( const OFX::RegionsOfInterestArguments& args, OFX::RegionOfInterestSetter& rois )
+{
+	if( ! _clipSrc->isConnected() )
+		return;
+	const OfxRectD srcRod = _clipSrc->getCanonicalRod( args.time );
+	OfxPointI halo;
+	if( ! getSourceHalo( halo ) )
+	{
+		rois.setRegionOfInterest( *_clipSrc, srcRod );
+		return;
+	}
+	// The halo is in pixels, the regions of interest in canonical coordinates
+	const double marginX = halo.x * _clipSrc->getPixelAspectRatio();
+	const double marginY = halo.y;
+	OfxRectD srcRoi = args.regionOfInterest;
+	srcRoi.x1 -= marginX;
+	srcRoi.y1 -= marginY;
+	srcRoi.x2 += marginX;
+	srcRoi.y2 += marginY;
+	rois.setRegionOfInterest( *_clipSrc, rectanglesIntersection( srcRoi, srcRod ) );
+}
+
+void describeGilBitDepths( OFX::ImageEffectDescriptor& desc, const unsigned int bitDepths )
+{
+	if( bitDepths & eGilBitDepth8 )
+		desc.addSupportedBitDepth( OFX::eBitDepthUByte );
+	if( bitDepths & eGilBitDepth16 )
+		desc.addSupportedBitDepth( OFX::eBitDepthUShort );
+	if( bitDepths & eGilBitDepth32f )
+		desc.addSupportedBitDepth( OFX::eBitDepthFloat );
+}
+
+void describeGilLayouts( OFX::ClipDescriptor& clip, const unsigned int layouts )
+{
+	if( layouts & eGilLayoutRGBA )
+		clip.addSupportedComponent( OFX::ePixelComponentRGBA );
+	if( layouts & eGilLayoutRGB )
+		clip.addSupportedComponent( OFX::ePixelComponentRGB );
+	if( layouts & eGilLayoutGray )
+		clip.addSupportedComponent( OFX::ePixelComponentAlpha );
+}
+
 }
 }
@@ -20,6 +20,18 @@ public:
 	ImageEffectGilPlugin( OfxImageEffectHandle handle );
 	virtual ~ImageEffectGilPlugin() = 0;
 
+	/**
+	 * @brief Source pixels needed around each rendered pixel, at render scale 1.
+	 * Only a plugin supporting tiles gets render windows smaller than the image.
+	 * @return false if the render needs the whole source image (default)
+	 */
+	virtual bool getSourceHalo( OfxPointI& halo ) const;
+
+	/**
+	 * @brief The source region of interest is the render window grown by the source halo.
+	 */
+	virtual void getRegionsOfInterest( const OFX::RegionsOfInterestArguments& args, OFX::RegionOfInterestSetter& rois );
+
 public:
     // do not need to delete these, the ImageEffect is managing them for us
     OFX::Clip *_clipDst; ///< Destination image clip
@@ -54,6 +66,43 @@ template< template<class> class Process,
           class Plugin >
 void doGilRender( Plugin& plugin, const OFX::RenderArguments& args );
 
+/// Pixel layouts of a plugin (doGilRenderFormats), to combine with |
+enum EGilLayouts
+{
+	eGilLayoutGray = 1,
+	eGilLayoutRGB  = 1 << 1,
+	eGilLayoutRGBA = 1 << 2,
+	eGilLayoutsAll = eGilLayoutGray | eGilLayoutRGB | eGilLayoutRGBA
+};
+
+/// Bit depths of a plugin (doGilRenderFormats), to combine with |
+enum EGilBitDepths
+{
+	eGilBitDepth8   = 1,
+	eGilBitDepth16  = 1 << 1,
+	eGilBitDepth32f = 1 << 2,
+	eGilBitDepthsAll = eGilBitDepth8 | eGilBitDepth16 | eGilBitDepth32f
+};
+
+/**
+ * @brief Like doGilRender, but the Process class is only instantiated for the layouts and bit depths of the sets.
+ * The other formats of the dst clip throw exception::Unsupported: declare the same sets with describeGilBitDepths and describeGilLayouts.
+ */
+template< template<class> class Process,
+          unsigned int Layouts, unsigned int BitDepths,
+          class Plugin >
+void doGilRenderFormats( Plugin& plugin, const OFX::RenderArguments& args );
+
+/**
+ * @brief Declare the bit depths of the set to the host.
+ */
+void describeGilBitDepths( OFX::ImageEffectDescriptor& desc, const unsigned int bitDepths );
+
+/**
+ * @brief Declare the layouts of the set as the components of a clip.
+ */
+void describeGilLayouts( OFX::ClipDescriptor& clip, const unsigned int layouts );
+
 template< template<class,class> class Process,
           bool splanar, class SLayout, class SBits,
 		  bool dplanar, class DLayout, class DBits,
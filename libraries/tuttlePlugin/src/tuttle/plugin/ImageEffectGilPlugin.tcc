@@ -101,6 +101,99 @@ void doGilRender( Plugin& plugin, const OFX::RenderArguments& args )
 	doGilRender<Process, Plugin>( plugin, args, *plugin._clipDst );
 }
 
+namespace detail {
+
+/// Instantiates the Process class for a format only when it is enabled
+template< bool Enabled >
+struct GilFormatRender
+{
+	template< template<class> class Process, class Layout, class Bits, class Plugin >
+	static void render( Plugin& plugin, const OFX::RenderArguments& args, const OFX::EPixelComponent, const OFX::EBitDepth )
+	{
+		doGilRender<Process, false, Layout, Bits>( plugin, args );
+	}
+};
+
+template<>
+struct GilFormatRender<false>
+{
+	template< template<class> class Process, class Layout, class Bits, class Plugin >
+	static void render( Plugin&, const OFX::RenderArguments&, const OFX::EPixelComponent component, const OFX::EBitDepth bitDepth )
+	{
+		BOOST_THROW_EXCEPTION( exception::Unsupported()
+			<< exception::user() + "Image format (" + mapPixelComponentEnumToString(component) + ", " + mapBitDepthEnumToString(bitDepth) + ") not supported by the plugin." );
+	}
+};
+
+template< template<class> class Process,
+          unsigned int BitDepths, class Layout,
+          class Plugin >
+void doGilRenderBitDepths( Plugin& plugin, const OFX::RenderArguments& args, const OFX::EPixelComponent component, const OFX::EBitDepth bitDepth )
+{
+	switch( bitDepth )
+	{
+		case OFX::eBitDepthUByte:
+		{
+			GilFormatRender<( BitDepths & eGilBitDepth8 ) != 0>::template render<Process, Layout, boost::gil::bits8>( plugin, args, component, bitDepth );
+			return;
+		}
+		case OFX::eBitDepthUShort:
+		{
+			GilFormatRender<( BitDepths & eGilBitDepth16 ) != 0>::template render<Process, Layout, boost::gil::bits16>( plugin, args, component, bitDepth );
+			return;
+		}
+		case OFX::eBitDepthFloat:
+		{
+			GilFormatRender<( BitDepths & eGilBitDepth32f ) != 0>::template render<Process, Layout, boost::gil::bits32f>( plugin, args, component, bitDepth );
+			return;
+		}
+		case OFX::eBitDepthCustom:
+		case OFX::eBitDepthNone:
+		{
+			BOOST_THROW_EXCEPTION( exception::Unsupported()
+				<< exception::user() + "Bit depth (" + mapBitDepthEnumToString(bitDepth) + ") not recognized by the plugin." );
+		}
+	}
+	BOOST_THROW_EXCEPTION( exception::Unknown() );
+}
+
+}
+
+template< template<class> class Process,
+          unsigned int Layouts, unsigned int BitDepths,
+          class Plugin >
+void doGilRenderFormats( Plugin& plugin, const OFX::RenderArguments& args )
+{
+	// A layout out of the set gets no bit depth: nothing is instantiated for it
+	const OFX::EPixelComponent component = plugin._clipDst->getPixelComponents();
+	const OFX::EBitDepth bitDepth = plugin._clipDst->getPixelDepth();
+	switch( component )
+	{
+		case OFX::ePixelComponentRGBA:
+		{
+			detail::doGilRenderBitDepths<Process, ( Layouts & eGilLayoutRGBA ) ? BitDepths : 0u, boost::gil::rgba_layout_t>( plugin, args, component, bitDepth );
+			return;
+		}
+		case OFX::ePixelComponentRGB:
+		{
+			detail::doGilRenderBitDepths<Process, ( Layouts & eGilLayoutRGB ) ? BitDepths : 0u, boost::gil::rgb_layout_t>( plugin, args, component, bitDepth );
+			return;
+		}
+		case OFX::ePixelComponentAlpha:
+		{
+			detail::doGilRenderBitDepths<Process, ( Layouts & eGilLayoutGray ) ? BitDepths : 0u, boost::gil::gray_layout_t>( plugin, args, component, bitDepth );
+			return;
+		}
+		case OFX::ePixelComponentCustom:
+		case OFX::ePixelComponentNone:
+		{
+			BOOST_THROW_EXCEPTION( exception::Unsupported()
+				<< exception::user() + "Pixel component (" + mapPixelComponentEnumToString(component) + ") not supported by the plugin." );
+		}
+	}
+	BOOST_THROW_EXCEPTION( exception::Unknown() );
+}
+
 
 template< template<class,class> class Process,
           bool sPlanar, class SLayout, class SBits,
@@ -51,6 +51,7 @@ void ImageGilFilterProcessor<SView, DView>::setup( const OFX::RenderArguments& a
 	// source view
 //	TUTTLE_LOG_INFOS;
 //	TUTTLE_LOG_VAR( TUTTLE_INFO, "src - fetchImage " << time );
+	// Only the region of interest declared by the plugin (see ImageEffectGilPlugin::getSourceHalo)
 	_src.reset( _clipSrc->fetchImage( args.time ) );
 	if( ! _src.get() )
 		BOOST_THROW_EXCEPTION( exception::ImageNotReady()
@@ -0,0 +1,81 @@
+#ifndef _TUTTLE_PLUGIN_IMAGEGILPLANARPROCESSOR_HPP_
+#define _TUTTLE_PLUGIN_IMAGEGILPLANARPROCESSOR_HPP_
+
+#include "ImageGilFilterProcessor.hpp"
+
+#include <terry/simd.hpp>
+
+#include <boost/gil/gil_all.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace tuttle {
+namespace plugin {
+
+/**
+ * @brief Base class of the filters working on float channel planes.
+ *
+ * Each row of the band given to a thread is converted to rgba floats, split
+ * into 4 contiguous planes (r, g, b, a) with SIMD shuffles, given to
+ * processPlanes, then merged and converted back to the destination. Per
+ * channel kernels only see arrays of floats: they vectorize without any
+ * gather, whatever the layout and the bit depth of the clips.
+ */
+template <class SView, class DView = SView>
+class ImageGilPlanarProcessor : public ImageGilFilterProcessor<SView, DView>
+{
+public:
+	typedef boost::gil::rgba32f_pixel_t WorkPixel;
+	static const std::size_t kNbPlanes = 4;
+
+	ImageGilPlanarProcessor( OFX::ImageEffect& effect, const EImageOrientation imageOrientation )
+		: ImageGilFilterProcessor<SView, DView>( effect, imageOrientation )
+	{}
+	virtual ~ImageGilPlanarProcessor() {}
+
+	void multiThreadProcessImages( const OfxRectI& procWindowRoW )
+	{
+		using namespace boost::gil;
+		const OfxRectI procWindowOutput = this->translateRoWToOutputClipCoordinates( procWindowRoW );
+		const int x1 = procWindowOutput.x1;
+		const int width = procWindowOutput.x2 - procWindowOutput.x1;
+		if( width <= 0 )
+			return;
+
+		// Buffers of the thread, reused for all the rows of its band
+		std::vector<WorkPixel> row( width );
+		std::vector<float> planeBuffer( kNbPlanes * width );
+		float* planes[kNbPlanes];
+		for( std::size_t c = 0; c < kNbPlanes; ++c )
+			planes[c] = &planeBuffer[c * width];
+		const float* const* constPlanes = planes;
+		float* rowData = reinterpret_cast<float*>( &row[0] );
+		const rgba32f_view_t rowView = interleaved_view( width, 1, &row[0], width * sizeof( WorkPixel ) );
+
+		for( int y = procWindowOutput.y1; y < procWindowOutput.y2; ++y )
+		{
+			copy_and_convert_pixels( subimage_view( this->_srcView, x1, y, width, 1 ), rowView );
+			terry::simd::deinterleave4( rowData, planes, width );
+			processPlanes( planes, width, y );
+			terry::simd::interleave4( constPlanes, rowData, width );
+			copy_and_convert_pixels( rowView, subimage_view( this->_dstView, x1, y, width, 1 ) );
+			if( this->progressForward( width ) )
+				return;
+		}
+	}
+
+protected:
+	/**
+	 * @brief process a row in place
+	 * @param planes  kNbPlanes planes (red, green, blue, alpha) of width floats
+	 * @param width   number of pixels of the row
+	 * @param y       row index in the output clip
+	 */
+	virtual void processPlanes( float* const* planes, const std::size_t width, const int y ) = 0;
+};
+
+}
+}
+
+#endif
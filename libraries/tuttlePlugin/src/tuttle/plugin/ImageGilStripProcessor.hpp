@@ -0,0 +1,69 @@
+#ifndef _TUTTLE_PLUGIN_IMAGEGILSTRIPPROCESSOR_HPP_
+#define _TUTTLE_PLUGIN_IMAGEGILSTRIPPROCESSOR_HPP_
+
+#include "ImageGilFilterProcessor.hpp"
+#include "StripStreamer.hpp"
+
+#include <boost/gil/gil_all.hpp>
+
+#include <algorithm>
+
+namespace tuttle {
+namespace plugin {
+
+/**
+ * @brief Base class of the filters made of a chain of row stages (see StripStreamer).
+ *
+ * Each band of rows given to a thread is streamed thru the stages, in rgba
+ * floats: the intermediate results never take more than a few rows per
+ * stage, whatever the image size. Per pixel and small kernel filters can be
+ * chained in one node this way instead of one full frame per node.
+ */
+template <class SView, class DView = SView>
+class ImageGilStripProcessor : public ImageGilFilterProcessor<SView, DView>
+{
+public:
+	typedef boost::gil::rgba32f_pixel_t WorkPixel;
+
+	ImageGilStripProcessor( OFX::ImageEffect& effect, const EImageOrientation imageOrientation )
+		: ImageGilFilterProcessor<SView, DView>( effect, imageOrientation )
+	{}
+	virtual ~ImageGilStripProcessor() {}
+
+	void multiThreadProcessImages( const OfxRectI& procWindowRoW )
+	{
+		using namespace boost::gil;
+		const OfxRectI procWindowOutput = this->translateRoWToOutputClipCoordinates( procWindowRoW );
+		const int x1 = procWindowOutput.x1;
+		const int width = procWindowOutput.x2 - procWindowOutput.x1;
+		if( width <= 0 )
+			return;
+
+		StripStreamer streamer( width, num_channels<WorkPixel>::value );
+		addStages( streamer, procWindowOutput );
+		streamer.run( procWindowOutput.y1, procWindowOutput.y2, this->_srcView.height(),
+			[this, x1, width]( const int y, float* row )
+			{
+				copy_and_convert_pixels( subimage_view( this->_srcView, x1, y, width, 1 ),
+				                         interleaved_view( width, 1, reinterpret_cast<WorkPixel*>( row ), width * sizeof( WorkPixel ) ) );
+			},
+			[this, x1, width]( const int y, const float* row )
+			{
+				copy_and_convert_pixels( interleaved_view( width, 1, reinterpret_cast<const WorkPixel*>( row ), width * sizeof( WorkPixel ) ),
+				                         subimage_view( this->_dstView, x1, y, width, 1 ) );
+				return !this->progressForward( width );
+			} );
+	}
+
+protected:
+	/**
+	 * @brief add the stages of the filter, called for each band (a stage can keep state for its band)
+	 * @param procWindowOutput  band in output clip coordinates, the rows of the stages start at its x1
+	 */
+	virtual void addStages( StripStreamer& streamer, const OfxRectI& procWindowOutput ) = 0;
+};
+
+}
+}
+
+#endif
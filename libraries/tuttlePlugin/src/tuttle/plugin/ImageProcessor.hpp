@@ -3,6 +3,7 @@
 
 #include "exceptions.hpp"
 #include "OfxProgress.hpp"
+#include "RenderProfiler.hpp"
 
 #include <tuttle/plugin/image.hpp>
 #include <tuttle/plugin/exceptions.hpp>
@@ -17,12 +18,17 @@
 #include <boost/exception/error_info.hpp>
 #include <boost/throw_exception.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <cstdlib>
 #include <vector>
 
 namespace tuttle {
 namespace plugin {
 
+/// Default number of rows of the tiles pulled by the rendering threads
+static const int kDefaultTileRows = 64;
+
 /**
  * @brief Base class that can be used to process images of any type.
  */
@@ -41,6 +47,10 @@ protected:
 
 private:
 	unsigned int _nbThreads;
+	int _tileRows;                ///< Rows of a tile, 0 for one band per thread
+	std::atomic<int> _nextTiles[OFX::MultiThread::kMaxNumaNodes]; ///< Next tile to process of the rows of each numa node
+	bool _profiling;              ///< The render is recorded by the RenderProfiler
+	RenderProfile _profile;       ///< Timings of the current render
 
 public:
 	/** @brief ctor */
@@ -49,7 +59,10 @@ public:
 		, _effect( effect )
 		, _imageOrientation( imageOrientation )
 		, _nbThreads( 0 ) // auto, maximum allowable number of CPUs will be used
+		, _tileRows( kDefaultTileRows )
+		, _profiling( false )
 	{
+		resetTiles();
 		_dstPixelRod.x1 = _dstPixelRod.y1 = _dstPixelRod.x2 = _dstPixelRod.y2 = 0;
 		_dstPixelRodSize.x = _dstPixelRodSize.y = 0;
 		_renderWindowSize.x = _renderWindowSize.y = 0;
@@ -67,6 +80,8 @@ public:
 	void setNoMultiThreading()                        { _nbThreads = 1; }
 	void setNbThreads( const unsigned int nbThreads ) { _nbThreads = nbThreads; }
 	void setNbThreadsAuto()                           { _nbThreads = 0; }
+	/** @brief split the render window into tiles of tileRows full rows pulled by the threads, 0 for one band per thread */
+	void setTileRows( const int tileRows )            { _tileRows = tileRows; }
 
 	/** @brief called before any MP is done */
 	virtual void preProcess() { progressBegin( _renderWindowSize.y * _renderWindowSize.x ); }
@@ -108,6 +123,17 @@ public:
 		_renderArgs = args;
 		_renderWindowSize.x = ( _renderArgs.renderWindow.x2 - _renderArgs.renderWindow.x1 );
 		_renderWindowSize.y = ( _renderArgs.renderWindow.y2 - _renderArgs.renderWindow.y1 );
+		_profiling = RenderProfiler::instance().enabled();
+		double setupCpu = 0.0;
+		if( _profiling )
+		{
+			_profile = RenderProfile();
+			_profile.node = _effect.getName();
+			_profile.thread = RenderProfiler::currentThreadId();
+			_profile.time = args.time;
+			_profile.start = RenderProfiler::instance().now();
+			setupCpu = RenderProfiler::threadCpuTime();
+		}
 		try
 		{
 			setup( args );
@@ -135,15 +161,67 @@ public:
 			throw;
 		}
 
+		if( _profiling )
+		{
+			_profile.setup = RenderProfiler::instance().now() - _profile.start;
+			_profile.cpu = RenderProfiler::threadCpuTime() - setupCpu;
+			_profile.dstBytes = _dst->getBoundsImageDataBytes();
+		}
+
 		// Call the base class process member
 		this->process();
+
+		if( _profiling )
+			RenderProfiler::instance().record( _profile );
 	}
 
 	/** @brief overridden from OFX::MultiThread::Processor. This function is called once on each SMP thread by the base class */
 	void multiThreadFunction( const unsigned int threadId, const unsigned int nThreads )
 	{
-		// slice the y range into the number of threads it has
+		if( ! _profiling || threadId >= _profile.threads.size() )
+		{
+			processTiles( threadId, nThreads, NULL );
+			return;
+		}
+		if( threadId == 0 )
+			_profile.nbThreads = nThreads;
+		ThreadProfile& thread = _profile.threads[threadId];
+		thread.thread = RenderProfiler::currentThreadId();
+		const double cpuStart = RenderProfiler::threadCpuTime();
+		thread.start = RenderProfiler::instance().now();
+		processTiles( threadId, nThreads, &thread.nbTiles );
+		thread.end = RenderProfiler::instance().now();
+		thread.cpu = RenderProfiler::threadCpuTime() - cpuStart;
+	}
+
+	/**
+	 * @brief process the tiles of a thread
+	 * @param nbTiles  incremented for each tile if not null
+	 */
+	void processTiles( const unsigned int threadId, const unsigned int nThreads, int* nbTiles )
+	{
 		const int dy   = std::abs( _renderArgs.renderWindow.y2 - _renderArgs.renderWindow.y1 );
+		if( _tileRows > 0 && nThreads > 1 )
+		{
+			// Threads pull tiles until the window is done: a costly tile or
+			// a busy core only delays its own rows. Small windows still give
+			// a few tiles per thread.
+			const int tileRows = std::max( 1, std::min<int>( _tileRows, dy / ( 4 * nThreads ) ) );
+			// On a numa host the rows are split between the nodes the same
+			// way for every image: the threads of a node first pull the tiles
+			// of its rows, which stay in its memory from node to node, then
+			// help the other nodes with theirs.
+			const unsigned int nbParts = OFX::MultiThread::getNumaNodes();
+			const unsigned int part = OFX::MultiThread::getThreadNumaNode( threadId, nThreads );
+			for( unsigned int i = 0; i < nbParts; ++i )
+			{
+				if( ! processPartTiles( ( part + i ) % nbParts, nbParts, tileRows, nbTiles ) )
+					return;
+			}
+			return;
+		}
+
+		// slice the y range into the number of threads it has
 		const int y1   = _renderArgs.renderWindow.y1 + threadId * dy / nThreads;
 		const int step = ( threadId + 1 ) * dy / nThreads;
 		const int y2   = _renderArgs.renderWindow.y1 + ( step < dy ? step : dy );
@@ -154,6 +232,39 @@ public:
 
 		// and render that thread on each
 		multiThreadProcessImages( winRoW );
+		if( nbTiles )
+			++*nbTiles;
+	}
+
+	/**
+	 * @brief pull the tiles of the rows of a numa node until there are none left
+	 * @return false if the render has been aborted
+	 */
+	bool processPartTiles( const unsigned int part, const unsigned int nbParts, const int tileRows, int* nbTiles )
+	{
+		const int dy     = std::abs( _renderArgs.renderWindow.y2 - _renderArgs.renderWindow.y1 );
+		const int partY1 = part * dy / nbParts;
+		const int partDy = ( part + 1 ) * dy / nbParts - partY1;
+		std::atomic<int>& nextTile = _nextTiles[part];
+		OfxRectI winRoW = _renderArgs.renderWindow;
+		for( int tile = nextTile++; tile * tileRows < partDy; tile = nextTile++ )
+		{
+			winRoW.y1 = _renderArgs.renderWindow.y1 + partY1 + tile * tileRows;
+			winRoW.y2 = _renderArgs.renderWindow.y1 + partY1 + std::min( partDy, ( tile + 1 ) * tileRows );
+			multiThreadProcessImages( winRoW );
+			if( nbTiles )
+				++*nbTiles;
+			if( _effect.abort() )
+				return false;
+		}
+		return true;
+	}
+
+	/** @brief start the tiles of all the numa nodes from the first one */
+	void resetTiles()
+	{
+		for( unsigned int i = 0; i < OFX::MultiThread::kMaxNumaNodes; ++i )
+			_nextTiles[i] = 0;
 	}
 
 	/** @brief this is called by multiThreadFunction to actually process images, override in derived classes */
@@ -175,13 +286,42 @@ public:
 			BOOST_THROW_EXCEPTION( exception::ImageFormat() << exception::user( "RenderWindow empty !" ) );
 		}
 		// call the pre MP pass
+		double preProcessCpu = 0.0;
+		if( _profiling )
+		{
+			_profile.preProcessStart = RenderProfiler::instance().now();
+			preProcessCpu = RenderProfiler::threadCpuTime();
+		}
 		preProcess();
+		if( _profiling )
+		{
+			_profile.preProcess = RenderProfiler::instance().now() - _profile.preProcessStart;
+			_profile.preProcessCpu = RenderProfiler::threadCpuTime() - preProcessCpu;
+			_profile.cpu += _profile.preProcessCpu;
+		}
 
 		// call the base multi threading code, should put a pre & post thread calls in too
+		resetTiles();
+		if( _profiling )
+		{
+			_profile.threads.assign( _nbThreads ? _nbThreads : OFX::MultiThread::getNumCPUs(), ThreadProfile() );
+			_profile.multiThreadStart = RenderProfiler::instance().now();
+		}
 		multiThread( _nbThreads );
 
 		// call the post MP pass
+		double postProcessCpu = 0.0;
+		if( _profiling )
+		{
+			_profile.multiThread = RenderProfiler::instance().now() - _profile.multiThreadStart;
+			postProcessCpu = RenderProfiler::threadCpuTime();
+		}
 		postProcess();
+		if( _profiling )
+		{
+			_profile.postProcess = RenderProfiler::instance().now() - _profile.multiThreadStart - _profile.multiThread;
+			_profile.cpu += RenderProfiler::threadCpuTime() - postProcessCpu;
+		}
 	}
 };
 
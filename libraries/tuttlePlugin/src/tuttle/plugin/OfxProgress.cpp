@@ -2,6 +2,10 @@
 
 #include <ofxsMultiThread.h>
 
+#include <algorithm>
+#include <functional>
+#include <thread>
+
 namespace tuttle {
 namespace plugin {
 
@@ -15,9 +19,23 @@ void OfxProgress::progressBegin( const int numSteps, const std::string& msg )
 {
 	_counter = 0.0;
 	_stepSize = 1.0 / static_cast<double>( numSteps );
+	// Each thread updates the host every 1% of the steps
+	_updateSteps = std::max( 1, numSteps / 100 );
+	for( std::size_t i = 0; i < kNbProgressCounters; ++i )
+	{
+		_counters[i].steps = 0;
+		_counters[i].nextUpdate = _updateSteps;
+	}
+	_updating = false;
+	_aborted = false;
 	_effect.progressStart( msg );
 }
 
+OfxProgress::Counter& OfxProgress::threadCounter()
+{
+	return _counters[std::hash<std::thread::id>()( std::this_thread::get_id() ) % kNbProgressCounters];
+}
+
 /**
  * @brief Put the progress bar forward.
  *
@@ -29,28 +47,60 @@ void OfxProgress::progressBegin( const int numSteps, const std::string& msg )
  */
 bool OfxProgress::progressForward( const int nSteps )
 {
-	_mutex.lock();
-	_counter += _stepSize * static_cast<double>( nSteps );
-	/// @todo why not unlock the mutex here?
-	if( _effect.abort() )
+	Counter& counter = threadCounter();
+	const long long steps = counter.steps.fetch_add( nSteps, std::memory_order_relaxed ) + nSteps;
+	long long nextUpdate = counter.nextUpdate.load( std::memory_order_relaxed );
+	// Only one of the threads sharing the counter updates the host
+	if( steps < nextUpdate ||
+		!counter.nextUpdate.compare_exchange_strong( nextUpdate, steps + _updateSteps, std::memory_order_relaxed ) )
 	{
-		_mutex.unlock();
-		_effect.progressEnd();
-		return true;
+		return _aborted.load( std::memory_order_relaxed );
 	}
-	const bool res = _effect.progressUpdate( _counter );
-	_mutex.unlock();
-	return res;
+	return update();
+}
+
+bool OfxProgress::update()
+{
+	if( _updating.exchange( true, std::memory_order_acquire ) )
+	{
+		// Another thread is updating the host
+		return _aborted.load( std::memory_order_relaxed );
+	}
+	long long steps = 0;
+	for( std::size_t i = 0; i < kNbProgressCounters; ++i )
+	{
+		steps += _counters[i].steps.load( std::memory_order_relaxed );
+	}
+	bool aborted = _aborted.load( std::memory_order_relaxed );
+	if( !aborted )
+	{
+		if( _effect.abort() )
+		{
+			aborted = true;
+			_effect.progressEnd();
+		}
+		else
+		{
+			_counter = std::min( 1.0, _stepSize * static_cast<double>( steps ) );
+			aborted = _effect.progressUpdate( _counter );
+		}
+		_aborted.store( aborted, std::memory_order_relaxed );
+	}
+	_updating.store( false, std::memory_order_release );
+	return aborted;
 }
 
 bool OfxProgress::progressUpdate( const double p )
 {
 	if( _effect.abort() )
 	{
+		_aborted = true;
 		return true;
 	}
 	_counter = p;
-	return _effect.progressUpdate( _counter );
+	const bool aborted = _effect.progressUpdate( _counter );
+	_aborted = aborted;
+	return aborted;
 }
 
 /**
@@ -59,10 +109,15 @@ bool OfxProgress::progressUpdate( const double p )
  */
 void OfxProgress::progressEnd()
 {
-	// Wait for the end
-	_mutex.lock();
-	_mutex.unlock();
+	// Wait for the thread updating the host
+	bool updating = false;
+	while( !_updating.compare_exchange_weak( updating, true, std::memory_order_acquire ) )
+	{
+		updating = false;
+		std::this_thread::yield();
+	}
 	_effect.progressEnd();
+	_updating.store( false, std::memory_order_release );
 }
 
 OfxProgress& OfxProgress::operator=( const OfxProgress& p )
@@ -14,26 +14,64 @@
 #include <ofxsImageEffect.h>
 #include <ofxsMultiThread.h>
 
+#include <atomic>
+#include <cstddef>
 #include <string>
 
 namespace tuttle {
 namespace plugin {
 
+/// Number of step counters, the threads are spread over them
+static const std::size_t kNbProgressCounters = 16;
+
+/**
+ * @brief Progress of a multi threaded process.
+ *
+ * progressForward is called for each row by every thread: it only adds to
+ * a counter of the calling thread. The host is told about the progress (and
+ * asked about abort) when a thread has done about 1% of the steps since its
+ * last update, by one thread at a time. The abort answer is kept for the
+ * calls in between.
+ */
 class OfxProgress : public IProgress
 {
 private:
+	/// Steps of the threads sharing a counter, alone on its cache line
+	struct Counter
+	{
+		Counter() : steps( 0 ), nextUpdate( 0 ) {}
+		alignas( 64 ) std::atomic<long long> steps;
+		std::atomic<long long> nextUpdate; ///< Steps of the next host update
+	};
+
 	OFX::ImageEffect& _effect; ///< Used to access Ofx progress bar
-	OFX::MultiThread::Mutex _mutex;
+	Counter _counters[kNbProgressCounters];
+	long long _updateSteps; ///< Steps between two host updates of a thread
+	std::atomic<bool> _updating; ///< A thread is talking to the host
+	std::atomic<bool> _aborted; ///< Last abort answer of the host
 	OfxProgress& operator=( const OfxProgress& p );
 
+	/**
+	 * @brief counter of the calling thread
+	 */
+	Counter& threadCounter();
+
+	/**
+	 * @brief send the progress to the host and ask about abort, unless another thread does it
+	 * @return true = effect aborted
+	 */
+	bool update();
+
 protected:
 	double _stepSize; ///< Step size of progess bar
-	double _counter; ///< Current position in [0; 1]
+	double _counter; ///< Last position sent to the host in [0; 1]
 
 public:
 	OfxProgress( OFX::ImageEffect& effect )
 	: _effect( effect )
-	, _mutex( 0 )
+	, _updateSteps( 1 )
+	, _updating( false )
+	, _aborted( false )
 	, _stepSize( 0 )
 	, _counter( 0 )
 	{}
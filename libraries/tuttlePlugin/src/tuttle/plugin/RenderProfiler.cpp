@@ -0,0 +1,256 @@
+#include "RenderProfiler.hpp"
+
+#include <tuttle/plugin/global.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <thread>
+
+#if defined( __linux__ ) || defined( __APPLE__ )
+#include <dlfcn.h>
+#include <unistd.h>
+#define TUTTLE_RENDERPROFILER_POSIX
+#endif
+#if defined( __linux__ )
+#include <sys/syscall.h>
+#endif
+
+namespace tuttle {
+namespace plugin {
+
+namespace {
+
+/** @brief quote a string for json */
+std::string jsonString( const std::string& str )
+{
+	std::string res( "\"" );
+	for( std::string::const_iterator it = str.begin(); it != str.end(); ++it )
+	{
+		if( *it == '"' || *it == '\\' )
+			res += '\\';
+		if( static_cast<unsigned char>( *it ) >= 0x20 )
+			res += *it;
+	}
+	return res + "\"";
+}
+
+/** @brief quote a string for csv */
+std::string csvString( const std::string& str )
+{
+	std::string res( "\"" );
+	for( std::string::const_iterator it = str.begin(); it != str.end(); ++it )
+	{
+		if( *it == '"' )
+			res += '"';
+		res += *it;
+	}
+	return res + "\"";
+}
+
+long processId()
+{
+#if defined( TUTTLE_RENDERPROFILER_POSIX )
+	return static_cast<long>( getpid() );
+#else
+	return 1;
+#endif
+}
+
+/** @brief a complete event of the chrome trace format, times in seconds */
+void writeTraceEvent( std::ostream& os, bool& first, const std::string& name, const std::string& category,
+                      const double start, const double duration, const long tid, const std::string& args )
+{
+	os << ( first ? "\n" : ",\n" );
+	first = false;
+	os << "{\"name\":" << jsonString( name ) << ",\"cat\":\"" << category << "\",\"ph\":\"X\""
+	   << ",\"ts\":" << static_cast<long long>( start * 1e6 )
+	   << ",\"dur\":" << static_cast<long long>( duration * 1e6 )
+	   << ",\"pid\":" << processId() << ",\"tid\":" << tid
+	   << ",\"args\":{" << args << "}}";
+}
+
+}
+
+RenderProfiler& RenderProfiler::instance()
+{
+	static RenderProfiler profiler;
+	return profiler;
+}
+
+RenderProfiler::RenderProfiler()
+	: _enabled( false )
+{
+	const char* filename = std::getenv( kRenderProfileEnvVar );
+	if( filename && *filename )
+	{
+		_filename = binaryFilename( filename );
+		_enabled = true;
+	}
+}
+
+RenderProfiler::~RenderProfiler()
+{
+	if( _enabled && ! write( _filename ) )
+	{
+		TUTTLE_LOG_ERROR( "Unable to write the render profile to " << _filename );
+	}
+}
+
+double RenderProfiler::now()
+{
+	return std::chrono::duration<double>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+long RenderProfiler::currentThreadId()
+{
+#if defined( __linux__ )
+	return static_cast<long>( syscall( SYS_gettid ) );
+#else
+	return static_cast<long>( std::hash<std::thread::id>()( std::this_thread::get_id() ) & 0xffffffff );
+#endif
+}
+
+std::string RenderProfiler::binaryFilename( const std::string& filename )
+{
+	std::string binary;
+#if defined( TUTTLE_RENDERPROFILER_POSIX )
+	// The file of the plugin binary this profiler is linked in
+	Dl_info info;
+	if( dladdr( reinterpret_cast<void*>( &RenderProfiler::binaryFilename ), &info ) && info.dli_fname )
+	{
+		binary = info.dli_fname;
+		binary = binary.substr( binary.find_last_of( '/' ) + 1 );
+	}
+#endif
+	if( binary.empty() )
+	{
+		std::ostringstream address;
+		address << reinterpret_cast<const void*>( &RenderProfiler::binaryFilename );
+		binary = address.str();
+	}
+	std::ostringstream suffix;
+	suffix << "." << processId() << "." << binary;
+
+	const std::size_t slash = filename.find_last_of( "/\\" );
+	const std::size_t dot = filename.find_last_of( '.' );
+	if( dot == std::string::npos || ( slash != std::string::npos && dot < slash ) )
+		return filename + suffix.str();
+	return filename.substr( 0, dot ) + suffix.str() + filename.substr( dot );
+}
+
+double RenderProfiler::threadCpuTime()
+{
+#if defined( CLOCK_THREAD_CPUTIME_ID )
+	timespec ts;
+	if( clock_gettime( CLOCK_THREAD_CPUTIME_ID, &ts ) == 0 )
+		return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+	return 0.0;
+}
+
+void RenderProfiler::record( RenderProfile profile )
+{
+	double busy = 0.0;
+	double maxBusy = 0.0;
+	for( std::size_t i = 0; i < profile.threads.size(); ++i )
+	{
+		const ThreadProfile& thread = profile.threads[i];
+		const double threadBusy = thread.end - thread.start;
+		busy += threadBusy;
+		maxBusy = std::max( maxBusy, threadBusy );
+		profile.cpu += thread.cpu;
+	}
+	if( profile.nbThreads > 0 && profile.multiThread > 0.0 )
+		profile.utilisation = std::min( 1.0, busy / ( profile.nbThreads * profile.multiThread ) );
+	if( busy > 0.0 )
+		profile.imbalance = maxBusy * profile.nbThreads / busy;
+
+	std::lock_guard<std::mutex> lock( _mutex );
+	_profiles.push_back( profile );
+}
+
+void RenderProfiler::writeChromeTrace( std::ostream& os ) const
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+	bool first = true;
+	os << "{\"traceEvents\":[";
+	for( std::size_t i = 0; i < _profiles.size(); ++i )
+	{
+		const RenderProfile& profile = _profiles[i];
+		const long tid = profile.thread;
+		std::ostringstream args;
+		args << "\"frame\":" << profile.time
+		     << ",\"cpu\":" << profile.cpu
+		     << ",\"dstBytes\":" << profile.dstBytes
+		     << ",\"threads\":" << profile.nbThreads
+		     << ",\"utilisation\":" << profile.utilisation
+		     << ",\"imbalance\":" << profile.imbalance;
+		const double end = profile.multiThreadStart + profile.multiThread + profile.postProcess;
+		writeTraceEvent( os, first, profile.node, "render", profile.start, end - profile.start, tid, args.str() );
+		writeTraceEvent( os, first, "setup", "phase", profile.start, profile.setup, tid, "" );
+		std::ostringstream preProcessArgs;
+		preProcessArgs << "\"cpu\":" << profile.preProcessCpu;
+		writeTraceEvent( os, first, "preProcess", "phase", profile.preProcessStart, profile.preProcess, tid, preProcessArgs.str() );
+		writeTraceEvent( os, first, "multiThread", "phase", profile.multiThreadStart, profile.multiThread, tid, "" );
+		writeTraceEvent( os, first, "postProcess", "phase", profile.multiThreadStart + profile.multiThread, profile.postProcess, tid, "" );
+		for( std::size_t t = 0; t < profile.threads.size(); ++t )
+		{
+			const ThreadProfile& thread = profile.threads[t];
+			if( thread.nbTiles == 0 )
+				continue;
+			std::ostringstream threadArgs;
+			threadArgs << "\"tiles\":" << thread.nbTiles << ",\"cpu\":" << thread.cpu;
+			writeTraceEvent( os, first, profile.node, "thread", thread.start, thread.end - thread.start,
+			                 thread.thread, threadArgs.str() );
+		}
+	}
+	os << "\n]}\n";
+}
+
+void RenderProfiler::writeCsv( std::ostream& os ) const
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+	os << "node,frame,start,setup,preProcess,preProcessCpu,multiThread,postProcess,cpu,dstBytes,threads,utilisation,imbalance,tiles\n";
+	for( std::size_t i = 0; i < _profiles.size(); ++i )
+	{
+		const RenderProfile& profile = _profiles[i];
+		int nbTiles = 0;
+		for( std::size_t t = 0; t < profile.threads.size(); ++t )
+			nbTiles += profile.threads[t].nbTiles;
+		os << csvString( profile.node ) << ','
+		   << profile.time << ','
+		   << profile.start << ','
+		   << profile.setup << ','
+		   << profile.preProcess << ','
+		   << profile.preProcessCpu << ','
+		   << profile.multiThread << ','
+		   << profile.postProcess << ','
+		   << profile.cpu << ','
+		   << profile.dstBytes << ','
+		   << profile.nbThreads << ','
+		   << profile.utilisation << ','
+		   << profile.imbalance << ','
+		   << nbTiles << '\n';
+	}
+}
+
+bool RenderProfiler::write( const std::string& filename ) const
+{
+	std::ofstream file( filename.c_str() );
+	if( ! file )
+		return false;
+	const std::string csvExtension( ".csv" );
+	if( filename.size() >= csvExtension.size() &&
+	    filename.compare( filename.size() - csvExtension.size(), csvExtension.size(), csvExtension ) == 0 )
+		writeCsv( file );
+	else
+		writeChromeTrace( file );
+	return bool( file );
+}
+
+}
+}
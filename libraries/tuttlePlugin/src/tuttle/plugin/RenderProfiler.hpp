@@ -0,0 +1,117 @@
+#ifndef _TUTTLE_PLUGIN_RENDERPROFILER_HPP_
+#define _TUTTLE_PLUGIN_RENDERPROFILER_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace tuttle {
+namespace plugin {
+
+/// Environment variable enabling the profiler: file written at exit (.csv for a table, a Chrome trace otherwise),
+/// each plugin binary writes its own file, named after it
+static const char* const kRenderProfileEnvVar = "TUTTLE_PROFILE";
+
+/// Work of a thread in the multi threaded pass of a render
+struct ThreadProfile
+{
+	ThreadProfile() : thread( 0 ), start( 0 ), end( 0 ), cpu( 0 ), nbTiles( 0 ) {}
+	long thread;             ///< System id of the thread which did the work
+	double start;            ///< Start of the work, steady clock seconds
+	double end;              ///< End of the work, steady clock seconds
+	double cpu;              ///< CPU time, seconds
+	int nbTiles;             ///< Tiles processed
+};
+
+/// Timings of one render of a node
+struct RenderProfile
+{
+	RenderProfile()
+		: thread( 0 ), time( 0 ), start( 0 ), setup( 0 ), preProcessStart( 0 ), preProcess( 0 ), preProcessCpu( 0 )
+		, multiThreadStart( 0 ), multiThread( 0 ), postProcess( 0 ), cpu( 0 )
+		, dstBytes( 0 ), nbThreads( 0 ), utilisation( 0 ), imbalance( 0 )
+	{}
+	std::string node;        ///< Effect instance name
+	long thread;             ///< System id of the thread which called the render
+	double time;             ///< Rendered frame
+	double start;            ///< Start of the render, steady clock seconds
+	double setup;            ///< Wall time of setup (images fetch), seconds
+	double preProcessStart;  ///< Start of preProcess, steady clock seconds
+	double preProcess;       ///< Wall time of preProcess, seconds
+	double preProcessCpu;    ///< CPU time of preProcess, seconds (also counted in cpu)
+	double multiThreadStart; ///< Start of the multi threaded pass, steady clock seconds
+	double multiThread;      ///< Wall time of the multi threaded pass, seconds
+	double postProcess;      ///< Wall time of postProcess, seconds
+	double cpu;              ///< CPU time of all the threads, seconds
+	std::size_t dstBytes;    ///< Bytes of the destination image
+	unsigned int nbThreads;  ///< Threads of the multi threaded pass
+	double utilisation;      ///< Work of the threads / ( threads * multi threaded pass ), in [0, 1]
+	double imbalance;        ///< Busiest thread / mean thread work, 1 when balanced
+	std::vector<ThreadProfile> threads;
+};
+
+/**
+ * @brief Collects the render timings of the nodes of the process.
+ *
+ * Disabled unless TUTTLE_PROFILE is set: ImageProcessor then records
+ * each render (setup, preProcess, multi threaded pass, postProcess) and the work of
+ * each of its threads. tuttlePlugin is linked statically: each plugin
+ * binary has its own profiler, and writes its records when it is unloaded
+ * to the TUTTLE_PROFILE file name with the process id and the binary name
+ * inserted before the extension. Times are steady clock seconds, the same
+ * clock in all the binaries: their traces can be aligned.
+ */
+class RenderProfiler
+{
+public:
+	static RenderProfiler& instance();
+	~RenderProfiler();
+
+	bool enabled() const { return _enabled; }
+
+	/** @brief steady clock seconds, shared by all the binaries of the process */
+	static double now();
+
+	/** @brief system id of the calling thread */
+	static long currentThreadId();
+
+	/** @brief the file name with ".<process id>.<binary name>" inserted before its extension */
+	static std::string binaryFilename( const std::string& filename );
+
+	/** @brief CPU time of the calling thread, seconds (0 if not available) */
+	static double threadCpuTime();
+
+	/** @brief add a render, computes its utilisation and imbalance */
+	void record( RenderProfile profile );
+
+	/** @brief one complete event per phase and per thread work, viewable in chrome://tracing */
+	void writeChromeTrace( std::ostream& os ) const;
+
+	/** @brief one row per render */
+	void writeCsv( std::ostream& os ) const;
+
+	/**
+	 * @brief write the records, as csv if the file name ends with .csv
+	 * @return false if the file can't be written
+	 */
+	bool write( const std::string& filename ) const;
+
+private:
+	RenderProfiler();
+	RenderProfiler( const RenderProfiler& );
+	RenderProfiler& operator=( const RenderProfiler& );
+
+private:
+	bool _enabled;
+	std::string _filename;                                  ///< Written at exit, named after the binary
+	mutable std::mutex _mutex;                              ///< Protects the records
+	std::vector<RenderProfile> _profiles;
+};
+
+}
+}
+
+#endif
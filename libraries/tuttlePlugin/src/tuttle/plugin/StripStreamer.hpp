@@ -0,0 +1,172 @@
+#ifndef _TUTTLE_PLUGIN_STRIPSTREAMER_HPP_
+#define _TUTTLE_PLUGIN_STRIPSTREAMER_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace tuttle {
+namespace plugin {
+
+/**
+ * @brief A row filter of a strip pipeline.
+ * The output row y only depends on the input rows y - halo() to y + halo().
+ */
+class RowStage
+{
+public:
+	virtual ~RowStage() {}
+
+	/** @brief number of input rows needed above and below an output row */
+	virtual int halo() const = 0;
+
+	/**
+	 * @brief compute an output row
+	 * @param rows   2 * halo() + 1 input rows, rows[halo()] is the row y (rows out of the image are clamped to its borders)
+	 * @param dst    output row
+	 * @param width  number of pixels of the rows
+	 * @param y      row index in the image
+	 */
+	virtual void processRow( const float* const* rows, float* dst, const std::size_t width, const int y ) = 0;
+};
+
+/**
+ * @brief Runs a chain of row stages over a band of rows.
+ *
+ * Source rows are pushed thru the stages one at a time: each stage only
+ * keeps the 2 * halo + 1 last rows of its input in a ring buffer. A band of
+ * the output needs O(width * sum of the halos) memory instead of a full
+ * frame per stage. The halos of the stages add up: a band recomputes the
+ * rows of the intermediate stages around it.
+ *
+ * Rows are interleaved floats with the same number of channels for all the
+ * stages. A streamer is used by one thread.
+ */
+class StripStreamer
+{
+public:
+	StripStreamer( const std::size_t width, const std::size_t channels )
+		: _width( width )
+		, _channels( channels )
+		, _height( 0 )
+		, _input( width * channels )
+	{}
+
+	/** @brief add a stage at the end of the chain, the streamer owns it */
+	void addStage( RowStage* rowStage )
+	{
+		Stage stage;
+		stage.stage.reset( rowStage );
+		stage.halo = std::max( 0, rowStage->halo() );
+		stage.size = 2 * stage.halo + 1;
+		stage.ring.resize( stage.size * _width * _channels );
+		stage.window.resize( stage.size );
+		stage.output.resize( _width * _channels );
+		_stages.push_back( std::move( stage ) );
+	}
+
+	/** @brief sum of the halos of the stages */
+	int halo() const
+	{
+		int halo = 0;
+		for( std::size_t i = 0; i < _stages.size(); ++i )
+			halo += _stages[i].halo;
+		return halo;
+	}
+
+	/** @brief bytes of the row buffers */
+	std::size_t memorySize() const
+	{
+		std::size_t nbRows = 1;
+		for( std::size_t i = 0; i < _stages.size(); ++i )
+			nbRows += _stages[i].size + 1;
+		return nbRows * _width * _channels * sizeof( float );
+	}
+
+	/**
+	 * @brief compute the output rows [y1, y2) of an image
+	 * @param height  number of rows of the source image
+	 * @param fetch   fetch( y, float* row ): read the source row y
+	 * @param emit    emit( y, const float* row ): write the output row y, returns false to stop (abort)
+	 * @return false if emit stopped the band, true otherwise
+	 */
+	template<class Fetch, class Emit>
+	bool run( const int y1, const int y2, const int height, Fetch fetch, Emit emit )
+	{
+		_height = height;
+		// Output rows of each stage, from the last one up
+		int begin = y1;
+		int end = y2;
+		for( std::size_t i = _stages.size(); i-- > 0; )
+		{
+			Stage& stage = _stages[i];
+			stage.begin = begin;
+			stage.end = end;
+			stage.next = begin;
+			begin = std::max( 0, begin - stage.halo );
+			end = std::min( height, end + stage.halo );
+		}
+		for( int y = begin; y < end; ++y )
+		{
+			fetch( y, &_input[0] );
+			if( !push( 0, y, &_input[0], emit ) )
+				return false;
+		}
+		return true;
+	}
+
+private:
+	/**
+	 * @brief give the row y to a stage, and the rows it can then compute to the next one
+	 */
+	template<class Emit>
+	bool push( const std::size_t i, const int y, const float* row, Emit& emit )
+	{
+		if( i == _stages.size() )
+			return emit( y, row );
+
+		Stage& stage = _stages[i];
+		const std::size_t rowSize = _width * _channels;
+		std::copy( row, row + rowSize, stage.ring.begin() + ( y % stage.size ) * rowSize );
+		// Rows whose last input row is there, all the remaining ones at the bottom of the image
+		const int last = ( y == _height - 1 ) ? stage.end - 1 : std::min( stage.end - 1, y - stage.halo );
+		for( ; stage.next <= last; ++stage.next )
+		{
+			for( int d = -stage.halo; d <= stage.halo; ++d )
+			{
+				const int r = std::min( _height - 1, std::max( 0, stage.next + d ) );
+				stage.window[d + stage.halo] = &stage.ring[( r % stage.size ) * rowSize];
+			}
+			stage.stage->processRow( &stage.window[0], &stage.output[0], _width, stage.next );
+			if( !push( i + 1, stage.next, &stage.output[0], emit ) )
+				return false;
+		}
+		return true;
+	}
+
+private:
+	struct Stage
+	{
+		std::unique_ptr<RowStage> stage;
+		int halo;
+		int size;                           ///< Rows of the ring buffer
+		int begin;                          ///< First output row of the band
+		int end;                            ///< End of the output rows of the band
+		int next;                           ///< Next output row
+		std::vector<float> ring;            ///< Last input rows, row y at y % size
+		std::vector<const float*> window;   ///< Input rows of the output row
+		std::vector<float> output;          ///< Output row
+	};
+
+	std::size_t _width;
+	std::size_t _channels;
+	int _height;
+	std::vector<float> _input;              ///< Source row
+	std::vector<Stage> _stages;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,186 @@
+#include "FramePool.hpp"
+
+#include <ofxsMultiThread.h>
+
+#include <cstdlib>
+#include <new>
+
+#if defined( __linux__ ) || defined( __APPLE__ )
+#include <sys/mman.h>
+#define TUTTLE_FRAMEPOOL_MMAP
+#endif
+
+namespace tuttle {
+namespace plugin {
+
+FramePool& FramePool::instance()
+{
+	static FramePool pool;
+	return pool;
+}
+
+FramePool::FramePool()
+	: _idleSize( 0 )
+	, _capacity( kDefaultFramePoolSize )
+{
+	const char* capacityMB = std::getenv( kFramePoolSizeEnvVar );
+	if( capacityMB && *capacityMB )
+		_capacity = static_cast<std::size_t>( std::strtoul( capacityMB, NULL, 10 ) ) * 1024 * 1024;
+}
+
+FramePool::~FramePool()
+{
+	trim();
+}
+
+void* FramePool::map( const std::size_t capacity )
+{
+#if defined( TUTTLE_FRAMEPOOL_MMAP )
+	// On a numa host the pages go to the node of the thread writing them first
+	const bool prefault = OFX::MultiThread::getNumaNodes() <= 1;
+	void* data = MAP_FAILED;
+#if defined( MAP_HUGETLB )
+	// Only succeeds if huge pages were reserved (vm.nr_hugepages)
+	data = mmap( NULL, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | ( prefault ? MAP_POPULATE : 0 ), -1, 0 );
+#endif
+	if( data == MAP_FAILED )
+	{
+		data = mmap( NULL, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+		if( data == MAP_FAILED )
+			throw std::bad_alloc();
+#if defined( MADV_HUGEPAGE )
+		madvise( data, capacity, MADV_HUGEPAGE );
+#endif
+		// Fault the pages in now, not in the first render using the buffer
+		for( std::size_t i = 0; prefault && i < capacity; i += 4096 )
+			static_cast<volatile unsigned char*>( data )[i] = 0;
+	}
+	return data;
+#else
+	void* data = std::malloc( capacity );
+	if( ! data )
+		throw std::bad_alloc();
+	return data;
+#endif
+}
+
+void FramePool::unmap( void* data, const std::size_t capacity )
+{
+#if defined( TUTTLE_FRAMEPOOL_MMAP )
+	munmap( data, capacity );
+#else
+	std::free( data );
+#endif
+}
+
+void* FramePool::allocate( const std::size_t size, std::size_t& capacity )
+{
+	capacity = ( ( size + kFramePoolPageSize - 1 ) / kFramePoolPageSize ) * kFramePoolPageSize;
+	if( capacity == 0 )
+		capacity = kFramePoolPageSize;
+	{
+		std::lock_guard<std::mutex> lock( _mutex );
+		std::map<std::size_t, std::vector<void*> >::iterator it = _idleBuffers.find( capacity );
+		if( it != _idleBuffers.end() && ! it->second.empty() )
+		{
+			void* data = it->second.back();
+			it->second.pop_back();
+			_idleSize -= capacity;
+			return data;
+		}
+	}
+	return map( capacity );
+}
+
+void FramePool::deallocate( void* data, const std::size_t capacity )
+{
+	if( ! data )
+		return;
+	{
+		std::lock_guard<std::mutex> lock( _mutex );
+		if( _idleSize + capacity <= _capacity )
+		{
+			_idleBuffers[capacity].push_back( data );
+			_idleSize += capacity;
+			return;
+		}
+	}
+	unmap( data, capacity );
+}
+
+void FramePool::setCapacity( const std::size_t capacity )
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+	_capacity = capacity;
+}
+
+std::size_t FramePool::capacity() const
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+	return _capacity;
+}
+
+std::size_t FramePool::idleSize() const
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+	return _idleSize;
+}
+
+void FramePool::trim()
+{
+	std::map<std::size_t, std::vector<void*> > idleBuffers;
+	{
+		std::lock_guard<std::mutex> lock( _mutex );
+		idleBuffers.swap( _idleBuffers );
+		_idleSize = 0;
+	}
+	for( std::map<std::size_t, std::vector<void*> >::const_iterator it = idleBuffers.begin(); it != idleBuffers.end(); ++it )
+	{
+		for( std::size_t i = 0; i < it->second.size(); ++i )
+			unmap( it->second[i], it->first );
+	}
+}
+
+FrameBuffer::FrameBuffer( FrameBuffer&& other )
+	: _data( other._data )
+	, _size( other._size )
+	, _capacity( other._capacity )
+{
+	other._data = NULL;
+	other._size = other._capacity = 0;
+}
+
+FrameBuffer& FrameBuffer::operator=( FrameBuffer&& other )
+{
+	if( this != &other )
+	{
+		release();
+		_data = other._data;
+		_size = other._size;
+		_capacity = other._capacity;
+		other._data = NULL;
+		other._size = other._capacity = 0;
+	}
+	return *this;
+}
+
+void FrameBuffer::resize( const std::size_t size )
+{
+	if( size > _capacity )
+	{
+		release();
+		_data = static_cast<unsigned char*>( FramePool::instance().allocate( size, _capacity ) );
+	}
+	_size = size;
+}
+
+void FrameBuffer::release()
+{
+	if( _data )
+		FramePool::instance().deallocate( _data, _capacity );
+	_data = NULL;
+	_size = _capacity = 0;
+}
+
+}
+}
@@ -0,0 +1,111 @@
+#ifndef _TUTTLE_PLUGIN_FRAMEPOOL_HPP_
+#define _TUTTLE_PLUGIN_FRAMEPOOL_HPP_
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace tuttle {
+namespace plugin {
+
+/// Granularity of the pool size classes, the size of a huge page
+static const std::size_t kFramePoolPageSize = 2 * 1024 * 1024;
+
+/// Environment variable setting the idle bytes kept by the pool, in megabytes
+static const char* const kFramePoolSizeEnvVar = "TUTTLE_FRAME_POOL_SIZE";
+
+/// Default idle bytes kept by the pool
+static const std::size_t kDefaultFramePoolSize = 512 * 1024 * 1024;
+
+/**
+ * @brief Pool of the frame sized buffers of the plugins.
+ *
+ * Sizes are rounded up to a multiple of kFramePoolPageSize: with a stable
+ * resolution a frame always gets a buffer of the previous frames back,
+ * already mapped and faulted in, without calling the system allocator.
+ * New buffers are mapped on huge pages when the system has some reserved
+ * (MAP_HUGETLB), otherwise transparent huge pages are asked for. Buffers
+ * given back while the pool keeps more than its capacity are unmapped.
+ */
+class FramePool
+{
+public:
+	static FramePool& instance();
+	~FramePool();
+
+	/**
+	 * @brief get a buffer of at least size bytes, the content is undefined
+	 * @param[out] capacity  real size of the buffer, to give back with it
+	 * @throw std::bad_alloc if the memory can't be mapped
+	 */
+	void* allocate( const std::size_t size, std::size_t& capacity );
+
+	/** @brief give a buffer back to the pool */
+	void deallocate( void* data, const std::size_t capacity );
+
+	/** @brief idle bytes kept by the pool, the buffers given back above it are unmapped */
+	void setCapacity( const std::size_t capacity );
+	std::size_t capacity() const;
+
+	/** @brief bytes of the idle buffers */
+	std::size_t idleSize() const;
+
+	/** @brief unmap all the idle buffers */
+	void trim();
+
+private:
+	FramePool();
+	FramePool( const FramePool& );
+	FramePool& operator=( const FramePool& );
+
+	static void* map( const std::size_t capacity );
+	static void unmap( void* data, const std::size_t capacity );
+
+private:
+	mutable std::mutex _mutex;                                 ///< Protects the idle buffers
+	std::map<std::size_t, std::vector<void*> > _idleBuffers;   ///< Idle buffers by capacity
+	std::size_t _idleSize;                                     ///< Bytes of the idle buffers
+	std::size_t _capacity;                                     ///< Maximum bytes of the idle buffers
+};
+
+/**
+ * @brief Buffer of the FramePool, given back to the pool when destroyed or resized.
+ */
+class FrameBuffer
+{
+public:
+	FrameBuffer() : _data( NULL ), _size( 0 ), _capacity( 0 ) {}
+	FrameBuffer( FrameBuffer&& other );
+	~FrameBuffer() { release(); }
+
+	FrameBuffer& operator=( FrameBuffer&& other );
+
+	/**
+	 * @brief set the size of the buffer, the content is undefined after a reallocation
+	 * @throw std::bad_alloc if the memory can't be mapped
+	 */
+	void resize( const std::size_t size );
+
+	/** @brief give the memory back to the pool */
+	void release();
+
+	unsigned char* data() { return _data; }
+	const unsigned char* data() const { return _data; }
+	std::size_t size() const { return _size; }
+	bool empty() const { return _size == 0; }
+
+private:
+	FrameBuffer( const FrameBuffer& );
+	FrameBuffer& operator=( const FrameBuffer& );
+
+private:
+	unsigned char* _data;
+	std::size_t _size;
+	std::size_t _capacity;   ///< Bytes of the pool buffer
+};
+
+}
+}
+
+#endif
@@ -6,10 +6,191 @@
 #ifndef _TUTTLE_PLUGIN_COLORNEGINVERT_ALGORITHM_HPP_
 #define _TUTTLE_PLUGIN_COLORNEGINVERT_ALGORITHM_HPP_
 
+#include "ColorNegInvertPlugin.hpp"
+
+#include <tuttle/plugin/StripStreamer.hpp>
+#include <terry/colorspace/layout/all.hpp>
+
+#include <boost/gil/gil_all.hpp>
+
+#include <algorithm>
+
 namespace tuttle {
 namespace plugin {
 namespace colorNegInvert {
 
+/**
+ * @brief Remove the filter color from a channel value, clamped to [0, 1]
+ * @param subFactor  1 + 1 / filterColor
+ */
+inline float reduceChannel( const float value, const float filterColor, const float subFactor, const float factor, const bool invert )
+{
+    const float reduced = std::min( 1.0f, std::max( 0.0f, ( filterColor - value ) * subFactor ) * factor );
+    return invert ? 1.0f - reduced : reduced;
+}
+
+/**
+ * @brief Remove the filter color from n values of a channel plane
+ */
+inline void reduceChannelPlane( float* plane, const std::size_t n, const float filterColor, const float factor, const bool invert )
+{
+    const float subFactor = 1.0f + ( 1.0f / filterColor );
+    for( std::size_t i = 0; i < n; ++i )
+    {
+        plane[i] = reduceChannel( plane[i], filterColor, subFactor, factor, invert );
+    }
+}
+
+/**
+ * @brief Flat field correction of rgba rows, the gain map has the source size
+ */
+class FlatFieldStage : public RowStage
+{
+public:
+    /**
+     * @param flatField  gain map at the source size
+     * @param x1         first column of the rows in the source
+     */
+    FlatFieldStage( const terry::color::GainMap& flatField, const int x1 )
+    : _flatField( flatField )
+    , _x1( x1 )
+    {}
+
+    int halo() const { return 0; }
+
+    void processRow( const float* const* rows, float* dst, const std::size_t width, const int y )
+    {
+        const float* src = rows[0];
+        const float* gain = _flatField.row( y ) + 3 * _x1;
+        for( std::size_t x = 0; x < width; ++x, src += 4, dst += 4, gain += 3 )
+        {
+            dst[0] = src[0] * gain[0];
+            dst[1] = src[1] * gain[1];
+            dst[2] = src[2] * gain[2];
+            dst[3] = src[3];
+        }
+    }
+
+private:
+    const terry::color::GainMap& _flatField;
+    const int _x1;
+};
+
+/**
+ * @brief Remove the filter color in YUV, on rgba rows (the output is opaque)
+ */
+class YUVReductionStage : public RowStage
+{
+public:
+    YUVReductionStage( const ColorNegInvertProcessParams<float>& params )
+    : _params( params )
+    {
+        using namespace boost::gil;
+        YUVWorkPixT yuvRefFilterPix;
+        color_convert( rgb32f_pixel_t( params.fRedFilterColor, params.fGreenFilterColor, params.fBlueFilterColor ), yuvRefFilterPix );
+        _yRef = get_color( yuvRefFilterPix, terry::color::layout::yuv::y_t() );
+        _uRef = get_color( yuvRefFilterPix, terry::color::layout::yuv::u_t() );
+        _vRef = get_color( yuvRefFilterPix, terry::color::layout::yuv::v_t() );
+    }
+
+    int halo() const { return 0; }
+
+    void processRow( const float* const* rows, float* dst, const std::size_t width, const int )
+    {
+        using namespace boost::gil;
+        using namespace terry::color::layout;
+        const double redFactor = _params.fRedFactor;
+        const double greenFactor = _params.fGreenFactor;
+        const double blueFactor = _params.fBlueFactor;
+        YUVWorkPixT wpix;
+        rgb32f_pixel_t rgbPix;
+        const float* src = rows[0];
+        for( std::size_t x = 0; x < width; ++x, src += 4, dst += 4 )
+        {
+            color_convert( rgb32f_pixel_t( src[0], src[1], src[2] ), wpix );
+            const double y = get_color( wpix, yuv::y_t() );
+            const double u = get_color( wpix, yuv::u_t() );
+            const double v = get_color( wpix, yuv::v_t() );
+            get_color( wpix, yuv::y_t() ) = std::min( 1.0, std::max( 0.0, y - ( _yRef - y ) ) * redFactor );
+            get_color( wpix, yuv::u_t() ) = std::min( 0.436, std::max( -0.436, u - _uRef ) * greenFactor );
+            get_color( wpix, yuv::v_t() ) = std::min( 0.615, std::max( -0.615, v - _vRef ) * blueFactor );
+            color_convert( wpix, rgbPix );
+            dst[0] = get_color( rgbPix, red_t() );
+            dst[1] = get_color( rgbPix, green_t() );
+            dst[2] = get_color( rgbPix, blue_t() );
+            dst[3] = 1.0f;
+        }
+    }
+
+private:
+    typedef boost::gil::pixel<boost::gil::bits32f, boost::gil::layout<terry::color::layout::yuv_t> > YUVWorkPixT;
+
+    const ColorNegInvertProcessParams<float>& _params;
+    double _yRef;   ///< Luma of the filter color
+    double _uRef;   ///< U chroma of the filter color
+    double _vRef;   ///< V chroma of the filter color
+};
+
+/**
+ * @brief Remove the filter color per rgb channel, on rgba rows (the output is opaque)
+ */
+class RGBReductionStage : public RowStage
+{
+public:
+    RGBReductionStage( const ColorNegInvertProcessParams<float>& params )
+    : _params( params )
+    // Red part in params.fRedFilterColor
+    , _subRedFactor( 1.0f + ( 1.0f / params.fRedFilterColor ) )
+    // Green part in params.fGreenFilterColor
+    , _subGreenFactor( 1.0f + ( 1.0f / params.fGreenFilterColor ) )
+    // Blue part in params.fBlueFilterColor
+    , _subBlueFactor( 1.0f + ( 1.0f / params.fBlueFilterColor ) )
+    {}
+
+    int halo() const { return 0; }
+
+    void processRow( const float* const* rows, float* dst, const std::size_t width, const int )
+    {
+        const float* src = rows[0];
+        for( std::size_t x = 0; x < width; ++x, src += 4, dst += 4 )
+        {
+            dst[0] = reduceChannel( src[0], _params.fRedFilterColor, _subRedFactor, _params.fRedFactor, _params.bInvert );
+            dst[1] = reduceChannel( src[1], _params.fGreenFilterColor, _subGreenFactor, _params.fGreenFactor, _params.bInvert );
+            dst[2] = reduceChannel( src[2], _params.fBlueFilterColor, _subBlueFactor, _params.fBlueFactor, _params.bInvert );
+            dst[3] = 1.0f;
+        }
+    }
+
+private:
+    const ColorNegInvertProcessParams<float>& _params;
+    const float _subRedFactor;
+    const float _subGreenFactor;
+    const float _subBlueFactor;
+};
+
+/**
+ * @brief Grade rgba rows with a 3D lut, after either reduction
+ */
+class LutStage : public RowStage
+{
+public:
+    LutStage( const terry::color::Lut3D& lut, const terry::color::ELutInterpolation interpolation )
+    : _lut( lut )
+    , _interpolation( interpolation )
+    {}
+
+    int halo() const { return 0; }
+
+    void processRow( const float* const* rows, float* dst, const std::size_t width, const int )
+    {
+        std::copy( rows[0], rows[0] + 4 * width, dst );
+        _lut.applyRow( dst, width, 4, _interpolation );
+    }
+
+private:
+    const terry::color::Lut3D& _lut;
+    const terry::color::ELutInterpolation _interpolation;
+};
 
 }
 }
@@ -7,7 +7,6 @@
 #define _TUTTLE_PLUGIN_COLORNEGINVERTANALYZING_PROCESS_HPP_
 
 #include <tuttle/plugin/ImageGilFilterProcessor.hpp>
-#include <boost/atomic.hpp>
 
 namespace tuttle {
 namespace plugin {
@@ -27,15 +26,17 @@ public:
 protected:
     ColorNegInvertPlugin&    _plugin;            ///< Rendering plugin
     ColorNegInvertProcessParams<Scalar> _params; ///< parameters
-    boost::atomic<double> _redFilterColor;
-    boost::atomic<double> _greenFilterColor;
-    boost::atomic<double> _blueFilterColor;
+    double _redFilterColor;                      ///< Red of the brightest source pixel
+    double _greenFilterColor;                    ///< Green of the brightest source pixel
+    double _blueFilterColor;                     ///< Blue of the brightest source pixel
 
 public:
     ColorNegInvertAnalyzingProcess( ColorNegInvertPlugin& effect );
 
     void setup( const OFX::RenderArguments& args );
 
+    void preProcess();
+
     void multiThreadProcessImages( const OfxRectI& procWindowRoW );
 
     void postProcess();
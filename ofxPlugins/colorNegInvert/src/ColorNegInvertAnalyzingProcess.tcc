@@ -9,6 +9,9 @@
 #include <boost/gil/gil_all.hpp>
 #include <terry/colorspace/layout/all.hpp>
 
+#include <mutex>
+#include <string>
+
 namespace tuttle {
 namespace plugin {
 namespace colorNegInvert {
@@ -28,9 +31,52 @@ void ColorNegInvertAnalyzingProcess<View>::setup( const OFX::RenderArguments& ar
 {
     ImageGilFilterProcessor<View>::setup( args );
     _params = _plugin.getProcessParams( args.renderScale );
-    _redFilterColor = 0.0;
-    _greenFilterColor = 0.0;
-    _blueFilterColor = 0.0;
+}
+
+/**
+ * @brief Look for the brightest pixel of the whole source, whatever the render window:
+ *        the tiles of a frame all find the same filter color, so only the first
+ *        one scans the source and the others reuse its result.
+ */
+template<class View>
+void ColorNegInvertAnalyzingProcess<View>::preProcess()
+{
+    using namespace boost::gil;
+    ImageGilFilterProcessor<View>::preProcess();
+
+    const OfxTime time = this->_renderArgs.time;
+    const std::string sourceId = this->_src->getUniqueIdentifier();
+    std::lock_guard<std::mutex> lock( _plugin.getFilterColorAnalysisMutex() );
+    if( _plugin.getAnalyzedFilterColor( time, sourceId, _redFilterColor, _greenFilterColor, _blueFilterColor ) )
+    {
+        return;
+    }
+
+    using namespace terry::color::layout;
+    typedef pixel<bits32f, boost::gil::layout< terry::color::layout::yuv_t> > YUVWorkPixT;
+    YUVWorkPixT wpix;
+    rgb32f_pixel_t wfpix( 0.0f, 0.0f, 0.0f );
+
+    double yMax = 0.0;
+    for( int y = 0; y < this->_srcView.height(); ++y )
+    {
+        typename View::x_iterator src_it = this->_srcView.row_begin( y );
+        for( int x = 0; x < this->_srcView.width(); ++x, ++src_it )
+        {
+            color_convert( *src_it, wpix );
+            const double luma = get_color( wpix, y_t() );
+            if ( luma > yMax )
+            {
+                yMax = luma;
+                color_convert( *src_it, wfpix );
+            }
+        }
+    }
+
+    _redFilterColor = get_color( wfpix, red_t() );
+    _greenFilterColor = get_color( wfpix, green_t() );
+    _blueFilterColor = get_color( wfpix, blue_t() );
+    _plugin.setAnalyzedFilterColor( time, sourceId, _redFilterColor, _greenFilterColor, _blueFilterColor );
 }
 
 /**
@@ -46,48 +92,17 @@ void ColorNegInvertAnalyzingProcess<View>::multiThreadProcessImages( const OfxRe
             procWindowRoW.x2 - procWindowRoW.x1,
             procWindowRoW.y2 - procWindowRoW.y1 };
 
-    using namespace terry::color::layout;
-    typedef pixel<bits32f, boost::gil::layout< terry::color::layout::yuv_t> > YUVWorkPixT;
-    YUVWorkPixT wpix;
-    rgb32f_pixel_t wfpix;
-    typedef typename channel_type<YUVWorkPixT>::type YUVValueT;
-
-    const double vmax = channel_traits<bits32f>::max_value();
-    double yMax = 0.0;
     for( int y = procWindowOutput.y1; y < procWindowOutput.y2; ++y )
     {
         typename View::x_iterator src_it = this->_srcView.x_at( procWindowOutput.x1, y );
         typename View::x_iterator dst_it = this->_dstView.x_at( procWindowOutput.x1, y );
         for( int x = procWindowOutput.x1; x < procWindowOutput.x2; ++x, ++src_it, ++dst_it )
         {
-            color_convert( *src_it, wpix );
-            const double y = get_color( wpix, y_t() );
-            if ( y > yMax )
-            {
-                yMax = y;
-                color_convert( *src_it, wfpix );
-            }
             color_convert( *src_it, *dst_it );
         }
         if( this->progressForward( procWindowSize.x ) )
             return;
     }
-
-    const double redFilterColor = get_color( wfpix, red_t() );
-    const double greenFilterColor = get_color( wfpix, green_t() );
-    const double blueFilterColor = get_color( wfpix, blue_t() );
-    if ( redFilterColor > _redFilterColor )
-    {
-        _redFilterColor = redFilterColor;
-    }
-    if ( greenFilterColor > _greenFilterColor )
-    {
-        _greenFilterColor = greenFilterColor;
-    }
-    if ( blueFilterColor > _blueFilterColor )
-    {
-        _blueFilterColor = blueFilterColor;
-    }
 }
 
 template<class View>
@@ -7,11 +7,16 @@
 #define _TUTTLE_PLUGIN_COLORNEGINVERT_DEFINITIONS_HPP_
 
 #include <tuttle/plugin/global.hpp>
+#include <tuttle/plugin/ImageEffectGilPlugin.hpp>
 
 namespace tuttle {
 namespace plugin {
 namespace colorNegInvert {
 
+/// Image formats the processes are compiled for
+static const unsigned int kSupportedLayouts( eGilLayoutRGB | eGilLayoutRGBA );
+static const unsigned int kSupportedBitDepths( eGilBitDepthsAll );
+
 enum EParamAlgo
 {
     eParamAlgoRGBReduction,
@@ -65,6 +70,19 @@ static const std::string kParamColorInvert( "Invert colors" );
 static const std::string kParamColorInvertLabel( "Invert colors" );
 static const bool kParamDefaultColorInvertValue( false );
 
+static const std::string kParamLutFile( "LUT file" );
+static const std::string kParamLutFileLabel( "LUT file" );
+static const std::string kParamLutFileHint( "3D lut applied after the mask removal (.cube or .3dl), leave empty to disable" );
+
+static const std::string kParamFlatFieldFile( "Flat field file" );
+static const std::string kParamFlatFieldFileLabel( "Flat field file" );
+static const std::string kParamFlatFieldFileHint( "Gain map of the scanner light (captured by the kaliscope flat field calibration), applied before the mask removal, leave empty to disable" );
+
+static const std::string kParamLutInterpolation( "LUT interpolation" );
+static const std::string kParamLutInterpolationLabel( "LUT interpolation" );
+static const std::string kParamLutInterpolationTrilinear( "Trilinear" );
+static const std::string kParamLutInterpolationTetrahedral( "Tetrahedral" );
+
 }
 }
 }
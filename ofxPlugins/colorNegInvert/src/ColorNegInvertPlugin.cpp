@@ -5,9 +5,12 @@
 
 #include "ColorNegInvertPlugin.hpp"
 #include "ColorNegInvertProcess.hpp"
+#include "ColorNegInvertRGBReductionProcess.hpp"
 #include "ColorNegInvertAnalyzingProcess.hpp"
 #include "ColorNegInvertDefinitions.hpp"
 
+#include <terry/color/lutReader.hpp>
+
 #include <boost/format.hpp>
 #include <boost/gil/gil_all.hpp>
 
@@ -19,6 +22,11 @@ namespace colorNegInvert {
 ColorNegInvertPlugin::ColorNegInvertPlugin( OfxImageEffectHandle handle )
 : ImageEffectGilPlugin( handle )
 , _analyze( false )
+, _hasAnalyzedColor( false )
+, _analyzedTime( 0.0 )
+, _analyzedRed( 0.0 )
+, _analyzedGreen( 0.0 )
+, _analyzedBlue( 0.0 )
 , _redFilterColorToApply( 0.0 )
 , _greenFilterColorToApply( 0.0 )
 , _blueFilterColorToApply( 0.0 )
@@ -37,6 +45,9 @@ ColorNegInvertPlugin::ColorNegInvertPlugin( OfxImageEffectHandle handle )
     _paramColorInvert = fetchBooleanParam( kParamColorInvert );
     _paramAnalyzeButton = fetchPushButtonParam( kParamAnalyzeButton );
     _paramForceNewRender = fetchIntParam( kParamFilterForceNewRender );
+    _paramLutFile = fetchStringParam( kParamLutFile );
+    _paramLutInterpolation = fetchChoiceParam( kParamLutInterpolation );
+    _paramFlatFieldFile = fetchStringParam( kParamFlatFieldFile );
 
     _paramRedFilterColor->setRange( 0, _paramMaximumValue->getValue() );
     _paramRedFilterColor->setDisplayRange( 0, _paramMaximumValue->getValue() );
@@ -44,6 +55,44 @@ ColorNegInvertPlugin::ColorNegInvertPlugin( OfxImageEffectHandle handle )
     _paramGreenFilterColor->setDisplayRange( 0, _paramMaximumValue->getValue() );
     _paramBlueFilterColor->setRange( 0, _paramMaximumValue->getValue() );
     _paramBlueFilterColor->setDisplayRange( 0, _paramMaximumValue->getValue() );
+
+    // A missing lut is reported when the parameter changes, not at load time
+    loadLut();
+    loadFlatField();
+}
+
+bool ColorNegInvertPlugin::loadLut()
+{
+    _lut.reset();
+    const std::string filename = _paramLutFile->getValue();
+    if ( filename.empty() )
+    {
+        return true;
+    }
+    boost::shared_ptr<terry::color::Lut3D> lut( new terry::color::Lut3D() );
+    if ( !terry::color::readLut( filename, *lut ) )
+    {
+        return false;
+    }
+    _lut = lut;
+    return true;
+}
+
+bool ColorNegInvertPlugin::loadFlatField()
+{
+    _flatField.reset();
+    const std::string filename = _paramFlatFieldFile->getValue();
+    if ( filename.empty() )
+    {
+        return true;
+    }
+    boost::shared_ptr<terry::color::GainMap> flatField( new terry::color::GainMap() );
+    if ( !terry::color::readGainMap( filename, *flatField ) || flatField->channels != 3 )
+    {
+        return false;
+    }
+    _flatField = flatField;
+    return true;
 }
 
 ColorNegInvertProcessParams<ColorNegInvertPlugin::Scalar> ColorNegInvertPlugin::getProcessParams( const OfxPointD& renderScale ) const
@@ -58,6 +107,9 @@ ColorNegInvertProcessParams<ColorNegInvertPlugin::Scalar> ColorNegInvertPlugin::
     params.fGreenFactor = _paramGreenFactor->getValue() / 100.0f;
     params.fBlueFactor = _paramBlueFactor->getValue() / 100.0f;
     params.bInvert = _paramColorInvert->getValue();
+    params.lut = _lut;
+    params.flatField = _flatField;
+    params.lutInterpolation = static_cast<terry::color::ELutInterpolation>( _paramLutInterpolation->getValue() );
     return params;
 }
 
@@ -78,6 +130,11 @@ void ColorNegInvertPlugin::changedParam( const OFX::InstanceChangedArgs &args, c
     }
     else if ( paramName == kParamAnalyzeButton && _analyze == false )
     {
+        {
+            // A new analysis scans the source again
+            std::lock_guard<std::mutex> lock( _analyzedMutex );
+            _hasAnalyzedColor = false;
+        }
         _analyze = true;
         _paramForceNewRender->setValue( !_paramForceNewRender->getValue() );
         _paramAnalyzeButton->setLabels( kParamApplyParameters, kParamApplyParameters, kParamApplyParameters );
@@ -92,6 +149,22 @@ void ColorNegInvertPlugin::changedParam( const OFX::InstanceChangedArgs &args, c
         _paramBlueFilterColor->setRange( 0, _paramMaximumValue->getValue() );
         _paramBlueFilterColor->setDisplayRange( 0, _paramMaximumValue->getValue() );
     }
+    else if ( paramName == kParamLutFile )
+    {
+        if ( !loadLut() )
+        {
+            BOOST_THROW_EXCEPTION( exception::File( _paramLutFile->getValue() )
+                << exception::user() + "Unable to read the lut file (.cube and .3dl are supported)." );
+        }
+    }
+    else if ( paramName == kParamFlatFieldFile )
+    {
+        if ( !loadFlatField() )
+        {
+            BOOST_THROW_EXCEPTION( exception::File( _paramFlatFieldFile->getValue() )
+                << exception::user() + "Unable to read the flat field gain map (an rgb gain map is expected)." );
+        }
+    }
 }
 
 /**
@@ -105,11 +178,46 @@ void ColorNegInvertPlugin::notifyRGBFilterColor( const double r, const double g,
     _blueFilterColorToApply = b * vmax;
 }
 
+bool ColorNegInvertPlugin::getAnalyzedFilterColor( const OfxTime time, const std::string& sourceId, double& r, double& g, double& b ) const
+{
+    if ( !_hasAnalyzedColor || _analyzedTime != time || _analyzedSourceId != sourceId )
+    {
+        return false;
+    }
+    r = _analyzedRed;
+    g = _analyzedGreen;
+    b = _analyzedBlue;
+    return true;
+}
+
+void ColorNegInvertPlugin::setAnalyzedFilterColor( const OfxTime time, const std::string& sourceId, const double r, const double g, const double b )
+{
+    _hasAnalyzedColor = true;
+    _analyzedTime = time;
+    _analyzedSourceId = sourceId;
+    _analyzedRed = r;
+    _analyzedGreen = g;
+    _analyzedBlue = b;
+}
+
 bool ColorNegInvertPlugin::isIdentity( const OFX::RenderArguments& args, OFX::Clip*& identityClip, double& identityTime )
 {
     return false;
 }
 
+/**
+ * @brief per pixel processing, the analysis reads the whole source
+ */
+bool ColorNegInvertPlugin::getSourceHalo( OfxPointI& halo ) const
+{
+    if ( _analyze )
+    {
+        return false;
+    }
+    halo.x = halo.y = 0;
+    return true;
+}
+
 /**
  * @brief The overridden render function
  * @param[in]   args     Rendering parameters
@@ -118,11 +226,16 @@ void ColorNegInvertPlugin::render( const OFX::RenderArguments &args )
 {
     if ( _analyze )
     {
-        doGilRender<ColorNegInvertAnalyzingProcess>( *this, args );
+        doGilRenderFormats<ColorNegInvertAnalyzingProcess, kSupportedLayouts, kSupportedBitDepths>( *this, args );
+    }
+    else if ( _paramAlgo->getValue() == eParamAlgoRGBReduction && !_lut && !_flatField )
+    {
+        // Per channel only: runs on channel planes
+        doGilRenderFormats<ColorNegInvertRGBReductionProcess, kSupportedLayouts, kSupportedBitDepths>( *this, args );
     }
     else
     {
-        doGilRender<ColorNegInvertProcess>( *this, args );
+        doGilRenderFormats<ColorNegInvertProcess, kSupportedLayouts, kSupportedBitDepths>( *this, args );
     }
 }
 
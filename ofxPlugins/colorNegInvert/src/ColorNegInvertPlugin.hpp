@@ -9,6 +9,14 @@
 #include "ColorNegInvertDefinitions.hpp"
 
 #include <tuttle/plugin/ImageEffectGilPlugin.hpp>
+#include <terry/color/flatField.hpp>
+#include <terry/color/lut.hpp>
+
+#include <boost/shared_ptr.hpp>
+
+#include <atomic>
+#include <mutex>
+#include <string>
 
 namespace tuttle {
 namespace plugin {
@@ -25,6 +33,9 @@ struct ColorNegInvertProcessParams
     float fGreenFactor;
     float fBlueFactor;
     bool bInvert;
+    boost::shared_ptr<const terry::color::GainMap> flatField;  ///< Optional flat field correction (null if disabled)
+    boost::shared_ptr<const terry::color::Lut3D> lut;  ///< Optional lut applied after the reduction (null if disabled)
+    terry::color::ELutInterpolation lutInterpolation;
 };
 
 /**
@@ -44,14 +55,56 @@ public:
 
     bool isIdentity( const OFX::RenderArguments& args, OFX::Clip*& identityClip, double& identityTime );
 
+    bool getSourceHalo( OfxPointI& halo ) const;
+
     void render( const OFX::RenderArguments &args );
 
     /**
      * @brief display/update the filter color
      */    
     void notifyRGBFilterColor( const double r, const double g, const double b );
+
+    /**
+     * @brief lock held while a tile looks for the filter color of its frame:
+     *        the first tile scans the source, the others wait and reuse it
+     */
+    std::mutex& getFilterColorAnalysisMutex() { return _analyzedMutex; }
+
+    /**
+     * @brief filter color already found in the source image at this time
+     * @warning hold getFilterColorAnalysisMutex()
+     * @return false if this frame was not analyzed yet
+     */
+    bool getAnalyzedFilterColor( const OfxTime time, const std::string& sourceId, double& r, double& g, double& b ) const;
+
+    /**
+     * @brief keep the filter color found in the source image at this time
+     * @warning hold getFilterColorAnalysisMutex()
+     */
+    void setAnalyzedFilterColor( const OfxTime time, const std::string& sourceId, const double r, const double g, const double b );
+
+private:
+    /**
+     * @brief (re)load the lut file
+     * @return false if the file can't be read
+     */
+    bool loadLut();
+
+    /**
+     * @brief (re)load the flat field gain map
+     * @return false if the file can't be read
+     */
+    bool loadFlatField();
+
 private:
-    bool _analyze;              ///< Analyze color of the mask (set this on an image supposed to be white)
+    std::atomic<bool> _analyze; ///< Analyze color of the mask (set this on an image supposed to be white), read by the render threads
+    std::mutex _analyzedMutex;  ///< Serialises the analysis of the tiles of a frame
+    bool _hasAnalyzedColor;     ///< The last analyzed frame is known
+    OfxTime _analyzedTime;      ///< Time of the last analyzed frame
+    std::string _analyzedSourceId;  ///< Source image of the last analyzed frame
+    double _analyzedRed;
+    double _analyzedGreen;
+    double _analyzedBlue;
     double _redFilterColorToApply;
     double _greenFilterColorToApply;
     double _blueFilterColorToApply;
@@ -68,6 +121,11 @@ private:
     OFX::DoubleParam*	_paramGreenFactor;
     OFX::DoubleParam*	_paramBlueFactor;
     OFX::BooleanParam*	_paramColorInvert;
+    OFX::StringParam*	_paramLutFile;
+    OFX::ChoiceParam*	_paramLutInterpolation;
+    OFX::StringParam*	_paramFlatFieldFile;
+    boost::shared_ptr<const terry::color::Lut3D> _lut;  ///< Loaded lut
+    boost::shared_ptr<const terry::color::GainMap> _flatField;  ///< Loaded flat field gain map
 };
 
 }
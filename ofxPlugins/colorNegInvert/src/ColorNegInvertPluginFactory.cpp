@@ -14,7 +14,7 @@ namespace tuttle {
 namespace plugin {
 namespace colorNegInvert {
 
-static const bool kSupportTiles = false;
+static const bool kSupportTiles = true;
 
 
 /**
@@ -36,9 +36,7 @@ void ColorNegInvertPluginFactory::describe( OFX::ImageEffectDescriptor& desc )
     desc.addSupportedContext( OFX::eContextGeneral );
 
     // add supported pixel depths
-    desc.addSupportedBitDepth( OFX::eBitDepthUByte );
-    desc.addSupportedBitDepth( OFX::eBitDepthUShort );
-    desc.addSupportedBitDepth( OFX::eBitDepthFloat );
+    describeGilBitDepths( desc, kSupportedBitDepths );
 
     // plugin flags
     desc.setSupportsTiles( kSupportTiles );
@@ -54,14 +52,12 @@ void ColorNegInvertPluginFactory::describeInContext( OFX::ImageEffectDescriptor&
                                                   OFX::EContext context )
 {
     OFX::ClipDescriptor* srcClip = desc.defineClip( kOfxImageEffectSimpleSourceClipName );
-    srcClip->addSupportedComponent( OFX::ePixelComponentRGB );
-    srcClip->addSupportedComponent( OFX::ePixelComponentRGBA );
+    describeGilLayouts( *srcClip, kSupportedLayouts );
     srcClip->setSupportsTiles( kSupportTiles );
 
     // Create the mandated output clip
     OFX::ClipDescriptor* dstClip = desc.defineClip( kOfxImageEffectOutputClipName );
-    dstClip->addSupportedComponent( OFX::ePixelComponentRGB );
-    dstClip->addSupportedComponent( OFX::ePixelComponentRGBA );
+    describeGilLayouts( *dstClip, kSupportedLayouts );
     dstClip->setSupportsTiles( kSupportTiles );
 
     OFX::ChoiceParamDescriptor* paramAlgo = desc.defineChoiceParam( kParamAlgorithm );
@@ -135,6 +131,29 @@ void ColorNegInvertPluginFactory::describeInContext( OFX::ImageEffectDescriptor&
     colorInvert->setParent( *groupFilterColorsParams );
     colorInvert->setDefault( kParamDefaultColorInvertValue );
 
+    OFX::StringParamDescriptor *flatFieldFile = desc.defineStringParam( kParamFlatFieldFile );
+    flatFieldFile->setLabels( kParamFlatFieldFileLabel, kParamFlatFieldFileLabel, kParamFlatFieldFileLabel );
+    flatFieldFile->setStringType( OFX::eStringTypeFilePath );
+    flatFieldFile->setCacheInvalidation( OFX::eCacheInvalidateValueAll );
+    flatFieldFile->setHint( kParamFlatFieldFileHint );
+
+    OFX::GroupParamDescriptor *groupLutParams = desc.defineGroupParam( "LUT" );
+
+    OFX::StringParamDescriptor *lutFile = desc.defineStringParam( kParamLutFile );
+    lutFile->setLabels( kParamLutFileLabel, kParamLutFileLabel, kParamLutFileLabel );
+    lutFile->setParent( *groupLutParams );
+    lutFile->setStringType( OFX::eStringTypeFilePath );
+    lutFile->setCacheInvalidation( OFX::eCacheInvalidateValueAll );
+    lutFile->setHint( kParamLutFileHint );
+
+    OFX::ChoiceParamDescriptor *lutInterpolation = desc.defineChoiceParam( kParamLutInterpolation );
+    lutInterpolation->setLabels( kParamLutInterpolationLabel, kParamLutInterpolationLabel, kParamLutInterpolationLabel );
+    lutInterpolation->setParent( *groupLutParams );
+    lutInterpolation->appendOption( kParamLutInterpolationTrilinear );
+    lutInterpolation->appendOption( kParamLutInterpolationTetrahedral );
+    lutInterpolation->setDefault( terry::color::eLutInterpolationTetrahedral );
+    lutInterpolation->setHint( "Tetrahedral is more accurate on neutral axis, trilinear is slightly cheaper" );
+
     OFX::PushButtonParamDescriptor* help = desc.definePushButtonParam( kParamHelpButton );
     help->setLabel( kParamHelpLabel );
 
@@ -6,7 +6,10 @@
 #ifndef _TUTTLE_PLUGIN_COLORNEGINVERT_PROCESS_HPP_
 #define _TUTTLE_PLUGIN_COLORNEGINVERT_PROCESS_HPP_
 
-#include <tuttle/plugin/ImageGilFilterProcessor.hpp>
+#include <tuttle/plugin/ImageGilStripProcessor.hpp>
+#include <terry/color/flatField.hpp>
+
+#include <boost/shared_ptr.hpp>
 
 namespace tuttle {
 namespace plugin {
@@ -15,9 +18,11 @@ namespace colorNegInvert {
 /**
  * @brief ColorNegInvert process
  *
+ * The flat field correction and the inversion are row stages streamed
+ * over each band (see ColorNegInvertAlgorithm.hpp).
  */
 template<class View>
-class ColorNegInvertProcess : public ImageGilFilterProcessor<View>
+class ColorNegInvertProcess : public ImageGilStripProcessor<View>
 {
 public:
 	typedef typename View::value_type Pixel;
@@ -26,13 +31,15 @@ public:
 protected:
     ColorNegInvertPlugin&    _plugin;            ///< Rendering plugin
     ColorNegInvertProcessParams<Scalar> _params; ///< parameters
+    boost::shared_ptr<const terry::color::GainMap> _flatField; ///< Flat field gain map at the source size (null if disabled)
 
 public:
     ColorNegInvertProcess( ColorNegInvertPlugin& effect );
 
 	void setup( const OFX::RenderArguments& args );
 
-    void multiThreadProcessImages( const OfxRectI& procWindowRoW );
+protected:
+    void addStages( StripStreamer& streamer, const OfxRectI& procWindowOutput );
 };
 
 }
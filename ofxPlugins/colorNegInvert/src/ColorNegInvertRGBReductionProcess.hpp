@@ -0,0 +1,45 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#ifndef _TUTTLE_PLUGIN_COLORNEGINVERTRGBREDUCTION_PROCESS_HPP_
+#define _TUTTLE_PLUGIN_COLORNEGINVERTRGBREDUCTION_PROCESS_HPP_
+
+#include <tuttle/plugin/ImageGilPlanarProcessor.hpp>
+
+namespace tuttle {
+namespace plugin {
+namespace colorNegInvert {
+
+/**
+ * @brief ColorNegInvert RGB reduction process, without flat field nor lut
+ *
+ * The reduction is per channel: it runs on channel planes, which vectorize
+ * without any shuffle in the kernel.
+ */
+template<class View>
+class ColorNegInvertRGBReductionProcess : public ImageGilPlanarProcessor<View>
+{
+public:
+    typedef float Scalar;
+protected:
+    ColorNegInvertPlugin&    _plugin;            ///< Rendering plugin
+    ColorNegInvertProcessParams<Scalar> _params; ///< parameters
+
+public:
+    ColorNegInvertRGBReductionProcess( ColorNegInvertPlugin& effect );
+
+    void setup( const OFX::RenderArguments& args );
+
+protected:
+    void processPlanes( float* const* planes, const std::size_t width, const int y );
+};
+
+}
+}
+}
+
+#include "ColorNegInvertRGBReductionProcess.tcc"
+
+#endif
@@ -0,0 +1,43 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#include "ColorNegInvertAlgorithm.hpp"
+#include "ColorNegInvertPlugin.hpp"
+
+#include <algorithm>
+
+namespace tuttle {
+namespace plugin {
+namespace colorNegInvert {
+
+template<class View>
+ColorNegInvertRGBReductionProcess<View>::ColorNegInvertRGBReductionProcess( ColorNegInvertPlugin &effect )
+: ImageGilPlanarProcessor<View>( effect, eImageOrientationIndependant )
+, _plugin( effect )
+{
+}
+
+template<class View>
+void ColorNegInvertRGBReductionProcess<View>::setup( const OFX::RenderArguments& args )
+{
+    ImageGilPlanarProcessor<View>::setup( args );
+    _params = _plugin.getProcessParams( args.renderScale );
+}
+
+/**
+ * @brief Reduce the red, green and blue planes of a row, the output is opaque.
+ */
+template<class View>
+void ColorNegInvertRGBReductionProcess<View>::processPlanes( float* const* planes, const std::size_t width, const int )
+{
+    reduceChannelPlane( planes[0], width, _params.fRedFilterColor, _params.fRedFactor, _params.bInvert );
+    reduceChannelPlane( planes[1], width, _params.fGreenFilterColor, _params.fGreenFactor, _params.bInvert );
+    reduceChannelPlane( planes[2], width, _params.fBlueFilterColor, _params.fBlueFactor, _params.bInvert );
+    std::fill( planes[3], planes[3] + width, 1.0f );
+}
+
+}
+}
+}
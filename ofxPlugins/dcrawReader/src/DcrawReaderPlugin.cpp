@@ -67,27 +67,8 @@ void DcrawReaderPlugin::render( const OFX::RenderArguments& args )
 {
     ReaderPlugin::render( args );
 
-    // instantiate the render code based on the pixel depth of the dst clip
-    OFX::EBitDepth bitDepth         = _clipDst->getPixelDepth();
-    OFX::EPixelComponent components = _clipDst->getPixelComponents();
-
-    switch( components )
-    {
-        case OFX::ePixelComponentRGB:
-        {
-            doGilRender<DcrawReaderProcess, false, terry::rgb_layout_t>( *this, args, bitDepth );
-            return;
-        }
-        case OFX::ePixelComponentRGBA:
-        case OFX::ePixelComponentAlpha:
-        case OFX::ePixelComponentCustom:
-        case OFX::ePixelComponentNone:
-        {
-            BOOST_THROW_EXCEPTION( exception::Unsupported()
-                    << exception::user() + "Pixel components (" + mapPixelComponentEnumToString(components) + ") not supported by the plugin." );
-        }
-    }
-    BOOST_THROW_EXCEPTION( exception::Unknown() );
+    // instantiate the render code for the formats of the dst clip declared by the factory
+    doGilRenderFormats<DcrawReaderProcess, kSupportedLayouts, kSupportedBitDepths>( *this, args );
 }
 
 
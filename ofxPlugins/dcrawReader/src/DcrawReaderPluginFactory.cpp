@@ -36,7 +36,7 @@ void DcrawReaderPluginFactory::describe( OFX::ImageEffectDescriptor& desc )
 	desc.addSupportedContext( OFX::eContextGeneral );
 
 	// add supported pixel depths
-	desc.addSupportedBitDepth( OFX::eBitDepthFloat );
+	describeGilBitDepths( desc, kSupportedBitDepths );
 
 	// plugin flags
 	desc.setRenderThreadSafety( OFX::eRenderInstanceSafe );
@@ -57,7 +57,7 @@ void DcrawReaderPluginFactory::describeInContext( OFX::ImageEffectDescriptor& de
 {
     // Create the mandated output clip
     OFX::ClipDescriptor* dstClip = desc.defineClip( kOfxImageEffectOutputClipName );
-    dstClip->addSupportedComponent( OFX::ePixelComponentRGB );
+    describeGilLayouts( *dstClip, kSupportedLayouts );
     dstClip->setSupportsTiles( kSupportTiles );
 
     OFX::ChoiceParamDescriptor* paramInterpolationQuality = desc.defineChoiceParam( kParamInterpolationQuality );
@@ -67,6 +67,7 @@ void DcrawReaderPluginFactory::describeInContext( OFX::ImageEffectDescriptor& de
     paramInterpolationQuality->appendOption( kParamInterpolationQualityVNG );
     paramInterpolationQuality->appendOption( kParamInterpolationQualityPPG );
     paramInterpolationQuality->appendOption( kParamAlgorithmYUVReductionAHD );
+    paramInterpolationQuality->appendOption( kParamInterpolationQualityDraft );
     paramInterpolationQuality->setDefault( 3 );
 
     describeReaderParamsInContext( desc, context );
@@ -32,7 +32,9 @@
 #define _USE_MATH_DEFINES
 
 #include "dcraw.hpp"
+#include <terry/color/demosaic.hpp>
 #include <iostream>
+#include <vector>
 #include <ctype.h>
 #include <errno.h>
 #include <fcntl.h>
@@ -9037,12 +9039,53 @@ void CLASS write_ppm_tiff()
   free (ppm);
 }
 
+/*
+   Draft interpolation: the mosaic left by pre_interpolate() is demosaiced
+   by the terry bilinear kernel (vectorized, row based).
+   Returns 0 if the sensor is not a plain 2x2 bayer one.
+ */
+int CLASS draft_interpolate()
+{
+  terry::color::BayerPattern pattern;
+  int row, col, c, nred=0;
+
+  if (filters <= 1000 || colors != 3 || width < 2 || height < 2) return 0;
+  for (row=0; row < 8; row++)
+    for (col=0; col < 2; col++)
+      if (FC(row,col) != FC(row & 1,col)) return 0;
+  for (row=0; row < 2; row++)
+    for (col=0; col < 2; col++)
+      if (FC(row,col) == 0) {
+        pattern.redX = col;
+        pattern.redY = row;
+        nred++;
+      }
+  if (nred != 1 || FC(pattern.redY ^ 1, pattern.redX ^ 1) != 2) return 0;
+  if (verbose) fprintf (stderr,_("Draft bilinear interpolation...\n"));
+
+  std::vector<ushort> mosaic (width * height);
+  for (row=0; row < height; row++)
+    for (col=0; col < width; col++)
+      mosaic[row*width+col] = image[row*width+col][FC(row,col)];
+
+  terry::color::BayerDemosaic demosaic (pattern, terry::color::eDemosaicBilinear, 1.0f);
+  std::vector<float> rgb (3 * width);
+  for (row=0; row < height; row++) {
+    std::ptrdiff_t above, below;
+    terry::color::bayerNeighbourRows (row, height, above, below);
+    demosaic (&mosaic[above*width], &mosaic[row*width], &mosaic[below*width], &rgb[0], width, row);
+    for (col=0; col < width; col++)
+      FORC3 image[row*width+col][c] = CLIP(rgb[3*col+c] + 0.5f);
+  }
+  return 1;
+}
+
 namespace dcraw
 {
 
 /**
  * @brief read raw data
- * @param interpolationQuality user interpolation quality [0-3]
+ * @param interpolationQuality user interpolation quality [0-4]
  */
 boost::shared_array<ushort> getRawData( const int interpolationQuality )
 {
@@ -9108,7 +9151,10 @@ boost::shared_array<ushort> getRawData( const int interpolationQuality )
     scale_colors();
     pre_interpolate();
     if (filters && !document_mode) {
-      if (quality == 0)
+      if (quality == kDraftQuality) {
+	if (!draft_interpolate()) lin_interpolate();
+      }
+      else if (quality == 0)
 	lin_interpolate();
       else if (quality == 1 || colors > 3)
 	vng_interpolate();
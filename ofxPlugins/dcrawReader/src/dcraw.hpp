@@ -15,9 +15,12 @@
 
 namespace dcraw
 {
+    /// Interpolation quality of the draft mode: bayer sensors are demosaiced with terry
+    static const int kDraftQuality = 4;
+
     /**
      * @brief read raw data
-     * @param user_quality user interpolation quality [0-3]
+     * @param user_quality user interpolation quality [0-4] (see kDraftQuality)
      */
     boost::shared_array<ushort> getRawData( const int interpolationQuality = 3 );
 
@@ -61,7 +64,7 @@ namespace dcraw
      * @brief read raw image
      * @param filename the input filename
      * @param dst the destination view
-     * @param interpolationQuality quality of the interpolation in [0-3]
+     * @param interpolationQuality quality of the interpolation in [0-4]
      * @return true or false, true if success
      */
     template<class DView>
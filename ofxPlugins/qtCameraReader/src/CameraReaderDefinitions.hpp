@@ -13,6 +13,26 @@ namespace tuttle {
 namespace plugin {
 namespace cameraReader {
 
+enum EParamFrameSelection
+{
+    eParamFrameSelectionLatest = 0,
+    eParamFrameSelectionMatchingTime = 1
+};
+
+enum EParamBayerPattern
+{
+    eParamBayerPatternRGGB = 0,
+    eParamBayerPatternGRBG = 1,
+    eParamBayerPatternGBRG = 2,
+    eParamBayerPatternBGGR = 3
+};
+
+enum EParamTransfer
+{
+    eParamTransferCamera = 0,
+    eParamTransferLinear = 1
+};
+
 static const std::string kParamCameraChoice( "Camera" );
 static const std::string kParamResolutionChoice( "Capture resolution" );
 static const std::string kParamFocusMode( "Focus mode" );
@@ -26,6 +46,30 @@ static const std::string kParamAutoShutterSpeed( "Automatic shutter speed" );
 static const std::string kParamAutoAperture( "Automatic aperture" );
 static const std::string kParamOpticalZoomFactor( "Optical zoom factor" );
 static const std::string kParamWhiteBalance( "White balance (in Kelvin)" );
+static const std::string kParamFrameSelection( "Frame selection" );
+static const std::string kParamFrameSelectionLatest( "Most recent" );
+static const std::string kParamFrameSelectionMatchingTime( "Matching time" );
+static const std::string kParamCaptureBuffers( "Capture buffers" );
+static const int kParamDefaultCaptureBuffers( 3 );
+static const std::string kParamRawCapture( "Raw capture" );
+static const std::string kParamBayerPattern( "Bayer pattern" );
+static const std::string kParamBayerPatternRGGB( "RGGB" );
+static const std::string kParamBayerPatternGRBG( "GRBG" );
+static const std::string kParamBayerPatternGBRG( "GBRG" );
+static const std::string kParamBayerPatternBGGR( "BGGR" );
+static const std::string kParamRawBitDepth( "Raw bit depth" );
+static const int kParamDefaultRawBitDepth( 12 );
+static const std::string kParamDemosaic( "Demosaic" );
+static const std::string kParamDemosaicBilinear( "Bilinear" );
+static const std::string kParamDemosaicEdgeAware( "Edge aware" );
+static const std::string kParamBracketing( "Exposure bracketing" );
+static const std::string kParamBracketCount( "Bracketed exposures" );
+static const int kParamDefaultBracketCount( 3 );
+static const std::string kParamBracketStep( "Bracketing step (EV)" );
+static const double kParamDefaultBracketStep( 2.0 );
+static const std::string kParamTransfer( "Output transfer" );
+static const std::string kParamTransferCamera( "Camera (sRGB)" );
+static const std::string kParamTransferLinear( "Linear" );
 
 }
 }
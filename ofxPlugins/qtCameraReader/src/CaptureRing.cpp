@@ -0,0 +1,112 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#include "CaptureRing.hpp"
+
+namespace tuttle {
+namespace plugin {
+namespace cameraReader {
+
+CaptureRing::CaptureRing( const std::size_t nbBuffers )
+: _nextSequence( 0 )
+, _lastRead( 0 )
+{
+    _frames.reserve( nbBuffers );
+    for( std::size_t i = 0; i < nbBuffers; ++i )
+    {
+        _frames.push_back( FramePtr( new CapturedFrame() ) );
+    }
+}
+
+CaptureRing::FramePtr CaptureRing::acquireWriteBuffer()
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    FramePtr oldest;
+    for( const FramePtr & frame: _frames )
+    {
+        // A buffer only referenced by the ring is free. The latest frame is
+        // kept as long as there is another choice, unpublished buffers first.
+        if ( frame != _latest && frame.use_count() == 1 &&
+             ( !oldest || ( oldest->sequence != kNoSequence &&
+                            ( frame->sequence == kNoSequence || frame->sequence < oldest->sequence ) ) ) )
+        {
+            oldest = frame;
+        }
+    }
+    if ( !oldest && _latest && _latest.use_count() == 2 )
+    {
+        oldest = _latest;
+        _latest.reset();
+    }
+    if ( oldest )
+    {
+        // Filled out of the lock: at() mustn't return it meanwhile
+        oldest->sequence = kNoSequence;
+    }
+    return oldest;
+}
+
+void CaptureRing::publish( const FramePtr & frame )
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    frame->sequence = _nextSequence++;
+    frame->timestamp = std::chrono::steady_clock::now();
+    _latest = frame;
+}
+
+CaptureRing::FramePtr CaptureRing::latest()
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    if ( !_latest || _latest->sequence + 1 <= _lastRead )
+    {
+        return FramePtr();
+    }
+    _lastRead = _latest->sequence + 1;
+    return _latest;
+}
+
+CaptureRing::FramePtr CaptureRing::at( const std::size_t sequence )
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    if ( !_latest || sequence > _latest->sequence )
+    {
+        return FramePtr();
+    }
+    for( const FramePtr & frame: _frames )
+    {
+        if ( frame->sequence == sequence )
+        {
+            return frame;
+        }
+    }
+    return FramePtr();
+}
+
+bool CaptureRing::isPublished( const std::size_t sequence )
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    return sequence < _nextSequence;
+}
+
+void CaptureRing::clear()
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    _latest.reset();
+    _nextSequence = 0;
+    _lastRead = 0;
+    for( const FramePtr & frame: _frames )
+    {
+        // Numbering restarts: the held frames mustn't match the new numbers
+        frame->sequence = kNoSequence;
+        if ( frame.use_count() == 1 )
+        {
+            frame->data.clear();
+        }
+    }
+}
+
+}
+}
+}
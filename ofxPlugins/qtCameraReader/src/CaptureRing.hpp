@@ -0,0 +1,118 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#ifndef _TUTTLE_PLUGIN_CAMERAREADER_CAPTURERING_HPP_
+#define _TUTTLE_PLUGIN_CAMERAREADER_CAPTURERING_HPP_
+
+#include <boost/shared_ptr.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+namespace tuttle {
+namespace plugin {
+namespace cameraReader {
+
+/// Sequence of a buffer holding no published frame (never filled, being filled or cleared)
+static const std::size_t kNoSequence = std::numeric_limits<std::size_t>::max();
+
+/**
+ * @brief A frame captured by the camera, kept in the capture ring
+ */
+struct CapturedFrame
+{
+    CapturedFrame()
+    : width( 0 )
+    , height( 0 )
+    , rowBytes( 0 )
+    , sequence( kNoSequence )
+    , raw( false )
+    {}
+
+    std::vector<unsigned char> data;    ///< Raw pixels, as delivered by the camera
+    int width;                          ///< Frame width in pixels
+    int height;                         ///< Frame height in pixels
+    std::ptrdiff_t rowBytes;            ///< Size of a row in bytes
+    std::size_t sequence;               ///< Capture number since the ring was (re)started, kNoSequence if not published
+    bool raw;                           ///< Bayer mosaic instead of packed rgb
+    std::vector<float> exposureTimes;   ///< Shutter time of each bracketed exposure in seconds, empty for a single capture
+    std::chrono::steady_clock::time_point timestamp; ///< When the frame was received
+
+    /// Bracketed exposures are stored one after the other in data
+    inline std::size_t nbExposures() const
+    { return exposureTimes.empty() ? 1 : exposureTimes.size(); }
+
+    inline const unsigned char* exposure( const std::size_t index ) const
+    { return &data[index * rowBytes * height]; }
+};
+
+/**
+ * @brief Fixed size ring of pre-captured frames.
+ * The camera thread fills the buffers continuously while render dequeues the
+ * most recent one (or the one matching the requested time). A buffer held by
+ * a reader is never overwritten, buffers are recycled without reallocation.
+ */
+class CaptureRing
+{
+public:
+    typedef boost::shared_ptr<CapturedFrame> FramePtr;
+
+public:
+    explicit CaptureRing( const std::size_t nbBuffers );
+
+    /**
+     * @brief get the buffer the producer should fill next (the oldest one not held by a reader)
+     * Its frame is unpublished: readers can't get it until it is published again.
+     * @return null if all buffers are in use
+     */
+    FramePtr acquireWriteBuffer();
+
+    /**
+     * @brief make a filled buffer available to readers
+     */
+    void publish( const FramePtr & frame );
+
+    /**
+     * @brief get the most recent frame newer than the last one returned
+     * @return null if no new frame was captured since the last call
+     */
+    FramePtr latest();
+
+    /**
+     * @brief get the frame with the given capture number
+     * @return null if this frame is not captured yet, or if it has already been recycled
+     */
+    FramePtr at( const std::size_t sequence );
+
+    /**
+     * @brief has the frame with the given capture number been published (it may be recycled since)
+     */
+    bool isPublished( const std::size_t sequence );
+
+    /**
+     * @brief forget all captured frames and restart numbering
+     * The frames still held by readers are left untouched.
+     */
+    void clear();
+
+    inline std::size_t nbBuffers() const
+    { return _frames.size(); }
+
+private:
+    std::mutex _mutex;
+    std::vector<FramePtr> _frames;      ///< Ring buffers
+    FramePtr _latest;                   ///< Last published frame
+    std::size_t _nextSequence;          ///< Number of the next published frame
+    std::size_t _lastRead;              ///< Sequence + 1 of the last frame returned by latest()
+};
+
+}
+}
+}
+
+#endif
@@ -3,13 +3,47 @@
  * https://github.com/edubois/kaliscope/blob/master/LICENSE
  */
 
-#ifndef _TUTTLE_PLUGIN_CAMERAREADER_ALGORITHM_HPP_
-#define _TUTTLE_PLUGIN_CAMERAREADER_ALGORITHM_HPP_
+#ifndef _TUTTLE_PLUGIN_QTCAMERAREADER_ALGORITHM_HPP_
+#define _TUTTLE_PLUGIN_QTCAMERAREADER_ALGORITHM_HPP_
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
 
 namespace tuttle {
 namespace plugin {
 namespace cameraReader {
 
+/**
+ * @brief sRGB decoding table of the 8 bits camera frames
+ * (bracketed exposures are merged in linear light)
+ */
+inline const float* srgbToLinearTable()
+{
+    static const std::vector<float> table = []()
+    {
+        std::vector<float> t( 256 );
+        for( int i = 0; i < 256; ++i )
+        {
+            const double v = i / 255.0;
+            t[i] = static_cast<float>( v <= 0.04045 ? v / 12.92 : std::pow( ( v + 0.055 ) / 1.055, 2.4 ) );
+        }
+        return t;
+    }();
+    return &table[0];
+}
+
+/**
+ * @brief sRGB encoding of linear values, extended above 1 for the merged exposures
+ */
+inline void linearToSrgb( float* data, const std::size_t n )
+{
+    for( std::size_t i = 0; i < n; ++i )
+    {
+        const float v = data[i];
+        data[i] = v <= 0.0031308f ? v * 12.92f : 1.055f * std::pow( v, 1.0f / 2.4f ) - 0.055f;
+    }
+}
 
 }
 }
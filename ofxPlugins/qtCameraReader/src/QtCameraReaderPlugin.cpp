@@ -6,6 +6,11 @@
 #include "QtCameraReaderPlugin.hpp"
 #include "QtCameraReaderProcess.hpp"
 
+#include <QtMultimedia/QVideoFrame>
+
+#include <algorithm>
+#include <cmath>
+
 namespace tuttle {
 namespace plugin {
 namespace cameraReader {
@@ -15,21 +20,48 @@ QtCameraReaderPlugin::QtCameraReaderPlugin( OfxImageEffectHandle handle )
 , _exposureControl( NULL )
 , _focusControl( NULL )
 , _imageControl( NULL )
+, _capturing( false )
+, _bracketing( false )
+, _bracketIndex( 0 )
+, _renderedTime( 0.0 )
 {
+    _paramFrameSelection = fetchChoiceParam( kParamFrameSelection );
+    _paramCaptureBuffers = fetchIntParam( kParamCaptureBuffers );
+    _paramRawCapture = fetchBooleanParam( kParamRawCapture );
+    _paramBayerPattern = fetchChoiceParam( kParamBayerPattern );
+    _paramRawBitDepth = fetchIntParam( kParamRawBitDepth );
+    _paramDemosaic = fetchChoiceParam( kParamDemosaic );
+    _paramBracketing = fetchBooleanParam( kParamBracketing );
+    _paramBracketCount = fetchIntParam( kParamBracketCount );
+    _paramBracketStep = fetchDoubleParam( kParamBracketStep );
+    _paramTransfer = fetchChoiceParam( kParamTransfer );
+    _ring.reset( new CaptureRing( _paramCaptureBuffers->getValue() ) );
     fillParameters();
 }
 
 QtCameraReaderPlugin::~QtCameraReaderPlugin()
-{}
+{
+    stopCapture();
+}
 
 void QtCameraReaderPlugin::createNewCamera( const QCameraInfo & cameraInfo )
 {
+    stopCapture();
+    // Release the capture before the camera it is attached to
+    _imageCapture.reset();
     _camera.reset( new QCamera( cameraInfo ) );
     _camera->setCaptureMode( QCamera::CaptureStillImage );
     _camInfo.reset( new QCameraInfo( _camera.get() ) );
     _imageCapture.reset( new QCameraImageCapture( _camera.get() ) );
     _imageCapture->setCaptureDestination( QCameraImageCapture::CaptureToBuffer );
-    _imageCapture->setBufferFormat( QVideoFrame::Format_RGB24 );
+    updateBufferFormat();
+    // The capture object is the connection context, so the connections die with it
+    QObject::connect( _imageCapture.get(), &QCameraImageCapture::imageAvailable, _imageCapture.get(),
+                      [this]( const int, const QVideoFrame & buffer ) { onImageAvailable( buffer ); } );
+    QObject::connect( _imageCapture.get(), &QCameraImageCapture::readyForCaptureChanged, _imageCapture.get(),
+                      [this]( const bool ready ) { if ( ready ) { triggerCapture(); } } );
+    QObject::connect( _imageCapture.get(), static_cast<void(QCameraImageCapture::*)(int, QCameraImageCapture::Error, const QString &)>( &QCameraImageCapture::error ),
+                      _imageCapture.get(), [this]( int, QCameraImageCapture::Error, const QString & ) { triggerCapture(); } );
     _exposureControl = _camera->exposure();
     _focusControl = _camera->focus();
     _imageControl = _camera->imageProcessing();
@@ -39,6 +71,207 @@ void QtCameraReaderPlugin::createNewCamera( const QCameraInfo & cameraInfo )
     }
 }
 
+void QtCameraReaderPlugin::updateBufferFormat()
+{
+    if ( !_imageCapture )
+    {
+        return;
+    }
+    if ( _paramRawCapture->getValue() )
+    {
+        // Raw frames keep the full sensor bit depth and skip the driver processing
+        if ( _imageCapture->supportedBufferFormats().contains( QVideoFrame::Format_CameraRaw ) )
+        {
+            _imageCapture->setBufferFormat( QVideoFrame::Format_CameraRaw );
+            return;
+        }
+        TUTTLE_LOG_WARNING( "[QtCameraReader] Raw capture is not supported by this camera, using RGB frames." );
+    }
+    _imageCapture->setBufferFormat( QVideoFrame::Format_RGB24 );
+}
+
+void QtCameraReaderPlugin::startCapture()
+{
+    if ( _capturing || !_camera )
+    {
+        return;
+    }
+    _ring->clear();
+    _bracketing = _paramBracketing->getValue() && _exposureControl;
+    _capturing = true;
+    _camera->start();
+    if ( _bracketing )
+    {
+        prepareBracket();
+    }
+    triggerCapture();
+}
+
+void QtCameraReaderPlugin::stopCapture()
+{
+    _capturing = false;
+    {
+        // Times restart with the next capture session
+        std::unique_lock<std::mutex> lock( _renderedMutex );
+        _renderedFrame.reset();
+    }
+    if ( _imageCapture )
+    {
+        _imageCapture->cancelCapture();
+    }
+    if ( _bracketing )
+    {
+        _bracketing = false;
+        _bracketFrame.reset();
+        restoreExposure();
+    }
+}
+
+CaptureRing::FramePtr QtCameraReaderPlugin::renderedFrame( const OfxTime time )
+{
+    std::unique_lock<std::mutex> lock( _renderedMutex );
+    if ( !_renderedFrame || _renderedTime != time )
+    {
+        return CaptureRing::FramePtr();
+    }
+    return _renderedFrame;
+}
+
+void QtCameraReaderPlugin::setRenderedFrame( const OfxTime time, const CaptureRing::FramePtr & frame )
+{
+    std::unique_lock<std::mutex> lock( _renderedMutex );
+    _renderedTime = time;
+    _renderedFrame = frame;
+}
+
+void QtCameraReaderPlugin::triggerCapture()
+{
+    if ( _capturing && _imageCapture && _imageCapture->isReadyForCapture() )
+    {
+        if ( _bracketing )
+        {
+            _exposureControl->setManualShutterSpeed( _bracketSpeeds[_bracketIndex] );
+        }
+        _imageCapture->capture();
+    }
+}
+
+void QtCameraReaderPlugin::prepareBracket()
+{
+    const int count = _paramBracketCount->getValue();
+    const double step = _paramBracketStep->getValue();
+    // The bracket is centered on the current (possibly automatic) shutter speed
+    qreal base = _exposureControl->shutterSpeed();
+    if ( base <= 0.0 )
+    {
+        base = 1.0 / 60.0;
+    }
+    bool continuous = false;
+    const QList<qreal> supported = _exposureControl->supportedShutterSpeeds( &continuous );
+
+    _bracketSpeeds.clear();
+    for( int i = 0; i < count; ++i )
+    {
+        const double ev = ( i - ( count - 1 ) * 0.5 ) * step;
+        qreal speed = base * std::pow( 2.0, ev );
+        if ( !continuous && !supported.isEmpty() )
+        {
+            // Nearest supported speed, in stops
+            qreal nearest = supported.front();
+            Q_FOREACH( const qreal s, supported )
+            {
+                if ( s > 0.0 && std::abs( std::log2( s / speed ) ) < std::abs( std::log2( nearest / speed ) ) )
+                {
+                    nearest = s;
+                }
+            }
+            speed = nearest;
+        }
+        _bracketSpeeds.push_back( speed );
+    }
+    _bracketIndex = 0;
+    _bracketFrame.reset();
+    _exposureControl->setExposureMode( QCameraExposure::ExposureManual );
+}
+
+void QtCameraReaderPlugin::storeBracketExposure( const QVideoFrame & frame )
+{
+    const std::size_t planeBytes = frame.bytesPerLine() * frame.height();
+    if ( _bracketIndex == 0 )
+    {
+        // If every buffer is being read, the whole bracket is dropped
+        _bracketFrame = _ring->acquireWriteBuffer();
+        if ( !_bracketFrame )
+        {
+            return;
+        }
+        _bracketFrame->width = frame.width();
+        _bracketFrame->height = frame.height();
+        _bracketFrame->rowBytes = frame.bytesPerLine();
+        _bracketFrame->raw = frame.pixelFormat() == QVideoFrame::Format_CameraRaw;
+        _bracketFrame->exposureTimes.clear();
+        _bracketFrame->data.resize( planeBytes * _bracketSpeeds.size() );
+    }
+    else if ( !_bracketFrame || _bracketFrame->width != frame.width() || _bracketFrame->height != frame.height() ||
+              _bracketFrame->rowBytes != frame.bytesPerLine() )
+    {
+        // The format changed during the bracket, start a new one
+        _bracketFrame.reset();
+        _bracketIndex = 0;
+        return;
+    }
+
+    std::copy( frame.bits(), frame.bits() + std::min<std::size_t>( planeBytes, frame.mappedBytes() ),
+               _bracketFrame->data.begin() + _bracketIndex * planeBytes );
+    // The camera may adjust the requested speed, keep the one really used
+    const qreal shutterSpeed = _exposureControl->shutterSpeed();
+    _bracketFrame->exposureTimes.push_back( shutterSpeed > 0.0 ? shutterSpeed : _bracketSpeeds[_bracketIndex] );
+
+    if ( ++_bracketIndex == _bracketSpeeds.size() )
+    {
+        _ring->publish( _bracketFrame );
+        _bracketFrame.reset();
+        _bracketIndex = 0;
+    }
+}
+
+void QtCameraReaderPlugin::restoreExposure()
+{
+    OFX::InstanceChangedArgs dummyArg;
+    changedParam( dummyArg, kParamAutoExposure );
+    changedParam( dummyArg, kParamShutterSpeedChoice );
+    changedParam( dummyArg, kParamAutoShutterSpeed );
+}
+
+void QtCameraReaderPlugin::onImageAvailable( const QVideoFrame & buffer )
+{
+    QVideoFrame frame( buffer );
+    if ( frame.map( QAbstractVideoBuffer::ReadOnly ) )
+    {
+        if ( _bracketing )
+        {
+            storeBracketExposure( frame );
+        }
+        else
+        {
+            // If every buffer is being read, the frame is dropped
+            CaptureRing::FramePtr slot = _ring->acquireWriteBuffer();
+            if ( slot )
+            {
+                slot->width = frame.width();
+                slot->height = frame.height();
+                slot->rowBytes = frame.bytesPerLine();
+                slot->raw = frame.pixelFormat() == QVideoFrame::Format_CameraRaw;
+                slot->exposureTimes.clear();
+                slot->data.assign( frame.bits(), frame.bits() + frame.mappedBytes() );
+                _ring->publish( slot );
+            }
+        }
+        frame.unmap();
+    }
+    triggerCapture();
+}
+
 void QtCameraReaderPlugin::fillParameters()
 {
     OFX::InstanceChangedArgs dummyArg;
@@ -75,6 +308,13 @@ QtCameraReaderProcessParams QtCameraReaderPlugin::getProcessParams( const OfxTim
     QtCameraReaderProcessParams params;
     params.camera = _camera;
     params.capture = _imageCapture;
+    params.ring = _ring;
+    params.frameSelection = static_cast<EParamFrameSelection>( _paramFrameSelection->getValue() );
+    const int pattern = _paramBayerPattern->getValue();
+    params.bayerPattern = terry::color::BayerPattern( pattern & 1, pattern >> 1 );
+    params.rawBitDepth = _paramRawBitDepth->getValue();
+    params.demosaic = static_cast<terry::color::EDemosaicMethod>( _paramDemosaic->getValue() );
+    params.transfer = static_cast<EParamTransfer>( _paramTransfer->getValue() );
     return params;
 }
 
@@ -92,6 +332,37 @@ void QtCameraReaderPlugin::changedParam( const OFX::InstanceChangedArgs& args, c
             createNewCamera( QCameraInfo::defaultCamera() );
         }
     }
+    else if ( paramName == kParamCaptureBuffers )
+    {
+        const bool capturing = _capturing;
+        stopCapture();
+        _ring.reset( new CaptureRing( _paramCaptureBuffers->getValue() ) );
+        if ( capturing )
+        {
+            startCapture();
+        }
+    }
+    else if ( paramName == kParamRawCapture )
+    {
+        // Frames already in the ring have the previous format
+        const bool capturing = _capturing;
+        stopCapture();
+        updateBufferFormat();
+        if ( capturing )
+        {
+            startCapture();
+        }
+    }
+    else if ( paramName == kParamBracketing || paramName == kParamBracketCount || paramName == kParamBracketStep )
+    {
+        // The bracket is computed when the capture starts
+        const bool capturing = _capturing;
+        stopCapture();
+        if ( capturing )
+        {
+            startCapture();
+        }
+    }
     else if ( paramName == kParamFocusMode )
     {
         switch( static_cast<EParamFocusMode>( _paramFocusMode->getValue() ) )
@@ -9,6 +9,7 @@
 #include "CameraReaderPlugin.hpp"
 #include "CameraReaderDefinitions.hpp"
 #include "QtCameraReaderDefinitions.hpp"
+#include "CaptureRing.hpp"
 
 #include <QtMultimedia/QCameraExposure>
 #include <QtMultimedia/QCameraFocus>
@@ -16,8 +17,14 @@
 #include <QtMultimedia/QCameraImageCapture>
 #include <QtMultimedia/QCameraInfo>
 
+#include <terry/color/demosaic.hpp>
+
 #include <boost/shared_ptr.hpp>
 
+#include <atomic>
+#include <mutex>
+#include <vector>
+
 namespace tuttle {
 namespace plugin {
 namespace cameraReader {
@@ -26,6 +33,12 @@ struct QtCameraReaderProcessParams
 {
     boost::shared_ptr<QCamera> camera;
     boost::shared_ptr<QCameraImageCapture> capture;
+    boost::shared_ptr<CaptureRing> ring;        ///< Pre-captured frames
+    EParamFrameSelection frameSelection;        ///< Which frame render picks in the ring
+    terry::color::BayerPattern bayerPattern;    ///< Sensor layout of the raw frames
+    int rawBitDepth;                            ///< Significant bits of the raw samples
+    terry::color::EDemosaicMethod demosaic;     ///< Demosaic of the raw frames
+    EParamTransfer transfer;                    ///< Transfer of the output frames
 };
 
 /**
@@ -43,9 +56,45 @@ public:
     virtual void render( const OFX::RenderArguments& args );
     QtCameraReaderProcessParams getProcessParams( const OfxTime time ) const;
 
+    /**
+     * @brief start the camera and capture continuously into the ring
+     */
+    void startCapture();
+
+    /**
+     * @brief stop the continuous capture
+     */
+    void stopCapture();
+
+    /**
+     * @brief get the frame already rendered at this time
+     * A live camera has a new frame on each call, a render of the same time
+     * (the host computing the graph again after the reader) must give the
+     * frame that was exposed for it.
+     * @return null if another time was rendered since
+     */
+    CaptureRing::FramePtr renderedFrame( const OfxTime time );
+
+    /**
+     * @brief keep the frame rendered at this time, until another time is rendered
+     */
+    void setRenderedFrame( const OfxTime time, const CaptureRing::FramePtr & frame );
+
 private:
     void createNewCamera( const QCameraInfo & cameraInfo );
     void fillParameters();
+    /// Ask the camera for raw bayer frames if requested and supported, packed rgb otherwise
+    void updateBufferFormat();
+    /// Copy the captured frame into the ring and ask for the next one
+    void onImageAvailable( const QVideoFrame & buffer );
+    /// Ask for the next frame if the camera is ready
+    void triggerCapture();
+    /// Compute the shutter speeds of a bracket around the current one
+    void prepareBracket();
+    /// Copy one exposure of the bracket, publish the frame when the bracket is complete
+    void storeBracketExposure( const QVideoFrame & frame );
+    /// Give the exposure settings back to the user parameters
+    void restoreExposure();
 
 private:
     boost::shared_ptr<QCamera> _camera;                   ///< Camera control
@@ -54,6 +103,25 @@ private:
     QCameraExposure * _exposureControl; ///< Exposure control
     QCameraFocus * _focusControl;       ///< Focus control
     QCameraImageProcessing * _imageControl;       ///< Image control
+    OFX::ChoiceParam* _paramFrameSelection;       ///< Which frame render picks in the ring
+    OFX::IntParam* _paramCaptureBuffers;          ///< Number of frames in the ring
+    OFX::BooleanParam* _paramRawCapture;          ///< Capture the sensor mosaic
+    OFX::ChoiceParam* _paramBayerPattern;         ///< Sensor layout of the raw frames
+    OFX::IntParam* _paramRawBitDepth;             ///< Significant bits of the raw samples
+    OFX::ChoiceParam* _paramDemosaic;             ///< Demosaic of the raw frames
+    OFX::BooleanParam* _paramBracketing;          ///< Capture bracketed exposures
+    OFX::IntParam* _paramBracketCount;            ///< Number of exposures per frame
+    OFX::DoubleParam* _paramBracketStep;          ///< Exposure step between two exposures
+    OFX::ChoiceParam* _paramTransfer;             ///< Transfer of the output frames
+    boost::shared_ptr<CaptureRing> _ring;         ///< Pre-captured frames
+    std::atomic<bool> _capturing;                 ///< Continuous capture is running
+    bool _bracketing;                             ///< Bracketing during this capture session
+    std::vector<qreal> _bracketSpeeds;            ///< Shutter speeds of the bracket
+    std::size_t _bracketIndex;                    ///< Next exposure of the bracket
+    CaptureRing::FramePtr _bracketFrame;          ///< Frame being filled by the bracket
+    std::mutex _renderedMutex;                    ///< Protects the rendered frame from concurrent renders
+    OfxTime _renderedTime;                        ///< Time of the rendered frame
+    CaptureRing::FramePtr _renderedFrame;         ///< Last rendered frame, held out of the ring
 };
 
 }
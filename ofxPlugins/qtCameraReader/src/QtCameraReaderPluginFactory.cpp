@@ -201,6 +201,74 @@ void QtCameraReaderPluginFactory::describeInContext( OFX::ImageEffectDescriptor&
     paramWhiteBalance->setDefault( 0 );    // Automatic
     paramWhiteBalance->setRange( 0, 12000 );
     paramWhiteBalance->setDisplayRange( 0, 12000 );
+
+    OFX::ChoiceParamDescriptor* paramFrameSelection = desc.defineChoiceParam( kParamFrameSelection );
+    paramFrameSelection->setLabel( kParamFrameSelection );
+    paramFrameSelection->appendOption( kParamFrameSelectionLatest );
+    paramFrameSelection->appendOption( kParamFrameSelectionMatchingTime );
+    paramFrameSelection->setDefault( eParamFrameSelectionLatest );
+    paramFrameSelection->setHint( "The camera captures continuously, render takes either the most recent frame or the frame whose capture number matches the requested time" );
+
+    OFX::IntParamDescriptor *paramCaptureBuffers = desc.defineIntParam( kParamCaptureBuffers );
+    paramCaptureBuffers->setLabels( kParamCaptureBuffers, kParamCaptureBuffers, kParamCaptureBuffers );
+    paramCaptureBuffers->setDefault( kParamDefaultCaptureBuffers );
+    paramCaptureBuffers->setRange( 2, 16 );
+    paramCaptureBuffers->setDisplayRange( 2, 16 );
+    paramCaptureBuffers->setHint( "Number of pre-captured frames kept while the graph is processing" );
+
+    OFX::BooleanParamDescriptor *paramRawCapture = desc.defineBooleanParam( kParamRawCapture );
+    paramRawCapture->setLabels( kParamRawCapture, kParamRawCapture, kParamRawCapture );
+    paramRawCapture->setDefault( false );
+    paramRawCapture->setHint( "Capture the sensor bayer mosaic (if the camera supports it) and demosaic it in the plugin, at the full sensor bit depth" );
+
+    OFX::ChoiceParamDescriptor* paramBayerPattern = desc.defineChoiceParam( kParamBayerPattern );
+    paramBayerPattern->setLabel( kParamBayerPattern );
+    paramBayerPattern->appendOption( kParamBayerPatternRGGB );
+    paramBayerPattern->appendOption( kParamBayerPatternGRBG );
+    paramBayerPattern->appendOption( kParamBayerPatternGBRG );
+    paramBayerPattern->appendOption( kParamBayerPatternBGGR );
+    paramBayerPattern->setDefault( eParamBayerPatternRGGB );
+    paramBayerPattern->setHint( "Color filter layout of the sensor (raw capture only)" );
+
+    OFX::IntParamDescriptor *paramRawBitDepth = desc.defineIntParam( kParamRawBitDepth );
+    paramRawBitDepth->setLabels( kParamRawBitDepth, kParamRawBitDepth, kParamRawBitDepth );
+    paramRawBitDepth->setDefault( kParamDefaultRawBitDepth );
+    paramRawBitDepth->setRange( 8, 16 );
+    paramRawBitDepth->setDisplayRange( 8, 16 );
+    paramRawBitDepth->setHint( "Significant bits of the raw samples (raw capture only)" );
+
+    OFX::ChoiceParamDescriptor* paramDemosaic = desc.defineChoiceParam( kParamDemosaic );
+    paramDemosaic->setLabel( kParamDemosaic );
+    paramDemosaic->appendOption( kParamDemosaicBilinear );
+    paramDemosaic->appendOption( kParamDemosaicEdgeAware );
+    paramDemosaic->setDefault( terry::color::eDemosaicEdgeAware );
+    paramDemosaic->setHint( "Interpolation of the raw frames (raw capture only)" );
+
+    OFX::BooleanParamDescriptor *paramBracketing = desc.defineBooleanParam( kParamBracketing );
+    paramBracketing->setLabels( kParamBracketing, kParamBracketing, kParamBracketing );
+    paramBracketing->setDefault( false );
+    paramBracketing->setHint( "Capture several exposures per frame by stepping the shutter speed, and merge them into one HDR frame" );
+
+    OFX::IntParamDescriptor *paramBracketCount = desc.defineIntParam( kParamBracketCount );
+    paramBracketCount->setLabels( kParamBracketCount, kParamBracketCount, kParamBracketCount );
+    paramBracketCount->setDefault( kParamDefaultBracketCount );
+    paramBracketCount->setRange( 2, 9 );
+    paramBracketCount->setDisplayRange( 2, 9 );
+    paramBracketCount->setHint( "Number of exposures per frame (bracketing only)" );
+
+    OFX::DoubleParamDescriptor *paramBracketStep = desc.defineDoubleParam( kParamBracketStep );
+    paramBracketStep->setLabels( kParamBracketStep, kParamBracketStep, kParamBracketStep );
+    paramBracketStep->setDefault( kParamDefaultBracketStep );
+    paramBracketStep->setRange( 0.3, 4.0 );
+    paramBracketStep->setDisplayRange( 0.3, 4.0 );
+    paramBracketStep->setHint( "Exposure difference between two exposures, in stops, around the current shutter speed (bracketing only)" );
+
+    OFX::ChoiceParamDescriptor* paramTransfer = desc.defineChoiceParam( kParamTransfer );
+    paramTransfer->setLabel( kParamTransfer );
+    paramTransfer->appendOption( kParamTransferCamera );
+    paramTransfer->appendOption( kParamTransferLinear );
+    paramTransfer->setDefault( eParamTransferCamera );
+    paramTransfer->setHint( "Camera: sRGB encoded like the frames of the camera (raw and merged frames are encoded back). Linear: linear light (use a float output for bracketing)" );
 }
 
 /**
@@ -26,6 +26,7 @@ public:
 protected:
     QtCameraReaderPlugin&    _plugin;            ///< Rendering plugin
     QtCameraReaderProcessParams _params;         ///< parameters
+    CaptureRing::FramePtr _frame;                ///< Frame being converted
 
 public:
     QtCameraReaderProcess( QtCameraReaderPlugin& effect );
@@ -35,8 +36,24 @@ public:
     void multiThreadProcessImages( const OfxRectI& procWindowRoW );
 
 private:
-    // Read camera frame
-    View& readFrame( View& dst );
+    /**
+     * @brief Convert a band of the frame into the output view, demosaicing and
+     *        merging the exposures row by row in linear light, then applying the
+     *        output transfer
+     */
+    void convertFrame( const int x1, const int y1, const int width, const int height );
+
+    /**
+     * @brief Get row y of one exposure of the frame as linear float rgb
+     */
+    void readRow( const unsigned char* data, const int y, const bool wide, terry::color::BayerDemosaic & demosaic, float* dst ) const;
+
+    /**
+     * @brief Get the frame to render from the capture ring, waiting for the
+     *        camera only if it has not been captured yet. The frame already
+     *        rendered at this time is given again.
+     */
+    CaptureRing::FramePtr readFrame( const OfxTime time );
 };
 
 }
@@ -3,9 +3,17 @@
  * https://github.com/edubois/kaliscope/blob/master/LICENSE
  */
 
+#include "QtCameraReaderAlgorithm.hpp"
 #include "QtCameraReaderPlugin.hpp"
 
+#include <terry/merge/ExposureMerge.hpp>
+
 #include <QtCore/QEventLoop>
+#include <QtCore/QTimer>
+
+#include <algorithm>
+#include <string>
+#include <vector>
 
 namespace tuttle {
 namespace plugin {
@@ -18,7 +26,6 @@ QtCameraReaderProcess<View>::QtCameraReaderProcess( QtCameraReaderPlugin &instan
 : ImageGilProcessor<View>( instance, eImageOrientationFromTopToBottom )
 , _plugin( instance )
 {
-    this->setNoMultiThreading();
 }
 
 template<class View>
@@ -27,6 +34,7 @@ void QtCameraReaderProcess<View>::setup( const OFX::RenderArguments& args )
     using namespace boost::gil;
     ImageGilProcessor<View>::setup( args );
     _params = _plugin.getProcessParams( args.time );
+    _frame = readFrame( args.time );
 }
 
 /**
@@ -37,34 +45,155 @@ template<class View>
 void QtCameraReaderProcess<View>::multiThreadProcessImages( const OfxRectI& procWindowRoW )
 {
     using namespace boost::gil;
-    readFrame( this->_dstView );
+    const OfxRectI procWindowOutput = this->translateRoWToOutputClipCoordinates( procWindowRoW );
+    const int width = std::min( procWindowOutput.x2, _frame->width ) - procWindowOutput.x1;
+    const int height = std::min( procWindowOutput.y2, _frame->height ) - procWindowOutput.y1;
+    if ( width <= 0 || height <= 0 )
+    {
+        return;
+    }
+    if ( _frame->raw || _frame->nbExposures() > 1 || _params.transfer == eParamTransferLinear )
+    {
+        convertFrame( procWindowOutput.x1, procWindowOutput.y1, width, height );
+        return;
+    }
+    // Format_RGB24 kept camera encoded: 8 bits per channel, packed
+    rgb8c_view_t src = interleaved_view( _frame->width, _frame->height, reinterpret_cast<const rgb8_pixel_t*>( &_frame->data[0] ), _frame->rowBytes );
+    copy_and_convert_pixels( subimage_view( src, procWindowOutput.x1, procWindowOutput.y1, width, height ),
+                             subimage_view( this->_dstView, procWindowOutput.x1, procWindowOutput.y1, width, height ) );
 }
 
 template<class View>
-View& QtCameraReaderProcess<View>::readFrame( View& dst )
+void QtCameraReaderProcess<View>::convertFrame( const int x1, const int y1, const int width, const int height )
 {
-    using namespace boost;
-    using namespace mpl;
     using namespace boost::gil;
+    if ( _frame->raw && ( _frame->height < 2 || _frame->width < 2 ) )
+    {
+        return;
+    }
+    // Raw samples above 8 bits are stored on 16 bits
+    const bool wide = _frame->raw && _frame->rowBytes >= 2 * _frame->width;
+    const int bits = wide ? _params.rawBitDepth : 8;
+    terry::color::BayerDemosaic demosaic( _params.bayerPattern, _params.demosaic, 1.0f / ( ( 1 << bits ) - 1 ) );
+    const std::size_t nbExposures = _frame->nbExposures();
+    terry::ExposureMerge merge;
+    std::vector<float> row( 3 * _frame->width );
+    rgb32fc_view_t rowView = interleaved_view( _frame->width, 1, reinterpret_cast<const rgb32f_pixel_t*>( &row[0] ), 3 * _frame->width * sizeof( float ) );
 
-    if ( _params.capture )
+    for( int y = y1; y < y1 + height; ++y )
     {
-        QEventLoop waitLoop;
-        waitLoop.connect( _params.capture.get(), &QCameraImageCapture::imageAvailable,
-                      [&dst,&waitLoop]( const int id, const QVideoFrame & buffer )
-                      {
-                          rgb32c_view_t src = interleaved_view( buffer.width(), buffer.height(), reinterpret_cast<const rgb32_pixel_t*>( buffer.bits() ), buffer.bytesPerLine() );
-                          copy_and_convert_pixels( src, dst );
-                          waitLoop.quit();
-                      }
-                );
+        if ( nbExposures == 1 )
+        {
+            readRow( _frame->exposure( 0 ), y, wide, demosaic, &row[0] );
+        }
+        else
+        {
+            merge.reset( row.size() );
+            for( std::size_t e = 0; e < nbExposures; ++e )
+            {
+                readRow( _frame->exposure( e ), y, wide, demosaic, &row[0] );
+                merge.addExposure( &row[0], _frame->exposureTimes[e] );
+            }
+            merge.result( &row[0] );
+        }
+        if ( _params.transfer == eParamTransferCamera )
+        {
+            // Encoded back like the frames of the camera
+            linearToSrgb( &row[3 * x1], 3 * width );
+        }
+        copy_and_convert_pixels( subimage_view( rowView, x1, 0, width, 1 ),
+                                 subimage_view( this->_dstView, x1, y, width, 1 ) );
+        if( this->progressForward( width ) )
+            return;
+    }
+}
 
+template<class View>
+void QtCameraReaderProcess<View>::readRow( const unsigned char* data, const int y, const bool wide, terry::color::BayerDemosaic & demosaic, float* dst ) const
+{
+    const unsigned char* src = data + y * _frame->rowBytes;
+    if ( !_frame->raw )
+    {
+        // Format_RGB24, decoded to linear light
+        const float* toLinear = srgbToLinearTable();
+        for( int i = 0; i < 3 * _frame->width; ++i )
+        {
+            dst[i] = toLinear[src[i]];
+        }
+        return;
+    }
+
+    std::ptrdiff_t above, below;
+    terry::color::bayerNeighbourRows( y, _frame->height, above, below );
+    const unsigned char* srcAbove = data + above * _frame->rowBytes;
+    const unsigned char* srcBelow = data + below * _frame->rowBytes;
+    if ( wide )
+    {
+        demosaic( reinterpret_cast<const boost::uint16_t*>( srcAbove ),
+                  reinterpret_cast<const boost::uint16_t*>( src ),
+                  reinterpret_cast<const boost::uint16_t*>( srcBelow ),
+                  dst, _frame->width, y );
+    }
+    else
+    {
+        demosaic( srcAbove, src, srcBelow, dst, _frame->width, y );
+    }
+}
+
+template<class View>
+CaptureRing::FramePtr QtCameraReaderProcess<View>::readFrame( const OfxTime time )
+{
+    if ( !_params.capture || !_params.ring )
+    {
+        BOOST_THROW_EXCEPTION( exception::Failed()
+            << exception::user() + "No camera available." );
+    }
+
+    CaptureRing & ring = *_params.ring;
+    const std::size_t sequence = static_cast<std::size_t>( std::max( 0.0, time ) );
+    auto selectFrame = [&]()
+    {
+        return ( _params.frameSelection == eParamFrameSelectionMatchingTime ) ? ring.at( sequence ) : ring.latest();
+    };
+
+    _plugin.startCapture();
+    // Rendered again for the same time: the exposed frame, not a newer one
+    CaptureRing::FramePtr frame = _plugin.renderedFrame( time );
+    if ( frame )
+    {
+        return frame;
+    }
+    frame = selectFrame();
+    if ( !frame && _params.frameSelection == eParamFrameSelectionMatchingTime && ring.isPublished( sequence ) )
+    {
+        BOOST_THROW_EXCEPTION( exception::Failed()
+            << exception::user() + "The frame " + std::to_string( sequence ) + " has been recycled, increase the number of capture buffers." );
+    }
+    if ( !frame )
+    {
+        // Nothing in the ring yet: let the camera signals be delivered until a
+        // suitable frame is published (or we give up).
+        QEventLoop waitLoop;
+        QTimer timeout;
+        timeout.setSingleShot( true );
+        waitLoop.connect( &timeout, SIGNAL( timeout() ), &waitLoop, SLOT( quit() ) );
+        waitLoop.connect( _params.capture.get(), SIGNAL( imageAvailable( int, const QVideoFrame & ) ), &waitLoop, SLOT( quit() ) );
         waitLoop.connect( _params.capture.get(), SIGNAL( error( int, QCameraImageCapture::Error, const QString & ) ), &waitLoop, SLOT( quit() ) );
+        timeout.start( kCaptureTimeout );
+        while( !frame && timeout.isActive() )
+        {
+            waitLoop.exec();
+            frame = selectFrame();
+        }
+    }
 
-        _params.capture->capture();
-        waitLoop.exec();
+    if ( !frame || frame->data.empty() )
+    {
+        BOOST_THROW_EXCEPTION( exception::Failed()
+            << exception::user() + "Camera capture timeout." );
     }
-    return dst;
+    _plugin.setRenderedFrame( time, frame );
+    return frame;
 }
 
 }
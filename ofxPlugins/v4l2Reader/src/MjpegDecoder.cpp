@@ -0,0 +1,91 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#include "MjpegDecoder.hpp"
+
+#ifndef NO_JPEG
+#include <cstdio>
+#include <csetjmp>
+#include <jpeglib.h>
+#endif
+
+namespace tuttle {
+namespace plugin {
+namespace v4l2Reader {
+
+#ifndef NO_JPEG
+
+namespace {
+
+struct JpegErrorManager
+{
+    jpeg_error_mgr pub;
+    std::jmp_buf setjmpBuffer;
+};
+
+void jpegErrorExit( j_common_ptr cinfo )
+{
+    JpegErrorManager* err = reinterpret_cast<JpegErrorManager*>( cinfo->err );
+    std::longjmp( err->setjmpBuffer, 1 );
+}
+
+void jpegOutputMessage( j_common_ptr )
+{
+    // Corrupted frames are frequent on usb cameras, don't flood the console
+}
+
+}
+
+bool decodeMjpeg( const unsigned char* data, const std::size_t size, FrameBuffer & rgb, unsigned int & width, unsigned int & height )
+{
+    jpeg_decompress_struct cinfo;
+    JpegErrorManager jerr;
+    cinfo.err = jpeg_std_error( &jerr.pub );
+    jerr.pub.error_exit = jpegErrorExit;
+    jerr.pub.output_message = jpegOutputMessage;
+    if ( setjmp( jerr.setjmpBuffer ) )
+    {
+        jpeg_destroy_decompress( &cinfo );
+        return false;
+    }
+
+    jpeg_create_decompress( &cinfo );
+    // UVC cameras often omit the huffman tables, libjpeg(-turbo) then uses the standard ones
+    jpeg_mem_src( &cinfo, const_cast<unsigned char*>( data ), size );
+    if ( jpeg_read_header( &cinfo, TRUE ) != JPEG_HEADER_OK )
+    {
+        jpeg_destroy_decompress( &cinfo );
+        return false;
+    }
+    cinfo.out_color_space = JCS_RGB;
+    cinfo.dct_method = JDCT_IFAST;
+    jpeg_start_decompress( &cinfo );
+
+    width = cinfo.output_width;
+    height = cinfo.output_height;
+    const std::size_t rowBytes = 3 * width;
+    rgb.resize( rowBytes * height );
+    while( cinfo.output_scanline < cinfo.output_height )
+    {
+        JSAMPROW row = rgb.data() + cinfo.output_scanline * rowBytes;
+        jpeg_read_scanlines( &cinfo, &row, 1 );
+    }
+    jpeg_finish_decompress( &cinfo );
+    jpeg_destroy_decompress( &cinfo );
+    return true;
+}
+
+#else
+
+bool decodeMjpeg( const unsigned char*, const std::size_t, FrameBuffer &, unsigned int &, unsigned int & )
+{
+    return false;
+}
+
+#endif
+
+}
+}
+}
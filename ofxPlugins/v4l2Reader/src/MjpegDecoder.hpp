@@ -0,0 +1,28 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#ifndef _TUTTLE_PLUGIN_V4L2READER_MJPEGDECODER_HPP_
+#define _TUTTLE_PLUGIN_V4L2READER_MJPEGDECODER_HPP_
+
+#include <tuttle/plugin/memory/FramePool.hpp>
+
+#include <cstddef>
+
+namespace tuttle {
+namespace plugin {
+namespace v4l2Reader {
+
+/**
+ * @brief Decode a MJPEG frame into packed 8 bits RGB
+ * @param[out] rgb     decoded pixels, 3 * width * height bytes (the buffer is reused, or taken from the frame pool)
+ * @return false if the frame is corrupted, or if the plugin was built without jpeg support (NO_JPEG)
+ */
+bool decodeMjpeg( const unsigned char* data, const std::size_t size, FrameBuffer & rgb, unsigned int & width, unsigned int & height );
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,414 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#include "V4l2Device.hpp"
+
+#include <tuttle/plugin/exceptions.hpp>
+
+#include <linux/videodev2.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace tuttle {
+namespace plugin {
+namespace v4l2Reader {
+
+namespace {
+
+/// ioctl, restarted when interrupted by a signal
+int xioctl( const int fd, const unsigned long request, void* arg )
+{
+    int r;
+    do
+    {
+        r = ioctl( fd, request, arg );
+    }
+    while( r == -1 && errno == EINTR );
+    return r;
+}
+
+std::string errnoString()
+{
+    return std::string( std::strerror( errno ) );
+}
+
+}
+
+std::string fourccToString( const std::uint32_t fourcc )
+{
+    std::string str( 4, ' ' );
+    for( int i = 0; i < 4; ++i )
+    {
+        str[i] = static_cast<char>( ( fourcc >> ( 8 * i ) ) & 0xff );
+    }
+    return str;
+}
+
+V4l2Device::V4l2Device()
+: _fd( -1 )
+, _streaming( false )
+, _generation( 0 )
+, _pinned( 0 )
+{}
+
+V4l2Device::~V4l2Device()
+{
+    close();
+}
+
+void V4l2Device::open( const std::string & path )
+{
+    close();
+    // Non blocking: dequeueLatest polls, then drains every ready buffer
+    _fd = ::open( path.c_str(), O_RDWR | O_NONBLOCK );
+    if ( _fd < 0 )
+    {
+        BOOST_THROW_EXCEPTION( exception::File( path )
+            << exception::user() + "Unable to open the video device: " + errnoString() );
+    }
+    _path = path;
+
+    v4l2_capability cap;
+    std::memset( &cap, 0, sizeof( cap ) );
+    if ( xioctl( _fd, VIDIOC_QUERYCAP, &cap ) == -1 )
+    {
+        close();
+        BOOST_THROW_EXCEPTION( exception::File( path )
+            << exception::user() + "Not a V4L2 device." );
+    }
+    const std::uint32_t caps = ( cap.capabilities & V4L2_CAP_DEVICE_CAPS ) ? cap.device_caps : cap.capabilities;
+    if ( !( caps & V4L2_CAP_VIDEO_CAPTURE ) || !( caps & V4L2_CAP_STREAMING ) )
+    {
+        close();
+        BOOST_THROW_EXCEPTION( exception::File( path )
+            << exception::user() + "The device doesn't support video capture streaming." );
+    }
+}
+
+void V4l2Device::close()
+{
+    if ( _fd >= 0 )
+    {
+        stopStreaming();
+        ::close( _fd );
+        _fd = -1;
+    }
+    _format = V4l2Format();
+}
+
+std::vector<std::uint32_t> V4l2Device::supportedPixelFormats() const
+{
+    std::vector<std::uint32_t> formats;
+    v4l2_fmtdesc desc;
+    std::memset( &desc, 0, sizeof( desc ) );
+    desc.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    while( xioctl( _fd, VIDIOC_ENUM_FMT, &desc ) == 0 )
+    {
+        formats.push_back( desc.pixelformat );
+        ++desc.index;
+    }
+    return formats;
+}
+
+const V4l2Format & V4l2Device::setFormat( const unsigned int width, const unsigned int height, const std::vector<std::uint32_t> & preferredPixelFormats )
+{
+    for( const std::uint32_t pixelFormat: preferredPixelFormats )
+    {
+        v4l2_format fmt;
+        std::memset( &fmt, 0, sizeof( fmt ) );
+        fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        fmt.fmt.pix.width = width;
+        fmt.fmt.pix.height = height;
+        fmt.fmt.pix.pixelformat = pixelFormat;
+        fmt.fmt.pix.field = V4L2_FIELD_NONE;
+        if ( xioctl( _fd, VIDIOC_S_FMT, &fmt ) == -1 )
+        {
+            continue;
+        }
+        // The driver replaces unsupported formats by one of its own
+        if ( fmt.fmt.pix.pixelformat != pixelFormat )
+        {
+            continue;
+        }
+        _format.width = fmt.fmt.pix.width;
+        _format.height = fmt.fmt.pix.height;
+        _format.pixelFormat = fmt.fmt.pix.pixelformat;
+        _format.bytesPerLine = fmt.fmt.pix.bytesperline;
+        _format.sizeImage = fmt.fmt.pix.sizeimage;
+        return _format;
+    }
+    BOOST_THROW_EXCEPTION( exception::Unsupported()
+        << exception::user() + "None of the supported pixel formats is accepted by " + _path + "." );
+}
+
+void V4l2Device::setFrameRate( const double fps )
+{
+    if ( fps <= 0.0 )
+    {
+        return;
+    }
+    v4l2_streamparm parm;
+    std::memset( &parm, 0, sizeof( parm ) );
+    parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if ( xioctl( _fd, VIDIOC_G_PARM, &parm ) == -1 || !( parm.parm.capture.capability & V4L2_CAP_TIMEPERFRAME ) )
+    {
+        return;
+    }
+    parm.parm.capture.timeperframe.numerator = 1000;
+    parm.parm.capture.timeperframe.denominator = static_cast<std::uint32_t>( fps * 1000.0 );
+    xioctl( _fd, VIDIOC_S_PARM, &parm );
+}
+
+void V4l2Device::startStreaming( const std::size_t nbBuffers )
+{
+    if ( _streaming )
+    {
+        return;
+    }
+
+    v4l2_requestbuffers req;
+    std::memset( &req, 0, sizeof( req ) );
+    req.count = nbBuffers;
+    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    req.memory = V4L2_MEMORY_MMAP;
+    if ( xioctl( _fd, VIDIOC_REQBUFS, &req ) == -1 || req.count < 2 )
+    {
+        BOOST_THROW_EXCEPTION( exception::Failed()
+            << exception::user() + "Unable to allocate capture buffers on " + _path + "." );
+    }
+
+    _mappings.resize( req.count );
+    for( unsigned int i = 0; i < req.count; ++i )
+    {
+        v4l2_buffer buf;
+        std::memset( &buf, 0, sizeof( buf ) );
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = i;
+        if ( xioctl( _fd, VIDIOC_QUERYBUF, &buf ) == -1 )
+        {
+            unmapBuffers();
+            BOOST_THROW_EXCEPTION( exception::Failed()
+                << exception::user() + "Unable to query capture buffer: " + errnoString() );
+        }
+        _mappings[i].length = buf.length;
+        _mappings[i].start = mmap( NULL, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, buf.m.offset );
+        if ( _mappings[i].start == MAP_FAILED )
+        {
+            _mappings[i].start = NULL;
+            unmapBuffers();
+            BOOST_THROW_EXCEPTION( exception::Failed()
+                << exception::user() + "Unable to map capture buffer: " + errnoString() );
+        }
+    }
+
+    for( unsigned int i = 0; i < _mappings.size(); ++i )
+    {
+        queue( i );
+    }
+
+    v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if ( xioctl( _fd, VIDIOC_STREAMON, &type ) == -1 )
+    {
+        unmapBuffers();
+        BOOST_THROW_EXCEPTION( exception::Failed()
+            << exception::user() + "Unable to start streaming: " + errnoString() );
+    }
+    std::unique_lock<std::mutex> lock( _mutex );
+    ++_generation;
+    _streaming = true;
+}
+
+void V4l2Device::stopStreaming()
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    if ( !_streaming )
+    {
+        return;
+    }
+    _streaming = false;
+    v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    xioctl( _fd, VIDIOC_STREAMOFF, &type );
+    // A render may still read a dequeued buffer: keep it mapped until released
+    _unpinned.wait( lock, [this]() { return _pinned == 0; } );
+    unmapBuffers();
+}
+
+void V4l2Device::unmapBuffers()
+{
+    for( const Mapping & mapping: _mappings )
+    {
+        if ( mapping.start )
+        {
+            munmap( mapping.start, mapping.length );
+        }
+    }
+    _mappings.clear();
+
+    // Free the driver buffers
+    v4l2_requestbuffers req;
+    std::memset( &req, 0, sizeof( req ) );
+    req.count = 0;
+    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    req.memory = V4L2_MEMORY_MMAP;
+    xioctl( _fd, VIDIOC_REQBUFS, &req );
+}
+
+void V4l2Device::queue( const unsigned int index )
+{
+    v4l2_buffer buf;
+    std::memset( &buf, 0, sizeof( buf ) );
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = V4L2_MEMORY_MMAP;
+    buf.index = index;
+    if ( xioctl( _fd, VIDIOC_QBUF, &buf ) == -1 )
+    {
+        BOOST_THROW_EXCEPTION( exception::Failed()
+            << exception::user() + "Unable to queue capture buffer: " + errnoString() );
+    }
+}
+
+void V4l2Device::release( const V4l2Buffer & buffer )
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    // After a STREAMOFF the buffers are already back to the driver
+    if ( _streaming && buffer.generation == _generation )
+    {
+        // Called from a destructor: a failure only means one buffer less
+        v4l2_buffer buf;
+        std::memset( &buf, 0, sizeof( buf ) );
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = buffer.index;
+        xioctl( _fd, VIDIOC_QBUF, &buf );
+    }
+    if ( --_pinned == 0 )
+    {
+        _unpinned.notify_all();
+    }
+}
+
+void V4l2Device::unpin()
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    if ( --_pinned == 0 )
+    {
+        _unpinned.notify_all();
+    }
+}
+
+V4l2Device::BufferPtr V4l2Device::dequeueLatest( const int timeoutMs )
+{
+    {
+        std::unique_lock<std::mutex> lock( _mutex );
+        if ( !_streaming )
+        {
+            return BufferPtr();
+        }
+        // The descriptor and the mappings stay valid until the buffer is released
+        ++_pinned;
+    }
+    V4l2Buffer* buffer = NULL;
+    try
+    {
+        buffer = dequeue( timeoutMs );
+    }
+    catch( ... )
+    {
+        unpin();
+        throw;
+    }
+    if ( !buffer )
+    {
+        unpin();
+        return BufferPtr();
+    }
+    return BufferPtr( buffer, [this]( const V4l2Buffer* b ) { release( *b ); delete b; } );
+}
+
+V4l2Buffer* V4l2Device::dequeue( const int timeoutMs )
+{
+    pollfd pfd;
+    pfd.fd = _fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    int r;
+    do
+    {
+        r = poll( &pfd, 1, timeoutMs );
+    }
+    while( r == -1 && errno == EINTR );
+    if ( r <= 0 )
+    {
+        return NULL;
+    }
+
+    // Drain the queue: keep the most recent frame, give the others back
+    v4l2_buffer latest;
+    bool hasLatest = false;
+    std::unique_lock<std::mutex> lock( _mutex );
+    if ( !_streaming )
+    {
+        // Stopped while waiting
+        return NULL;
+    }
+    for( ;; )
+    {
+        v4l2_buffer buf;
+        std::memset( &buf, 0, sizeof( buf ) );
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        if ( xioctl( _fd, VIDIOC_DQBUF, &buf ) == -1 )
+        {
+            if ( errno == EAGAIN )
+            {
+                break;
+            }
+            const std::string error = errnoString();
+            if ( hasLatest )
+            {
+                // Don't lose the frame kept so far
+                queue( latest.index );
+            }
+            BOOST_THROW_EXCEPTION( exception::Failed()
+                << exception::user() + "Unable to dequeue capture buffer: " + error );
+        }
+        if ( buf.flags & V4L2_BUF_FLAG_ERROR )
+        {
+            queue( buf.index );
+            continue;
+        }
+        if ( hasLatest )
+        {
+            queue( latest.index );
+        }
+        latest = buf;
+        hasLatest = true;
+    }
+    if ( !hasLatest )
+    {
+        return NULL;
+    }
+
+    V4l2Buffer* buffer = new V4l2Buffer();
+    buffer->data = static_cast<const unsigned char*>( _mappings[latest.index].start );
+    buffer->bytesUsed = latest.bytesused;
+    buffer->sequence = latest.sequence;
+    buffer->timestamp = static_cast<std::int64_t>( latest.timestamp.tv_sec ) * 1000000 + latest.timestamp.tv_usec;
+    buffer->monotonicTimestamp = ( latest.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK ) == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC;
+    buffer->index = latest.index;
+    buffer->generation = _generation;
+    return buffer;
+}
+
+}
+}
+}
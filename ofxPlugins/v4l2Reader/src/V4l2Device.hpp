@@ -0,0 +1,163 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#ifndef _TUTTLE_PLUGIN_V4L2READER_DEVICE_HPP_
+#define _TUTTLE_PLUGIN_V4L2READER_DEVICE_HPP_
+
+#include <boost/shared_ptr.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace tuttle {
+namespace plugin {
+namespace v4l2Reader {
+
+/**
+ * @brief Negotiated capture format
+ */
+struct V4l2Format
+{
+    V4l2Format()
+    : width( 0 )
+    , height( 0 )
+    , pixelFormat( 0 )
+    , bytesPerLine( 0 )
+    , sizeImage( 0 )
+    {}
+
+    unsigned int width;
+    unsigned int height;
+    std::uint32_t pixelFormat;      ///< V4L2 fourcc
+    unsigned int bytesPerLine;
+    unsigned int sizeImage;
+};
+
+/**
+ * @brief A dequeued capture buffer, still mapped in the driver memory
+ */
+struct V4l2Buffer
+{
+    const unsigned char* data;      ///< Mapped driver memory
+    std::size_t bytesUsed;          ///< Payload size (variable for compressed formats)
+    std::uint32_t sequence;         ///< Driver frame counter, gaps mean dropped frames
+    std::int64_t timestamp;         ///< Capture time in microseconds (CLOCK_MONOTONIC when the driver says so)
+    bool monotonicTimestamp;        ///< The timestamp comes from the monotonic clock
+    unsigned int index;             ///< Driver buffer index
+    std::size_t generation;         ///< Streaming session the buffer belongs to
+};
+
+/**
+ * @brief Minimal V4L2 capture device using mmap streaming I/O.
+ *
+ * The driver fills a set of memory mapped buffers, dequeueLatest() returns
+ * the most recent one and gives the older ones back to the driver, so that
+ * a slow consumer always sees the last frame instead of a growing backlog.
+ * A dequeued buffer goes back to the driver when its last reference dies,
+ * stopStreaming() and close() wait for it before unmapping the buffers.
+ */
+class V4l2Device
+{
+public:
+    typedef boost::shared_ptr<const V4l2Buffer> BufferPtr;
+
+public:
+    V4l2Device();
+    ~V4l2Device();
+
+    /**
+     * @brief open the device and check it can stream video captures
+     */
+    void open( const std::string & path );
+    void close();
+
+    inline bool isOpen() const
+    { return _fd >= 0; }
+
+    inline const std::string & path() const
+    { return _path; }
+
+    /**
+     * @brief list the pixel formats (fourcc) the device can deliver
+     */
+    std::vector<std::uint32_t> supportedPixelFormats() const;
+
+    /**
+     * @brief set the capture format, taking the first preferred pixel format
+     *        the driver accepts
+     * @return the format really set by the driver (which may adjust the size)
+     */
+    const V4l2Format & setFormat( const unsigned int width, const unsigned int height, const std::vector<std::uint32_t> & preferredPixelFormats );
+
+    /**
+     * @brief ask for a frame rate (ignored by drivers that don't support it)
+     */
+    void setFrameRate( const double fps );
+
+    inline const V4l2Format & format() const
+    { return _format; }
+
+    /**
+     * @brief allocate and map the buffers, then start capturing
+     */
+    void startStreaming( const std::size_t nbBuffers );
+
+    /**
+     * @brief stop capturing, waits until the dequeued buffers are released
+     */
+    void stopStreaming();
+
+    inline bool isStreaming() const
+    { return _streaming; }
+
+    /**
+     * @brief wait for a frame and return the most recent one
+     * @param timeoutMs maximum time to wait for the first frame
+     * @return null on timeout
+     */
+    BufferPtr dequeueLatest( const int timeoutMs );
+
+private:
+    /// Poll and drain the driver queue, null on timeout
+    V4l2Buffer* dequeue( const int timeoutMs );
+    void queue( const unsigned int index );
+    void release( const V4l2Buffer & buffer );
+    void unmapBuffers();
+    /// Stop the use of the session, wakes stopStreaming when it was the last one
+    void unpin();
+
+private:
+    struct Mapping
+    {
+        void* start;
+        std::size_t length;
+    };
+
+    int _fd;                        ///< Device file descriptor
+    std::string _path;              ///< Device path
+    V4l2Format _format;             ///< Current format
+    std::vector<Mapping> _mappings; ///< Mapped driver buffers
+    std::atomic<bool> _streaming;   ///< Capture is running
+    std::size_t _generation;        ///< Incremented on each streaming session
+    std::size_t _pinned;            ///< Dequeued buffers and dequeues in progress, using the mappings
+    std::mutex _mutex;              ///< Protects queueing from the rendering threads
+    std::condition_variable _unpinned; ///< Signaled when _pinned drops to zero
+};
+
+/**
+ * @brief get a printable fourcc
+ */
+std::string fourccToString( const std::uint32_t fourcc );
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,109 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#ifndef _TUTTLE_PLUGIN_V4L2READER_ALGORITHM_HPP_
+#define _TUTTLE_PLUGIN_V4L2READER_ALGORITHM_HPP_
+
+#include <terry/color/demosaic.hpp>
+#include <terry/simd.hpp>
+
+#include <linux/videodev2.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace tuttle {
+namespace plugin {
+namespace v4l2Reader {
+
+/**
+ * @brief Convert a row of YUYV (4:2:2, BT.601 video range) into float RGB
+ * @param[in]  src    first byte of the row (Y0 U Y1 V ...)
+ * @param[out] dst    interleaved rgb floats in [0, 1], 3 * width values
+ * @param[in]  width  number of pixels, must be even
+ *
+ * Four pixels (two YUYV macro pixels) are converted at once.
+ */
+inline void yuyvRowToRgb( const unsigned char* src, float* dst, const std::size_t width )
+{
+    using namespace terry::simd;
+    static const float kScale = 1.0f / 255.0f;
+    const float4 yOffset = set1( 16.0f );
+    const float4 uvOffset = set1( 128.0f );
+    const float4 yGain = set1( 1.164f * kScale );
+    const float4 rv = set1( 1.596f * kScale );
+    const float4 gu = set1( -0.392f * kScale );
+    const float4 gv = set1( -0.813f * kScale );
+    const float4 bu = set1( 2.017f * kScale );
+    const float4 zero = set1( 0.0f );
+    const float4 one = set1( 1.0f );
+
+    std::size_t x = 0;
+    float r[4], g[4], b[4];
+    for( ; x + 4 <= width; x += 4, src += 8 )
+    {
+        const float4 y = mul( sub( set( src[0], src[2], src[4], src[6] ), yOffset ), yGain );
+        const float4 u = sub( set( src[1], src[1], src[5], src[5] ), uvOffset );
+        const float4 v = sub( set( src[3], src[3], src[7], src[7] ), uvOffset );
+        store( r, clamp( madd( v, rv, y ), zero, one ) );
+        store( g, clamp( madd( v, gv, madd( u, gu, y ) ), zero, one ) );
+        store( b, clamp( madd( u, bu, y ), zero, one ) );
+        for( int i = 0; i < 4; ++i, dst += 3 )
+        {
+            dst[0] = r[i];
+            dst[1] = g[i];
+            dst[2] = b[i];
+        }
+    }
+    // Remaining macro pixel
+    for( ; x + 2 <= width; x += 2, src += 4 )
+    {
+        const float u = src[1] - 128.0f;
+        const float v = src[3] - 128.0f;
+        for( int i = 0; i < 2; ++i, dst += 3 )
+        {
+            const float y = ( src[2 * i] - 16.0f ) * 1.164f;
+            dst[0] = std::min( 1.0f, std::max( 0.0f, ( y + 1.596f * v ) * kScale ) );
+            dst[1] = std::min( 1.0f, std::max( 0.0f, ( y - 0.392f * u - 0.813f * v ) * kScale ) );
+            dst[2] = std::min( 1.0f, std::max( 0.0f, ( y + 2.017f * u ) * kScale ) );
+        }
+    }
+}
+
+/**
+ * @brief Get the bayer layout of a V4L2 pixel format
+ * @param[out] bits  significant bits per sample (samples above 8 bits are stored on 16 bits)
+ * @return false if the format is not a bayer one
+ */
+inline bool bayerFormat( const std::uint32_t fourcc, terry::color::BayerPattern & pattern, int & bits )
+{
+    switch( fourcc )
+    {
+        case V4L2_PIX_FMT_SRGGB8:  pattern.redX = 0; pattern.redY = 0; bits = 8;  return true;
+        case V4L2_PIX_FMT_SGRBG8:  pattern.redX = 1; pattern.redY = 0; bits = 8;  return true;
+        case V4L2_PIX_FMT_SGBRG8:  pattern.redX = 0; pattern.redY = 1; bits = 8;  return true;
+        case V4L2_PIX_FMT_SBGGR8:  pattern.redX = 1; pattern.redY = 1; bits = 8;  return true;
+        case V4L2_PIX_FMT_SRGGB10: pattern.redX = 0; pattern.redY = 0; bits = 10; return true;
+        case V4L2_PIX_FMT_SGRBG10: pattern.redX = 1; pattern.redY = 0; bits = 10; return true;
+        case V4L2_PIX_FMT_SGBRG10: pattern.redX = 0; pattern.redY = 1; bits = 10; return true;
+        case V4L2_PIX_FMT_SBGGR10: pattern.redX = 1; pattern.redY = 1; bits = 10; return true;
+        case V4L2_PIX_FMT_SRGGB12: pattern.redX = 0; pattern.redY = 0; bits = 12; return true;
+        case V4L2_PIX_FMT_SGRBG12: pattern.redX = 1; pattern.redY = 0; bits = 12; return true;
+        case V4L2_PIX_FMT_SGBRG12: pattern.redX = 0; pattern.redY = 1; bits = 12; return true;
+        case V4L2_PIX_FMT_SBGGR12: pattern.redX = 1; pattern.redY = 1; bits = 12; return true;
+        case V4L2_PIX_FMT_SRGGB16: pattern.redX = 0; pattern.redY = 0; bits = 16; return true;
+        case V4L2_PIX_FMT_SGRBG16: pattern.redX = 1; pattern.redY = 0; bits = 16; return true;
+        case V4L2_PIX_FMT_SGBRG16: pattern.redX = 0; pattern.redY = 1; bits = 16; return true;
+        case V4L2_PIX_FMT_SBGGR16: pattern.redX = 1; pattern.redY = 1; bits = 16; return true;
+    }
+    return false;
+}
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,54 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#ifndef _TUTTLE_PLUGIN_V4L2READER_DEFINITIONS_HPP_
+#define _TUTTLE_PLUGIN_V4L2READER_DEFINITIONS_HPP_
+
+#include <tuttle/plugin/global.hpp>
+
+namespace tuttle {
+namespace plugin {
+namespace v4l2Reader {
+
+enum EParamPixelFormat
+{
+    eParamPixelFormatAuto = 0,
+    eParamPixelFormatYUYV,
+    eParamPixelFormatMJPEG,
+    eParamPixelFormatBayer
+};
+
+static const std::string kParamDevice( "Device" );
+static const std::string kParamDefaultDevice( "/dev/video0" );
+
+static const std::string kParamWidth( "Width" );
+static const int kParamDefaultWidth( 1920 );
+static const std::string kParamHeight( "Height" );
+static const int kParamDefaultHeight( 1080 );
+
+static const std::string kParamPixelFormat( "Pixel format" );
+static const std::string kParamPixelFormatAuto( "Auto" );
+static const std::string kParamPixelFormatYUYV( "YUYV" );
+static const std::string kParamPixelFormatMJPEG( "MJPEG" );
+static const std::string kParamPixelFormatBayer( "Raw bayer" );
+
+static const std::string kParamDemosaic( "Demosaic" );
+static const std::string kParamDemosaicBilinear( "Bilinear" );
+static const std::string kParamDemosaicEdgeAware( "Edge aware" );
+
+static const std::string kParamFrameRate( "Frame rate" );
+static const double kParamDefaultFrameRate( 25.0 );
+
+static const std::string kParamCaptureBuffers( "Capture buffers" );
+static const int kParamDefaultCaptureBuffers( 4 );
+
+/// Maximum time to wait for a frame, in milliseconds
+static const int kCaptureTimeout( 2000 );
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,271 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#include "V4l2ReaderPlugin.hpp"
+#include "V4l2ReaderProcess.hpp"
+
+#include <linux/videodev2.h>
+
+namespace tuttle {
+namespace plugin {
+namespace v4l2Reader {
+
+V4l2ReaderPlugin::V4l2ReaderPlugin( OfxImageEffectHandle handle )
+: OFX::ImageEffect( handle )
+, _device( new V4l2Device() )
+, _hasLastSequence( false )
+, _lastSequence( 0 )
+, _lastTimestamp( 0 )
+, _renderedTime( 0.0 )
+, _holdRenderedFrame( true )
+{
+    _clipDst = fetchClip( kOfxImageEffectOutputClipName );
+    _paramDevice = fetchStringParam( kParamDevice );
+    _paramWidth = fetchIntParam( kParamWidth );
+    _paramHeight = fetchIntParam( kParamHeight );
+    _paramPixelFormat = fetchChoiceParam( kParamPixelFormat );
+    _paramFrameRate = fetchDoubleParam( kParamFrameRate );
+    _paramCaptureBuffers = fetchIntParam( kParamCaptureBuffers );
+    _paramDemosaic = fetchChoiceParam( kParamDemosaic );
+    _paramBitDepth = fetchChoiceParam( kTuttlePluginBitDepth );
+    _paramChannel = fetchChoiceParam( kTuttlePluginChannel );
+}
+
+V4l2ReaderPlugin::~V4l2ReaderPlugin()
+{
+    // Its driver buffer must be given back before the device is closed
+    _renderedFrame.reset();
+}
+
+std::vector<std::uint32_t> V4l2ReaderPlugin::preferredPixelFormats() const
+{
+    static const std::uint32_t kYUYV[] = { V4L2_PIX_FMT_YUYV };
+    static const std::uint32_t kMJPEG[] = { V4L2_PIX_FMT_MJPEG };
+    static const std::uint32_t kBayer[] = {
+        V4L2_PIX_FMT_SRGGB16, V4L2_PIX_FMT_SBGGR16, V4L2_PIX_FMT_SGRBG16, V4L2_PIX_FMT_SGBRG16,
+        V4L2_PIX_FMT_SRGGB12, V4L2_PIX_FMT_SBGGR12, V4L2_PIX_FMT_SGRBG12, V4L2_PIX_FMT_SGBRG12,
+        V4L2_PIX_FMT_SRGGB10, V4L2_PIX_FMT_SBGGR10, V4L2_PIX_FMT_SGRBG10, V4L2_PIX_FMT_SGBRG10,
+        V4L2_PIX_FMT_SRGGB8, V4L2_PIX_FMT_SBGGR8, V4L2_PIX_FMT_SGRBG8, V4L2_PIX_FMT_SGBRG8 };
+
+    std::vector<std::uint32_t> formats;
+    switch( static_cast<EParamPixelFormat>( _paramPixelFormat->getValue() ) )
+    {
+        case eParamPixelFormatAuto:
+        {
+            // Uncompressed first, then compressed, raw needs a debayering
+            formats.insert( formats.end(), kYUYV, kYUYV + 1 );
+            formats.insert( formats.end(), kMJPEG, kMJPEG + 1 );
+            formats.insert( formats.end(), kBayer, kBayer + sizeof( kBayer ) / sizeof( kBayer[0] ) );
+            break;
+        }
+        case eParamPixelFormatYUYV:
+        {
+            formats.insert( formats.end(), kYUYV, kYUYV + 1 );
+            break;
+        }
+        case eParamPixelFormatMJPEG:
+        {
+            formats.insert( formats.end(), kMJPEG, kMJPEG + 1 );
+            break;
+        }
+        case eParamPixelFormatBayer:
+        {
+            formats.insert( formats.end(), kBayer, kBayer + sizeof( kBayer ) / sizeof( kBayer[0] ) );
+            break;
+        }
+    }
+    return formats;
+}
+
+void V4l2ReaderPlugin::ensureDevice()
+{
+    std::unique_lock<std::mutex> lock( _deviceMutex );
+    if ( _device->isOpen() )
+    {
+        return;
+    }
+    _device->open( _paramDevice->getValue() );
+    _device->setFormat( _paramWidth->getValue(), _paramHeight->getValue(), preferredPixelFormats() );
+    _device->setFrameRate( _paramFrameRate->getValue() );
+    std::unique_lock<std::mutex> frameLock( _frameMutex );
+    _hasLastSequence = false;
+    TUTTLE_LOG_INFO( "[V4l2Reader] " << _device->path() << ": " << fourccToString( _device->format().pixelFormat )
+                     << " " << _device->format().width << "x" << _device->format().height );
+}
+
+void V4l2ReaderPlugin::changedParam( const OFX::InstanceChangedArgs& args, const std::string& paramName )
+{
+    if ( paramName == kParamDevice || paramName == kParamWidth || paramName == kParamHeight ||
+         paramName == kParamPixelFormat || paramName == kParamFrameRate || paramName == kParamCaptureBuffers )
+    {
+        // Reopened with the new settings on next use, waits for the renders reading a frame.
+        // The renders in progress mustn't keep their frame: close would wait for it forever.
+        {
+            std::unique_lock<std::mutex> frameLock( _frameMutex );
+            _renderedFrame.reset();
+            _holdRenderedFrame = false;
+        }
+        {
+            std::unique_lock<std::mutex> lock( _deviceMutex );
+            _device->close();
+        }
+        std::unique_lock<std::mutex> frameLock( _frameMutex );
+        _holdRenderedFrame = true;
+    }
+}
+
+bool V4l2ReaderPlugin::getRegionOfDefinition( const OFX::RegionOfDefinitionArguments& args, OfxRectD& rod )
+{
+    ensureDevice();
+    rod.x1 = 0;
+    rod.x2 = _device->format().width * _clipDst->getPixelAspectRatio();
+    rod.y1 = 0;
+    rod.y2 = _device->format().height;
+    return true;
+}
+
+void V4l2ReaderPlugin::getClipPreferences( OFX::ClipPreferencesSetter& clipPreferences )
+{
+    clipPreferences.setOutputFrameVarying( true );
+
+    switch( static_cast<EParamReaderBitDepth>( _paramBitDepth->getValue() ) )
+    {
+        case eParamReaderBitDepthByte:
+        {
+            clipPreferences.setClipBitDepth( *this->_clipDst, OFX::eBitDepthUByte );
+            break;
+        }
+        case eParamReaderBitDepthShort:
+        {
+            clipPreferences.setClipBitDepth( *this->_clipDst, OFX::eBitDepthUShort );
+            break;
+        }
+        case eParamReaderBitDepthAuto:
+        case eParamReaderBitDepthFloat:
+        {
+            clipPreferences.setClipBitDepth( *this->_clipDst, OFX::eBitDepthFloat );
+            break;
+        }
+    }
+    switch( static_cast<EParamReaderChannel>( _paramChannel->getValue() ) )
+    {
+        case eParamReaderChannelGray:
+        {
+            clipPreferences.setClipComponents( *this->_clipDst, OFX::ePixelComponentAlpha );
+            break;
+        }
+        case eParamReaderChannelRGB:
+        {
+            if( OFX::getImageEffectHostDescription()->supportsPixelComponent( OFX::ePixelComponentRGB ) )
+                clipPreferences.setClipComponents( *this->_clipDst, OFX::ePixelComponentRGB );
+            else
+                clipPreferences.setClipComponents( *this->_clipDst, OFX::ePixelComponentRGBA );
+            break;
+        }
+        case eParamReaderChannelAuto:
+        case eParamReaderChannelRGBA:
+        {
+            clipPreferences.setClipComponents( *this->_clipDst, OFX::ePixelComponentRGBA );
+            break;
+        }
+    }
+
+    clipPreferences.setPixelAspectRatio( *this->_clipDst, 1.0 );
+}
+
+bool V4l2ReaderPlugin::getTimeDomain( OfxRangeD& range )
+{
+    range.min = 0.0;
+    range.max = kOfxFlagInfiniteMax;
+    return true;
+}
+
+V4l2ReaderProcessParams V4l2ReaderPlugin::getProcessParams( const OfxTime time )
+{
+    ensureDevice();
+    {
+        std::unique_lock<std::mutex> lock( _deviceMutex );
+        _device->startStreaming( _paramCaptureBuffers->getValue() );
+    }
+    V4l2ReaderProcessParams params;
+    params.device = _device;
+    params.demosaic = static_cast<terry::color::EDemosaicMethod>( _paramDemosaic->getValue() );
+    return params;
+}
+
+void V4l2ReaderPlugin::notifyFrame( const V4l2Buffer & buffer )
+{
+    std::unique_lock<std::mutex> lock( _frameMutex );
+    if ( _hasLastSequence && buffer.sequence <= _lastSequence )
+    {
+        // A concurrent render already reported a more recent frame
+        return;
+    }
+    if ( _hasLastSequence && buffer.sequence > _lastSequence + 1 )
+    {
+        TUTTLE_LOG_WARNING( "[V4l2Reader] " << ( buffer.sequence - _lastSequence - 1 ) << " frame(s) skipped since last render" );
+    }
+    _hasLastSequence = true;
+    _lastSequence = buffer.sequence;
+    _lastTimestamp = buffer.timestamp;
+}
+
+V4l2FramePtr V4l2ReaderPlugin::renderedFrame( const OfxTime time )
+{
+    std::unique_lock<std::mutex> lock( _frameMutex );
+    if ( !_renderedFrame || _renderedTime != time )
+    {
+        return V4l2FramePtr();
+    }
+    return _renderedFrame;
+}
+
+void V4l2ReaderPlugin::setRenderedFrame( const OfxTime time, const V4l2FramePtr & frame )
+{
+    std::unique_lock<std::mutex> lock( _frameMutex );
+    if ( _holdRenderedFrame )
+    {
+        _renderedTime = time;
+        _renderedFrame = frame;
+    }
+}
+
+void V4l2ReaderPlugin::render( const OFX::RenderArguments& args )
+{
+    // instantiate the render code based on the pixel depth of the dst clip
+    OFX::EBitDepth bitDepth         = _clipDst->getPixelDepth();
+    OFX::EPixelComponent components = _clipDst->getPixelComponents();
+
+    switch( components )
+    {
+        case OFX::ePixelComponentRGBA:
+        {
+            doGilRender<V4l2ReaderProcess, false, terry::rgba_layout_t>( *this, args, bitDepth );
+            return;
+        }
+        case OFX::ePixelComponentRGB:
+        {
+            doGilRender<V4l2ReaderProcess, false, terry::rgb_layout_t>( *this, args, bitDepth );
+            return;
+        }
+        case OFX::ePixelComponentAlpha:
+        {
+            doGilRender<V4l2ReaderProcess, false, terry::gray_layout_t>( *this, args, bitDepth );
+            return;
+        }
+        case OFX::ePixelComponentCustom:
+        case OFX::ePixelComponentNone:
+        {
+            BOOST_THROW_EXCEPTION( exception::Unsupported()
+                    << exception::user() + "Pixel components (" + mapPixelComponentEnumToString(components) + ") not supported by the plugin." );
+        }
+        default:
+            BOOST_THROW_EXCEPTION( exception::Unknown() );
+    }
+}
+
+}
+}
+}
@@ -0,0 +1,126 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#ifndef _TUTTLE_PLUGIN_V4L2READER_PLUGIN_HPP_
+#define _TUTTLE_PLUGIN_V4L2READER_PLUGIN_HPP_
+
+#include "V4l2ReaderDefinitions.hpp"
+#include "V4l2Device.hpp"
+
+#include <boost/gil/channel_algorithm.hpp> // force to use the boostHack version first
+
+#include <tuttle/plugin/ImageEffectGilPlugin.hpp>
+#include <tuttle/plugin/context/ReaderDefinition.hpp>
+#include <tuttle/plugin/exceptions.hpp>
+#include <tuttle/plugin/memory/FramePool.hpp>
+
+#include <terry/color/demosaic.hpp>
+
+#include <boost/shared_ptr.hpp>
+
+#include <mutex>
+
+namespace tuttle {
+namespace plugin {
+namespace v4l2Reader {
+
+struct V4l2ReaderProcessParams
+{
+    boost::shared_ptr<V4l2Device> device;   ///< Streaming device
+    terry::color::EDemosaicMethod demosaic; ///< Demosaic of the raw bayer formats
+};
+
+/**
+ * @brief A frame given by the device, shared by the renders of its time
+ */
+struct V4l2Frame
+{
+    V4l2Device::BufferPtr buffer;   ///< Driver buffer (uncompressed formats), given back to the driver with the frame
+    FrameBuffer decoded;            ///< Decoded frame (compressed formats), from the frame pool
+    V4l2Format format;              ///< Format of the frame
+};
+
+typedef boost::shared_ptr<V4l2Frame> V4l2FramePtr;
+
+/**
+ * @brief V4L2 camera reader plugin
+ */
+class V4l2ReaderPlugin : public OFX::ImageEffect
+{
+public:
+    V4l2ReaderPlugin( OfxImageEffectHandle handle );
+    virtual ~V4l2ReaderPlugin();
+
+public:
+    void changedParam( const OFX::InstanceChangedArgs& args, const std::string& paramName );
+    bool getRegionOfDefinition( const OFX::RegionOfDefinitionArguments& args, OfxRectD& rod );
+    void getClipPreferences( OFX::ClipPreferencesSetter& clipPreferences );
+    bool getTimeDomain( OfxRangeD& range );
+    void render( const OFX::RenderArguments& args );
+
+    V4l2ReaderProcessParams getProcessParams( const OfxTime time );
+
+    /**
+     * @brief keep track of the frames given by the driver (drop detection, timestamps)
+     */
+    void notifyFrame( const V4l2Buffer & buffer );
+
+    /**
+     * @brief get the frame already rendered at this time
+     * The device has a new frame on each call, a render of the same time
+     * (the host computing the graph again after the reader) must give the
+     * frame that was exposed for it.
+     * @return null if another time was rendered since
+     */
+    V4l2FramePtr renderedFrame( const OfxTime time );
+
+    /**
+     * @brief keep the frame rendered at this time, until another time is rendered
+     * An uncompressed frame keeps its driver buffer until then.
+     */
+    void setRenderedFrame( const OfxTime time, const V4l2FramePtr & frame );
+
+    /**
+     * @brief driver timestamp of the last rendered frame, in microseconds
+     */
+    inline std::int64_t lastFrameTimestamp() const
+    {
+        std::unique_lock<std::mutex> lock( _frameMutex );
+        return _lastTimestamp;
+    }
+
+private:
+    /// Open and configure the device if needed
+    void ensureDevice();
+    std::vector<std::uint32_t> preferredPixelFormats() const;
+
+private:
+    OFX::Clip*           _clipDst;              ///< Destination image clip
+    OFX::StringParam*    _paramDevice;          ///< Device path
+    OFX::IntParam*       _paramWidth;           ///< Requested width
+    OFX::IntParam*       _paramHeight;          ///< Requested height
+    OFX::ChoiceParam*    _paramPixelFormat;     ///< Requested pixel format
+    OFX::DoubleParam*    _paramFrameRate;       ///< Requested frame rate
+    OFX::IntParam*       _paramCaptureBuffers;  ///< Number of mmap buffers
+    OFX::ChoiceParam*    _paramDemosaic;        ///< Demosaic of the raw bayer formats
+    OFX::ChoiceParam*    _paramBitDepth;        ///< Explicit bit depth conversion
+    OFX::ChoiceParam*    _paramChannel;         ///< Explicit component conversion
+
+    boost::shared_ptr<V4l2Device> _device;      ///< Capture device
+    std::mutex _deviceMutex;                    ///< Protects the device configuration
+    mutable std::mutex _frameMutex;             ///< Protects the last frame infos from concurrent renders
+    bool _hasLastSequence;                      ///< _lastSequence is valid
+    std::uint32_t _lastSequence;                ///< Driver sequence of the last rendered frame
+    std::int64_t _lastTimestamp;                ///< Driver timestamp of the last rendered frame
+    OfxTime _renderedTime;                      ///< Time of the rendered frame
+    V4l2FramePtr _renderedFrame;                ///< Last rendered frame
+    bool _holdRenderedFrame;                    ///< False while the device is closed
+};
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,164 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#include "V4l2ReaderPluginFactory.hpp"
+#include "V4l2ReaderPlugin.hpp"
+#include "V4l2ReaderDefinitions.hpp"
+#include "ofxsImageEffect.h"
+
+#include <tuttle/plugin/context/ReaderPluginFactory.hpp>
+
+namespace tuttle {
+namespace plugin {
+namespace v4l2Reader {
+
+static const bool kSupportTiles = false;
+
+
+/**
+ * @brief Function called to describe the plugin main features.
+ * @param[in, out] desc Effect descriptor
+ */
+void V4l2ReaderPluginFactory::describe( OFX::ImageEffectDescriptor& desc )
+{
+	desc.setLabels(
+		"V4l2Reader",
+		"V4l2Reader",
+		"Video4Linux camera reader" );
+	desc.setPluginGrouping( "djarlabs" );
+
+	desc.setDescription( "Streams frames from a Video4Linux2 capture device (mmap buffers). "
+	                     "Supports YUYV, MJPEG and raw bayer cameras. "
+	                     "The vivid virtual driver can be used to try it without camera." );
+
+	desc.addSupportedContext( OFX::eContextReader );
+	desc.addSupportedContext( OFX::eContextGeneral );
+
+	// add supported pixel depths
+	desc.addSupportedBitDepth( OFX::eBitDepthUByte );
+	desc.addSupportedBitDepth( OFX::eBitDepthUShort );
+	desc.addSupportedBitDepth( OFX::eBitDepthFloat );
+
+	// plugin flags
+	desc.setRenderThreadSafety( OFX::eRenderInstanceSafe );
+	desc.setHostFrameThreading( false );
+	desc.setSupportsMultiResolution( false );
+	desc.setSupportsMultipleClipDepths( true );
+	desc.setSupportsMultipleClipPARs( true );
+	desc.setSupportsTiles( kSupportTiles );
+}
+
+/**
+ * @brief Function called to describe the plugin controls and features.
+ * @param[in, out]   desc       Effect descriptor
+ * @param[in]        context    Application context
+ */
+void V4l2ReaderPluginFactory::describeInContext( OFX::ImageEffectDescriptor& desc,
+                                                 OFX::EContext context )
+{
+    // Create the mandated output clip
+    OFX::ClipDescriptor* dstClip = desc.defineClip( kOfxImageEffectOutputClipName );
+    dstClip->addSupportedComponent( OFX::ePixelComponentRGBA );
+    dstClip->addSupportedComponent( OFX::ePixelComponentRGB );
+    dstClip->addSupportedComponent( OFX::ePixelComponentAlpha );
+    dstClip->setSupportsTiles( kSupportTiles );
+
+    OFX::ChoiceParamDescriptor* component = desc.defineChoiceParam( kTuttlePluginChannel );
+    component->appendOption( kTuttlePluginChannelAuto );
+    component->appendOption( kTuttlePluginChannelGray );
+    component->appendOption( kTuttlePluginChannelRGB );
+    component->appendOption( kTuttlePluginChannelRGBA );
+
+    component->setLabel( kTuttlePluginChannelLabel );
+    component->setDefault( eParamReaderChannelAuto );
+    desc.addClipPreferencesSlaveParam( *component );
+
+    OFX::ChoiceParamDescriptor* explicitConversion = desc.defineChoiceParam( kTuttlePluginBitDepth );
+    explicitConversion->setLabel( kTuttlePluginBitDepthLabel );
+    explicitConversion->appendOption( kTuttlePluginBitDepthAuto );
+    explicitConversion->appendOption( kTuttlePluginBitDepth8 );
+    explicitConversion->appendOption( kTuttlePluginBitDepth16 );
+    explicitConversion->appendOption( kTuttlePluginBitDepth32f );
+    explicitConversion->setCacheInvalidation( OFX::eCacheInvalidateValueAll );
+    explicitConversion->setAnimates( false );
+    desc.addClipPreferencesSlaveParam( *explicitConversion );
+
+    if( OFX::getImageEffectHostDescription()->supportsMultipleClipDepths )
+    {
+        explicitConversion->setDefault( 0 );
+    }
+    else
+    {
+        explicitConversion->setIsSecret( true );
+        explicitConversion->setDefault( static_cast<int>( OFX::getImageEffectHostDescription()->getDefaultPixelDepth() ) );
+    }
+
+    OFX::StringParamDescriptor* paramDevice = desc.defineStringParam( kParamDevice );
+    paramDevice->setLabel( kParamDevice );
+    paramDevice->setStringType( OFX::eStringTypeFilePath );
+    paramDevice->setDefault( kParamDefaultDevice );
+    paramDevice->setHint( "Video4Linux2 capture device" );
+
+    OFX::IntParamDescriptor* paramWidth = desc.defineIntParam( kParamWidth );
+    paramWidth->setLabel( kParamWidth );
+    paramWidth->setDefault( kParamDefaultWidth );
+    paramWidth->setRange( 1, 16384 );
+    paramWidth->setDisplayRange( 1, 4096 );
+    paramWidth->setHint( "Requested width, the driver takes the closest size it supports" );
+
+    OFX::IntParamDescriptor* paramHeight = desc.defineIntParam( kParamHeight );
+    paramHeight->setLabel( kParamHeight );
+    paramHeight->setDefault( kParamDefaultHeight );
+    paramHeight->setRange( 1, 16384 );
+    paramHeight->setDisplayRange( 1, 4096 );
+    paramHeight->setHint( "Requested height, the driver takes the closest size it supports" );
+
+    OFX::ChoiceParamDescriptor* paramPixelFormat = desc.defineChoiceParam( kParamPixelFormat );
+    paramPixelFormat->setLabel( kParamPixelFormat );
+    paramPixelFormat->appendOption( kParamPixelFormatAuto );
+    paramPixelFormat->appendOption( kParamPixelFormatYUYV );
+    paramPixelFormat->appendOption( kParamPixelFormatMJPEG );
+    paramPixelFormat->appendOption( kParamPixelFormatBayer );
+    paramPixelFormat->setDefault( eParamPixelFormatAuto );
+    paramPixelFormat->setHint( "Native format negotiated with the camera" );
+
+    OFX::ChoiceParamDescriptor* paramDemosaic = desc.defineChoiceParam( kParamDemosaic );
+    paramDemosaic->setLabel( kParamDemosaic );
+    paramDemosaic->appendOption( kParamDemosaicBilinear );
+    paramDemosaic->appendOption( kParamDemosaicEdgeAware );
+    paramDemosaic->setDefault( terry::color::eDemosaicEdgeAware );
+    paramDemosaic->setHint( "Interpolation of the raw bayer formats, done at the full sensor bit depth" );
+
+    OFX::DoubleParamDescriptor* paramFrameRate = desc.defineDoubleParam( kParamFrameRate );
+    paramFrameRate->setLabels( kParamFrameRate, kParamFrameRate, kParamFrameRate );
+    paramFrameRate->setDefault( kParamDefaultFrameRate );
+    paramFrameRate->setRange( 0, 240 );
+    paramFrameRate->setDisplayRange( 0, 60 );
+    paramFrameRate->setHint( "Requested frame rate (0 to keep the driver setting)" );
+
+    OFX::IntParamDescriptor* paramCaptureBuffers = desc.defineIntParam( kParamCaptureBuffers );
+    paramCaptureBuffers->setLabels( kParamCaptureBuffers, kParamCaptureBuffers, kParamCaptureBuffers );
+    paramCaptureBuffers->setDefault( kParamDefaultCaptureBuffers );
+    paramCaptureBuffers->setRange( 2, 32 );
+    paramCaptureBuffers->setDisplayRange( 2, 16 );
+    paramCaptureBuffers->setHint( "Number of buffers shared with the driver" );
+}
+
+/**
+ * @brief Function called to create a plugin effect instance
+ * @param[in] handle  Effect handle
+ * @param[in] context Application context
+ * @return  plugin instance
+ */
+OFX::ImageEffect* V4l2ReaderPluginFactory::createInstance( OfxImageEffectHandle handle,
+                                                          OFX::EContext context )
+{
+    return new V4l2ReaderPlugin( handle );
+}
+
+}
+}
+}
+
@@ -0,0 +1,21 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#ifndef _TUTTLE_PLUGIN_V4L2READERPLUGINFACTORY_HPP_
+#define _TUTTLE_PLUGIN_V4L2READERPLUGINFACTORY_HPP_
+
+#include <ofxsImageEffect.h>
+
+namespace tuttle {
+namespace plugin {
+namespace v4l2Reader {
+
+mDeclarePluginFactory( V4l2ReaderPluginFactory, { }, { } );
+
+}
+}
+}
+
+#endif
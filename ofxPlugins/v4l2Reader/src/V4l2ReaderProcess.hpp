@@ -0,0 +1,57 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#ifndef _TUTTLE_PLUGIN_V4L2READER_PROCESS_HPP_
+#define _TUTTLE_PLUGIN_V4L2READER_PROCESS_HPP_
+
+#include "V4l2Device.hpp"
+
+#include <tuttle/plugin/ImageGilProcessor.hpp>
+
+#include <vector>
+
+namespace tuttle {
+namespace plugin {
+namespace v4l2Reader {
+
+/**
+ * @brief V4l2Reader process
+ * The frame is dequeued in setup (or taken again if this time was already
+ * rendered), then each thread converts its band straight from the driver buffer.
+ */
+template<class View>
+class V4l2ReaderProcess : public ImageGilProcessor<View>
+{
+public:
+    typedef typename View::value_type Pixel;
+    typedef typename boost::gil::channel_type<View>::type Channel;
+    typedef float Scalar;
+protected:
+    V4l2ReaderPlugin&    _plugin;            ///< Rendering plugin
+    V4l2ReaderProcessParams _params;         ///< parameters
+    V4l2FramePtr _frame;                     ///< Frame to convert
+    V4l2Format _format;                      ///< Format of the frame
+
+public:
+    V4l2ReaderProcess( V4l2ReaderPlugin& effect );
+
+    void setup( const OFX::RenderArguments& args );
+
+    void multiThreadProcessImages( const OfxRectI& procWindowRoW );
+
+private:
+    /**
+     * @brief Dequeue the most recent frame, decoding the compressed formats
+     */
+    V4l2FramePtr readFrame();
+};
+
+}
+}
+}
+
+#include "V4l2ReaderProcess.tcc"
+
+#endif
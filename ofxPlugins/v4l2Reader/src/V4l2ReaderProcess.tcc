@@ -0,0 +1,148 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#include "V4l2ReaderAlgorithm.hpp"
+#include "V4l2ReaderPlugin.hpp"
+#include "MjpegDecoder.hpp"
+
+#include <boost/gil/gil_all.hpp>
+
+#include <algorithm>
+
+namespace tuttle {
+namespace plugin {
+namespace v4l2Reader {
+
+template<class View>
+V4l2ReaderProcess<View>::V4l2ReaderProcess( V4l2ReaderPlugin &instance )
+: ImageGilProcessor<View>( instance, eImageOrientationFromTopToBottom )
+, _plugin( instance )
+{
+}
+
+template<class View>
+void V4l2ReaderProcess<View>::setup( const OFX::RenderArguments& args )
+{
+    ImageGilProcessor<View>::setup( args );
+    _params = _plugin.getProcessParams( args.time );
+    // Rendered again for the same time: the exposed frame, not a newer one
+    _frame = _plugin.renderedFrame( args.time );
+    if ( !_frame )
+    {
+        _frame = readFrame();
+        _plugin.setRenderedFrame( args.time, _frame );
+    }
+    _format = _frame->format;
+}
+
+template<class View>
+V4l2FramePtr V4l2ReaderProcess<View>::readFrame()
+{
+    V4l2FramePtr frame( new V4l2Frame() );
+    frame->format = _params.device->format();
+    frame->buffer = _params.device->dequeueLatest( kCaptureTimeout );
+    if ( !frame->buffer )
+    {
+        BOOST_THROW_EXCEPTION( exception::Failed()
+            << exception::user() + "Camera capture timeout." );
+    }
+    _plugin.notifyFrame( *frame->buffer );
+
+    if ( frame->format.pixelFormat == V4L2_PIX_FMT_MJPEG )
+    {
+        unsigned int width = 0;
+        unsigned int height = 0;
+        if ( !decodeMjpeg( frame->buffer->data, frame->buffer->bytesUsed, frame->decoded, width, height ) ||
+             width != frame->format.width || height != frame->format.height )
+        {
+            BOOST_THROW_EXCEPTION( exception::Failed()
+                << exception::user() + "Unable to decode the MJPEG frame." );
+        }
+        // The driver buffer is not needed anymore
+        frame->buffer.reset();
+    }
+    return frame;
+}
+
+/**
+ * @brief Function called by rendering thread each time a process must be done.
+ * @param[in] procWindowRoW  Processing window
+ */
+template<class View>
+void V4l2ReaderProcess<View>::multiThreadProcessImages( const OfxRectI& procWindowRoW )
+{
+    using namespace boost::gil;
+    const OfxRectI procWindowOutput = this->translateRoWToOutputClipCoordinates( procWindowRoW );
+    const int x1 = procWindowOutput.x1;
+    const int x2 = std::min<int>( procWindowOutput.x2, _format.width );
+    const int y2 = std::min<int>( procWindowOutput.y2, _format.height );
+    if ( x2 <= x1 )
+    {
+        return;
+    }
+    const std::size_t width = _format.width;
+
+    if ( _format.pixelFormat == V4L2_PIX_FMT_MJPEG )
+    {
+        rgb8c_view_t src = interleaved_view( _format.width, _format.height, reinterpret_cast<const rgb8_pixel_t*>( _frame->decoded.data() ), 3 * _format.width );
+        for( int y = procWindowOutput.y1; y < y2; ++y )
+        {
+            copy_and_convert_pixels( subimage_view( src, x1, y, x2 - x1, 1 ),
+                                     subimage_view( this->_dstView, x1, y, x2 - x1, 1 ) );
+            if( this->progressForward( x2 - x1 ) )
+                return;
+        }
+        return;
+    }
+
+    // Rows are converted to float rgb, then to the output pixel type
+    std::vector<float> row( 3 * width );
+    rgb32fc_view_t rowView = interleaved_view( width, 1, reinterpret_cast<const rgb32f_pixel_t*>( &row[0] ), 3 * width * sizeof( float ) );
+    terry::color::BayerPattern pattern;
+    int bits = 0;
+    const bool bayer = bayerFormat( _format.pixelFormat, pattern, bits );
+    // Each thread has its own demosaic scratch rows
+    terry::color::BayerDemosaic demosaic( pattern, _params.demosaic, bayer ? 1.0f / ( ( 1 << bits ) - 1 ) : 1.0f );
+
+    for( int y = procWindowOutput.y1; y < y2; ++y )
+    {
+        const unsigned char* src = _frame->buffer->data + y * _format.bytesPerLine;
+        if ( _format.pixelFormat == V4L2_PIX_FMT_YUYV )
+        {
+            yuyvRowToRgb( src, &row[0], width );
+        }
+        else if ( bayer )
+        {
+            std::ptrdiff_t above, below;
+            terry::color::bayerNeighbourRows( y, _format.height, above, below );
+            const unsigned char* srcAbove = _frame->buffer->data + above * _format.bytesPerLine;
+            const unsigned char* srcBelow = _frame->buffer->data + below * _format.bytesPerLine;
+            if ( bits == 8 )
+            {
+                demosaic( srcAbove, src, srcBelow, &row[0], width, y );
+            }
+            else
+            {
+                demosaic( reinterpret_cast<const std::uint16_t*>( srcAbove ),
+                          reinterpret_cast<const std::uint16_t*>( src ),
+                          reinterpret_cast<const std::uint16_t*>( srcBelow ),
+                          &row[0], width, y );
+            }
+        }
+        else
+        {
+            BOOST_THROW_EXCEPTION( exception::Unsupported()
+                << exception::user() + "Unsupported pixel format: " + fourccToString( _format.pixelFormat ) );
+        }
+        copy_and_convert_pixels( subimage_view( rowView, x1, 0, x2 - x1, 1 ),
+                                 subimage_view( this->_dstView, x1, y, x2 - x1, 1 ) );
+        if( this->progressForward( x2 - x1 ) )
+            return;
+    }
+}
+
+}
+}
+}
@@ -0,0 +1,172 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#define BOOST_TEST_MODULE kalisync_gpio_watcher
+#include <boost/test/included/unit_test.hpp>
+
+#include <GpioWatcher.hpp>
+
+#include <mvp-player-core/Settings.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+static const std::size_t kPin = 17;
+
+/**
+ * @brief fake sysfs gpio directory with one input pin
+ */
+struct FakeSysfs
+{
+    FakeSysfs()
+    : path( boost::filesystem::temp_directory_path() / boost::filesystem::unique_path( "kalisync-gpio-%%%%-%%%%" ) )
+    {
+        boost::filesystem::create_directories( pinPath() );
+        write( "export", "" );
+        write( "unexport", "" );
+        write( pinFile( "direction" ), "out" );
+        write( pinFile( "edge" ), "none" );
+        write( pinFile( "value" ), "1" );
+        mvpplayer::Settings::getInstance().set( "gpio", "nextEventDelay", 0 );
+    }
+
+    ~FakeSysfs()
+    {
+        boost::filesystem::remove_all( path );
+    }
+
+    boost::filesystem::path pinPath() const
+    { return path / ( "gpio" + std::to_string( kPin ) ); }
+
+    std::string pinFile( const std::string & name ) const
+    { return ( boost::filesystem::path( "gpio" + std::to_string( kPin ) ) / name ).string(); }
+
+    void write( const std::string & name, const std::string & content ) const
+    {
+        std::ofstream file( ( path / name ).string().c_str() );
+        file << content;
+    }
+
+    std::string read( const std::string & name ) const
+    {
+        std::ifstream file( ( path / name ).string().c_str() );
+        std::string content;
+        std::getline( file, content );
+        return content;
+    }
+
+    boost::filesystem::path path;
+};
+
+/**
+ * @brief values signaled by a watcher
+ */
+struct Values
+{
+    explicit Values( kaliscope::GpioWatcher & watcher )
+    {
+        watcher.signalGpioValueChanged.connect(
+            [this]( const std::size_t, const bool value )
+            {
+                std::unique_lock<std::mutex> lock( mutex );
+                values.push_back( value );
+                changed.notify_all();
+            }
+        );
+    }
+
+    /**
+     * @brief wait for n values to be signaled
+     * @return false on timeout
+     */
+    bool waitFor( const std::size_t n )
+    {
+        std::unique_lock<std::mutex> lock( mutex );
+        return changed.wait_for( lock, std::chrono::seconds( 2 ), [this, n]() { return values.size() >= n; } );
+    }
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::vector<bool> values;
+};
+
+std::size_t nbOpenFiles()
+{
+    std::size_t n = 0;
+    for( boost::filesystem::directory_iterator it( "/proc/self/fd" ), end; it != end; ++it )
+    {
+        ++n;
+    }
+    return n;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( kalisync_gpio_watcher )
+
+BOOST_AUTO_TEST_CASE( edge_triggered_watcher_wakes_up_on_stop )
+{
+    FakeSysfs sysfs;
+    kaliscope::GpioWatcher watcher( kPin, -1, sysfs.path.string() );
+    Values values( watcher );
+
+    watcher.startWatching();
+    // The initial value is signaled, inputs are pulled up: "1" is released
+    BOOST_REQUIRE( values.waitFor( 1 ) );
+    BOOST_CHECK_EQUAL( values.values[0], false );
+    BOOST_CHECK_EQUAL( sysfs.read( "export" ), std::to_string( kPin ) );
+    BOOST_CHECK_EQUAL( sysfs.read( sysfs.pinFile( "direction" ) ), "in" );
+
+    // Starting again while watching leaks nothing
+    const std::size_t nbFiles = nbOpenFiles();
+    watcher.startWatching();
+    watcher.startWatching();
+    BOOST_CHECK_EQUAL( nbOpenFiles(), nbFiles );
+
+    // A regular file never reports an edge: only stop() can wake the watcher up
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    watcher.stop();
+    BOOST_CHECK( std::chrono::steady_clock::now() - start < std::chrono::seconds( 1 ) );
+    // Written by the watcher once the initial value is signaled
+    BOOST_CHECK_EQUAL( sysfs.read( sysfs.pinFile( "edge" ) ), "both" );
+    BOOST_CHECK_EQUAL( sysfs.read( "unexport" ), std::to_string( kPin ) );
+    BOOST_CHECK_EQUAL( values.values.size(), 1 );
+}
+
+BOOST_AUTO_TEST_CASE( watcher_polls_pins_without_edge_detection )
+{
+    FakeSysfs sysfs;
+    // The edge file can't be written
+    boost::filesystem::remove( sysfs.pinPath() / "edge" );
+    boost::filesystem::create_directory( sysfs.pinPath() / "edge" );
+
+    kaliscope::GpioWatcher watcher( kPin, -1, sysfs.path.string() );
+    Values values( watcher );
+
+    watcher.startWatching( 1000 );
+    BOOST_REQUIRE( values.waitFor( 1 ) );
+    BOOST_CHECK_EQUAL( values.values[0], false );
+
+    // Pressed, then released
+    sysfs.write( sysfs.pinFile( "value" ), "0" );
+    BOOST_REQUIRE( values.waitFor( 2 ) );
+    BOOST_CHECK_EQUAL( values.values[1], true );
+    sysfs.write( sysfs.pinFile( "value" ), "1" );
+    BOOST_REQUIRE( values.waitFor( 3 ) );
+    BOOST_CHECK_EQUAL( values.values[2], false );
+
+    watcher.stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,169 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <projector/TinyDisplayProjector.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+static const std::size_t kWidth = 16;
+static const std::size_t kHeight = 8;
+
+/**
+ * @brief plain file used as a fake framebuffer
+ */
+struct FakeFramebuffer
+{
+    FakeFramebuffer()
+    : path( boost::filesystem::temp_directory_path() / boost::filesystem::unique_path( "kalisync-fb-%%%%-%%%%" ) )
+    {
+        std::ofstream file( path.string().c_str() );
+    }
+
+    ~FakeFramebuffer()
+    {
+        boost::filesystem::remove( path );
+    }
+
+    /**
+     * @brief pixels written in the file
+     */
+    std::vector<std::uint16_t> pixels() const
+    {
+        std::ifstream file( path.string().c_str(), std::ios::binary );
+        const std::vector<char> bytes( ( std::istreambuf_iterator<char>( file ) ), std::istreambuf_iterator<char>() );
+        std::vector<std::uint16_t> words( bytes.size() / sizeof( std::uint16_t ) );
+        if ( !words.empty() )
+        {
+            std::copy( bytes.begin(), bytes.begin() + words.size() * sizeof( std::uint16_t ), reinterpret_cast<char*>( &words[0] ) );
+        }
+        return words;
+    }
+
+    /**
+     * @brief is the whole display filled with a color
+     */
+    bool isUniform( const std::uint16_t color ) const
+    {
+        const std::vector<std::uint16_t> words = pixels();
+        if ( words.size() != kWidth * kHeight )
+        {
+            return false;
+        }
+        for( std::size_t i = 0; i < words.size(); ++i )
+        {
+            if ( words[i] != color )
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    boost::filesystem::path path;
+};
+
+const std::uint16_t kWhite = kaliscope::TinyDisplayProjector::rgb565( 255, 255, 255 );
+const std::uint16_t kBlack = kaliscope::TinyDisplayProjector::rgb565( 0, 0, 0 );
+
+}
+
+BOOST_AUTO_TEST_SUITE( kalisync_tiny_display_projector )
+
+BOOST_AUTO_TEST_CASE( fake_framebuffer_shows_colors_and_images )
+{
+    FakeFramebuffer fb;
+    kaliscope::TinyDisplayProjector projector( fb.path.string(), kWidth, kHeight );
+    BOOST_REQUIRE( projector.isOpen() );
+    BOOST_CHECK( !projector.isDoubleBuffered() );
+    BOOST_CHECK_EQUAL( projector.width(), kWidth );
+    BOOST_CHECK_EQUAL( projector.height(), kHeight );
+
+    projector.switchOn();
+    BOOST_CHECK( fb.isUniform( kWhite ) );
+    projector.switchOff();
+    BOOST_CHECK( fb.isUniform( kBlack ) );
+    projector.projectColor( 255, 0, 0 );
+    BOOST_CHECK( fb.isUniform( kaliscope::TinyDisplayProjector::rgb565( 255, 0, 0 ) ) );
+
+    // 2x1 image: left half green, right half blue
+    const unsigned char rgb[] = { 0, 255, 0, 0, 0, 255 };
+    projector.projectImage( rgb, 2, 1 );
+    const std::vector<std::uint16_t> words = fb.pixels();
+    BOOST_REQUIRE_EQUAL( words.size(), kWidth * kHeight );
+    BOOST_CHECK_EQUAL( words[0], kaliscope::TinyDisplayProjector::rgb565( 0, 255, 0 ) );
+    BOOST_CHECK_EQUAL( words[kWidth - 1], kaliscope::TinyDisplayProjector::rgb565( 0, 0, 255 ) );
+    BOOST_CHECK_EQUAL( words[( kHeight - 1 ) * kWidth], kaliscope::TinyDisplayProjector::rgb565( 0, 255, 0 ) );
+
+    // The page holds an image: the colors are drawn again
+    projector.switchOn();
+    BOOST_CHECK( fb.isUniform( kWhite ) );
+}
+
+BOOST_AUTO_TEST_CASE( missing_device_leaves_projector_closed )
+{
+    kaliscope::TinyDisplayProjector projector( ( boost::filesystem::temp_directory_path() / "kalisync-missing" / "fb" ).string() );
+    BOOST_CHECK( !projector.isOpen() );
+    // Nothing to draw in
+    projector.switchOn();
+    projector.switchOff();
+}
+
+/**
+ * GPIO, server and sync link threads all drive the projector: the page cache
+ * must always match the display, or a later color is skipped
+ */
+BOOST_AUTO_TEST_CASE( concurrent_switches_keep_the_page_cache_right )
+{
+    FakeFramebuffer fb;
+    kaliscope::TinyDisplayProjector projector( fb.path.string(), kWidth, kHeight );
+    BOOST_REQUIRE( projector.isOpen() );
+
+    const std::size_t nbSwitches = 2000;
+    std::thread gpio( [&projector, nbSwitches]()
+    {
+        for( std::size_t i = 0; i < nbSwitches; ++i )
+        { projector.switchOn(); }
+    } );
+    std::thread server( [&projector, nbSwitches]()
+    {
+        for( std::size_t i = 0; i < nbSwitches; ++i )
+        { projector.switchOff(); }
+    } );
+    std::thread calibration( [&projector, nbSwitches]()
+    {
+        const unsigned char rgb[] = { 255, 0, 0 };
+        for( std::size_t i = 0; i < nbSwitches; ++i )
+        {
+            if ( i % 2 )
+            { projector.projectColor( 0, 0, 255 ); }
+            else
+            { projector.projectImage( rgb, 1, 1 ); }
+        }
+    } );
+    gpio.join();
+    server.join();
+    calibration.join();
+
+    // The last color asked is shown, whatever was drawn before
+    projector.switchOff();
+    BOOST_CHECK( fb.isUniform( kBlack ) );
+    projector.switchOn();
+    BOOST_CHECK( fb.isUniform( kWhite ) );
+    projector.projectColor( 0, 0, 255 );
+    BOOST_CHECK( fb.isUniform( kaliscope::TinyDisplayProjector::rgb565( 0, 0, 255 ) ) );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
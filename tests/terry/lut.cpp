@@ -0,0 +1,218 @@
+#include <boost/test/unit_test.hpp>
+
+#include <terry/color/lut.hpp>
+#include <terry/color/lutReader.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+
+using namespace terry::color;
+
+namespace
+{
+
+static const ELutInterpolation kInterpolations[] = { eLutInterpolationTrilinear, eLutInterpolationTetrahedral };
+
+/// Affine lattice, both interpolations are exact on it
+void fillLinear( Lut3D& lut, const std::size_t size )
+{
+	lut.resize( size );
+	const float s = 1.0f / ( size - 1 );
+	for( std::size_t ib = 0; ib < size; ++ib )
+		for( std::size_t ig = 0; ig < size; ++ig )
+			for( std::size_t ir = 0; ir < size; ++ir )
+			{
+				const float r = ir * s, g = ig * s, b = ib * s;
+				lut.setValue( ir, ig, ib, 0.5f * r + 0.25f * g + 0.1f,
+				                          0.2f * r + 0.6f * b,
+				                          0.3f * g + 0.7f * b - 0.05f );
+			}
+}
+
+/**
+ * @brief lut file removed with the test
+ */
+struct LutFile
+{
+	LutFile( const std::string& extension, const std::string& content )
+	: path( boost::filesystem::temp_directory_path() / boost::filesystem::unique_path( "terry-lut-%%%%-%%%%" + extension ) )
+	{
+		std::ofstream out( path.string().c_str() );
+		out << content;
+	}
+
+	~LutFile()
+	{
+		boost::system::error_code ec;
+		boost::filesystem::remove( path, ec );
+	}
+
+	/// Apply the lut read from the file on a pixel
+	void check( const float r, const float g, const float b, const float er, const float eg, const float eb ) const
+	{
+		Lut3D lut;
+		BOOST_REQUIRE( readLut( path.string(), lut ) );
+		for( const ELutInterpolation interpolation: kInterpolations )
+		{
+			float rgb[3] = { r, g, b };
+			lut.apply( rgb, interpolation );
+			BOOST_CHECK_CLOSE_FRACTION( rgb[0] + 1.0f, er + 1.0f, 1e-3f );
+			BOOST_CHECK_CLOSE_FRACTION( rgb[1] + 1.0f, eg + 1.0f, 1e-3f );
+			BOOST_CHECK_CLOSE_FRACTION( rgb[2] + 1.0f, eb + 1.0f, 1e-3f );
+		}
+	}
+
+	boost::filesystem::path path;
+};
+
+}
+
+BOOST_AUTO_TEST_SUITE( terry_lut )
+
+BOOST_AUTO_TEST_CASE( identity_round_trip )
+{
+	Lut3D lut;
+	lut.resize( 17 );
+	for( std::size_t ib = 0; ib < 17; ++ib )
+		for( std::size_t ig = 0; ig < 17; ++ig )
+			for( std::size_t ir = 0; ir < 17; ++ir )
+				lut.setValue( ir, ig, ib, ir / 16.0f, ig / 16.0f, ib / 16.0f );
+
+	// One pixel per line, rgba: the alpha must be left untouched
+	std::vector<float> row;
+	for( int i = 0; i <= 20; ++i )
+	{
+		row.push_back( i / 20.0f );
+		row.push_back( ( i * 7 % 21 ) / 20.0f );
+		row.push_back( 1.0f - i / 20.0f );
+		row.push_back( 0.5f );
+	}
+	for( const ELutInterpolation interpolation: kInterpolations )
+	{
+		std::vector<float> graded( row );
+		lut.applyRow( &graded[0], graded.size() / 4, 4, interpolation );
+		for( std::size_t i = 0; i < row.size(); ++i )
+			BOOST_CHECK_SMALL( graded[i] - row[i], 1e-6f );
+	}
+}
+
+BOOST_AUTO_TEST_CASE( lattice_point )
+{
+	Lut3D lut;
+	lut.resize( 5 );
+	for( std::size_t ib = 0; ib < 5; ++ib )
+		for( std::size_t ig = 0; ig < 5; ++ig )
+			for( std::size_t ir = 0; ir < 5; ++ir )
+				lut.setValue( ir, ig, ib, ir * ir * 0.1f + ib, ig * 0.3f - ir, ib * ig * 0.01f );
+	// The node (3, 1, 2), then the upper corner of the lattice
+	for( const ELutInterpolation interpolation: kInterpolations )
+	{
+		float rgb[3] = { 0.75f, 0.25f, 0.5f };
+		lut.apply( rgb, interpolation );
+		BOOST_CHECK_CLOSE( rgb[0], 2.9f, 1e-4f );
+		BOOST_CHECK_CLOSE( rgb[1], -2.7f, 1e-4f );
+		BOOST_CHECK_CLOSE( rgb[2], 0.02f, 1e-4f );
+
+		float top[3] = { 1.0f, 1.0f, 1.0f };
+		lut.apply( top, interpolation );
+		BOOST_CHECK_CLOSE( top[0], 5.6f, 1e-4f );
+		BOOST_CHECK_CLOSE( top[1], -2.8f, 1e-4f );
+		BOOST_CHECK_CLOSE( top[2], 0.16f, 1e-4f );
+	}
+}
+
+BOOST_AUTO_TEST_CASE( tetrahedral_matches_trilinear_on_linear_lut )
+{
+	Lut3D lut;
+	fillLinear( lut, 9 );
+	// Points in each of the 6 tetrahedra of a cell, and on their borders
+	static const float kPoints[][3] = {
+		{ 0.30f, 0.20f, 0.10f }, { 0.30f, 0.10f, 0.20f }, { 0.20f, 0.10f, 0.30f },
+		{ 0.10f, 0.20f, 0.30f }, { 0.20f, 0.30f, 0.10f }, { 0.10f, 0.30f, 0.20f },
+		{ 0.40f, 0.40f, 0.40f }, { 0.61f, 0.61f, 0.05f }, { 0.99f, 0.02f, 0.53f } };
+	for( const float* p: kPoints )
+	{
+		float trilinear[3] = { p[0], p[1], p[2] };
+		float tetrahedral[3] = { p[0], p[1], p[2] };
+		lut.apply( trilinear, eLutInterpolationTrilinear );
+		lut.apply( tetrahedral, eLutInterpolationTetrahedral );
+		const float expected[3] = { 0.5f * p[0] + 0.25f * p[1] + 0.1f,
+		                            0.2f * p[0] + 0.6f * p[2],
+		                            0.3f * p[1] + 0.7f * p[2] - 0.05f };
+		for( int c = 0; c < 3; ++c )
+		{
+			BOOST_CHECK_SMALL( trilinear[c] - expected[c], 1e-5f );
+			BOOST_CHECK_SMALL( tetrahedral[c] - trilinear[c], 1e-5f );
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE( read_cube_3d )
+{
+	// Red fastest, the domain is [0, 2]
+	const LutFile file( ".cube",
+		"TITLE \"swap\"\n"
+		"# red and blue swapped\n"
+		"LUT_3D_SIZE 2\n"
+		"DOMAIN_MIN 0 0 0\n"
+		"DOMAIN_MAX 2 2 2\n"
+		"0 0 0\n0 0 1\n0 1 0\n0 1 1\n"
+		"1 0 0\n1 0 1\n1 1 0\n1 1 1\n" );
+	file.check( 2.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f );
+	file.check( 0.5f, 1.0f, 1.5f, 0.75f, 0.5f, 0.25f );
+}
+
+BOOST_AUTO_TEST_CASE( read_cube_1d )
+{
+	const LutFile file( ".cube",
+		"LUT_1D_SIZE 3\n"
+		"0 0 0\n0.25 0.5 0.1\n1 1 1\n" );
+	file.check( 0.5f, 0.5f, 0.5f, 0.25f, 0.5f, 0.1f );
+	file.check( 0.75f, 0.25f, 1.0f, 0.625f, 0.25f, 1.0f );
+}
+
+BOOST_AUTO_TEST_CASE( read_cube_1d_3d )
+{
+	// The shaper maps [0, 4] to the 3D input range [0, 2], the lattice doubles its input
+	const LutFile file( ".cube",
+		"LUT_1D_SIZE 2\n"
+		"LUT_1D_INPUT_RANGE 0 4\n"
+		"LUT_3D_SIZE 2\n"
+		"LUT_3D_INPUT_RANGE 0 2\n"
+		"0 0 0\n2 2 2\n"
+		"0 0 0\n2 0 0\n0 2 0\n2 2 0\n"
+		"0 0 2\n2 0 2\n0 2 2\n2 2 2\n" );
+	file.check( 1.0f, 2.0f, 4.0f, 0.5f, 1.0f, 2.0f );
+}
+
+BOOST_AUTO_TEST_CASE( read_3dl_uniform )
+{
+	// 10 bits input mesh, 12 bits output, blue fastest
+	std::string content = "0 512 1023\n";
+	for( int ir = 0; ir < 3; ++ir )
+		for( int ig = 0; ig < 3; ++ig )
+			for( int ib = 0; ib < 3; ++ib )
+				content += std::to_string( ir * 4095 / 2 ) + " " + std::to_string( ig * 4095 / 2 ) + " " + std::to_string( ib * 4095 / 2 ) + "\n";
+	const LutFile file( ".3dl", content );
+	file.check( 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f );
+	file.check( 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f );
+	file.check( 0.5f, 0.25f, 0.75f, 0.5f, 0.25f, 0.75f );
+}
+
+BOOST_AUTO_TEST_CASE( read_3dl_non_uniform )
+{
+	// The nodes are the mesh values: the lut is the identity through the shaper
+	static const int kMesh[] = { 0, 128, 1023 };
+	std::string content = "0 128 1023\n";
+	for( int ir = 0; ir < 3; ++ir )
+		for( int ig = 0; ig < 3; ++ig )
+			for( int ib = 0; ib < 3; ++ib )
+				content += std::to_string( kMesh[ir] ) + " " + std::to_string( kMesh[ig] ) + " " + std::to_string( kMesh[ib] ) + "\n";
+	const LutFile file( ".3dl", content );
+	file.check( 64.0f / 1023.0f, 0.5f, 0.9f, 64.0f / 1023.0f, 0.5f, 0.9f );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,43 @@
+#define BOOST_TEST_MODULE terry
+#include <boost/test/included/unit_test.hpp>
+
+#include <terry/simd.hpp>
+
+#include <cstddef>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE( terry_simd )
+
+BOOST_AUTO_TEST_CASE( deinterleave4_interleave4_round_trip )
+{
+	// Sizes around the 4 pixels of the SIMD loops, to go thru the scalar tail
+	for( std::size_t n = 0; n <= 13; ++n )
+	{
+		std::vector<float> rgba( 4 * n );
+		for( std::size_t i = 0; i < rgba.size(); ++i )
+			rgba[i] = static_cast<float>( i ) + 0.5f;
+
+		// One guard value after each plane
+		std::vector<float> planeBuffer( 4 * ( n + 1 ), -1.0f );
+		float* planes[4];
+		for( std::size_t c = 0; c < 4; ++c )
+			planes[c] = &planeBuffer[c * ( n + 1 )];
+
+		terry::simd::deinterleave4( rgba.empty() ? NULL : &rgba[0], planes, n );
+		for( std::size_t c = 0; c < 4; ++c )
+		{
+			for( std::size_t i = 0; i < n; ++i )
+				BOOST_CHECK_EQUAL( planes[c][i], rgba[4 * i + c] );
+			BOOST_CHECK_EQUAL( planes[c][n], -1.0f );
+		}
+
+		std::vector<float> merged( 4 * n + 1, -1.0f );
+		const float* const* constPlanes = planes;
+		terry::simd::interleave4( constPlanes, &merged[0], n );
+		for( std::size_t i = 0; i < rgba.size(); ++i )
+			BOOST_CHECK_EQUAL( merged[i], rgba[i] );
+		BOOST_CHECK_EQUAL( merged[4 * n], -1.0f );
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
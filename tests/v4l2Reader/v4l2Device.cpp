@@ -0,0 +1,150 @@
+/* Copyright (C) 2015 Eloi DU BOIS - All Rights Reserved
+ * The license for this file is available here:
+ * https://github.com/edubois/kaliscope/blob/master/LICENSE
+ */
+
+#define BOOST_TEST_MODULE v4l2Reader
+#include <boost/test/included/unit_test.hpp>
+
+#include <V4l2Device.hpp>
+#include <V4l2ReaderAlgorithm.hpp>
+#include <V4l2ReaderDefinitions.hpp>
+
+#include <tuttle/plugin/exceptions.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace tuttle::plugin::v4l2Reader;
+
+namespace
+{
+
+/**
+ * @brief device to stream from, a vivid one for instance ("modprobe vivid"),
+ *        empty to skip the tests needing a device
+ */
+std::string testDevice()
+{
+    const char* device = std::getenv( "KALISCOPE_V4L2_TEST_DEVICE" );
+    return device ? device : "";
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( v4l2_reader )
+
+BOOST_AUTO_TEST_CASE( yuyv_to_rgb )
+{
+    // Black, white, then a gray with chroma, on both the 4 and 2 pixels paths
+    for( std::size_t width = 2; width <= 10; width += 2 )
+    {
+        std::vector<unsigned char> yuyv( 2 * width );
+        for( std::size_t x = 0; x < width; x += 2 )
+        {
+            const unsigned char y = ( x % 4 == 0 ) ? 16 : 235;
+            yuyv[2 * x] = y;
+            yuyv[2 * x + 1] = 128;
+            yuyv[2 * x + 2] = y;
+            yuyv[2 * x + 3] = 128;
+        }
+        std::vector<float> rgb( 3 * width, -1.0f );
+        yuyvRowToRgb( &yuyv[0], &rgb[0], width );
+        for( std::size_t x = 0; x < width; ++x )
+        {
+            const float expected = ( x % 4 < 2 ) ? 0.0f : 1.0f;
+            for( int c = 0; c < 3; ++c )
+            {
+                BOOST_CHECK_SMALL( rgb[3 * x + c] - expected, 2e-3f );
+            }
+        }
+    }
+
+    // Red and blue chroma: the SIMD and scalar paths give the same pixels
+    const unsigned char macro[] = { 120, 90, 140, 200 };
+    std::vector<unsigned char> yuyv;
+    for( int i = 0; i < 3; ++i )
+    {
+        yuyv.insert( yuyv.end(), macro, macro + 4 );
+    }
+    std::vector<float> rgb( 3 * 6 );
+    yuyvRowToRgb( &yuyv[0], &rgb[0], 6 );
+    for( int c = 0; c < 3; ++c )
+    {
+        BOOST_CHECK_SMALL( rgb[c] - rgb[12 + c], 1e-5f );
+        BOOST_CHECK_SMALL( rgb[3 + c] - rgb[15 + c], 1e-5f );
+    }
+    BOOST_CHECK_GT( rgb[0], rgb[2] );
+}
+
+BOOST_AUTO_TEST_CASE( bayer_formats )
+{
+    terry::color::BayerPattern pattern;
+    int bits = 0;
+    BOOST_CHECK( bayerFormat( V4L2_PIX_FMT_SGRBG10, pattern, bits ) );
+    BOOST_CHECK_EQUAL( pattern.redX, 1 );
+    BOOST_CHECK_EQUAL( pattern.redY, 0 );
+    BOOST_CHECK_EQUAL( bits, 10 );
+    BOOST_CHECK( bayerFormat( V4L2_PIX_FMT_SBGGR16, pattern, bits ) );
+    BOOST_CHECK_EQUAL( pattern.redX, 1 );
+    BOOST_CHECK_EQUAL( pattern.redY, 1 );
+    BOOST_CHECK_EQUAL( bits, 16 );
+    BOOST_CHECK( !bayerFormat( V4L2_PIX_FMT_YUYV, pattern, bits ) );
+    BOOST_CHECK_EQUAL( fourccToString( V4L2_PIX_FMT_MJPEG ), "MJPG" );
+}
+
+BOOST_AUTO_TEST_CASE( not_a_device )
+{
+    // A plain file opens, but is not a V4L2 device
+    const boost::filesystem::path path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path( "kaliscope-v4l2-%%%%-%%%%" );
+    std::ofstream( path.string().c_str() ) << "not a camera";
+    V4l2Device device;
+    BOOST_CHECK_THROW( device.open( path.string() ), tuttle::plugin::exception::File );
+    BOOST_CHECK( !device.isOpen() );
+    BOOST_CHECK_THROW( device.open( ( path / "missing" ).string() ), tuttle::plugin::exception::File );
+    boost::filesystem::remove( path );
+}
+
+BOOST_AUTO_TEST_CASE( stream_from_device )
+{
+    const std::string path = testDevice();
+    if ( path.empty() )
+    {
+        BOOST_TEST_MESSAGE( "KALISCOPE_V4L2_TEST_DEVICE is not set, no device to stream from" );
+        return;
+    }
+    V4l2Device device;
+    device.open( path );
+    std::vector<std::uint32_t> formats( 1, V4L2_PIX_FMT_YUYV );
+    const V4l2Format & format = device.setFormat( 640, 480, formats );
+    BOOST_REQUIRE_EQUAL( format.pixelFormat, V4L2_PIX_FMT_YUYV );
+    BOOST_CHECK_GE( format.bytesPerLine, 2 * format.width );
+    device.startStreaming( 4 );
+
+    // Frames come in capture order, each one newer than the previous
+    V4l2Device::BufferPtr previous;
+    for( int i = 0; i < 5; ++i )
+    {
+        V4l2Device::BufferPtr buffer = device.dequeueLatest( kCaptureTimeout );
+        BOOST_REQUIRE( buffer );
+        BOOST_CHECK_GE( buffer->bytesUsed, format.bytesPerLine * format.height );
+        if ( previous )
+        {
+            BOOST_CHECK_GT( buffer->sequence, previous->sequence );
+        }
+        // Holding a buffer doesn't stop the others from being filled
+        previous = buffer;
+    }
+
+    // Stopping waits for the held buffer: give it back first
+    previous.reset();
+    device.stopStreaming();
+    BOOST_CHECK( !device.isStreaming() );
+    device.close();
+}
+
+BOOST_AUTO_TEST_SUITE_END()